@@ -1,17 +1,51 @@
 #include "AnimNode_DrawPhysicsAsset.h"
+#include "KawaiiPhysics.h"
 #include "Animation/AnimInstanceProxy.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "Components/LineBatchComponent.h"
 #include "ReferenceSkeleton.h"
 #include "DrawDebugHelpers.h"
 
+DECLARE_CYCLE_STAT(TEXT("Draw Physics Asset"), STAT_KawaiiPhysics_DrawPhysicsAsset, STATGROUP_KawaiiPhysics);
+
 void FAnimNode_DrawPhysicsAsset::OnInitializeAnimInstance(const FAnimInstanceProxy* InProxy, const UAnimInstance* InAnimInstance)
+{
+	UpdatePhysicsAsset(InAnimInstance);
+}
+
+void FAnimNode_DrawPhysicsAsset::PreUpdate(const UAnimInstance* InAnimInstance)
+{
+	UpdatePhysicsAsset(InAnimInstance);
+}
+
+void FAnimNode_DrawPhysicsAsset::UpdatePhysicsAsset(const UAnimInstance* InAnimInstance)
 {
 	// FAnimNode_RigidBody::OnInitializeAnimInstance()QlɂĂ
+	// The physics asset of the component and the pin of OverridePhysicsAsset may change at any time
 	const USkeletalMeshComponent* SkeletalMeshComp = InAnimInstance->GetSkelMeshComponent();
-	const USkeletalMesh* SkeletalMeshAsset = SkeletalMeshComp->SkeletalMesh;
-
-	const FReferenceSkeleton& SkelMeshRefSkel = SkeletalMeshAsset->RefSkeleton;
 	UsePhysicsAsset = OverridePhysicsAsset ? OverridePhysicsAsset : SkeletalMeshComp->GetPhysicsAsset();
+	DrawWorld = SkeletalMeshComp->GetWorld();
+}
+
+void FAnimNode_DrawPhysicsAsset::InitializeBoneReferences(const FBoneContainer& RequiredBones)
+{
+	// Called when the mesh or the LOD changes
+	InitializeBodyBoneIndices(RequiredBones);
+}
+
+void FAnimNode_DrawPhysicsAsset::InitializeBodyBoneIndices(const FBoneContainer& RequiredBones)
+{
+	// Bone of each body. Looked up by name only when the physics asset or the required bones change
+	BodyBoneIndices.Reset();
+	BodyBoneIndicesPhysicsAsset = UsePhysicsAsset;
+	if (UsePhysicsAsset != nullptr)
+	{
+		for (const USkeletalBodySetup* BodySetup : UsePhysicsAsset->SkeletalBodySetups)
+		{
+			const int32 MeshBoneIndex = BodySetup ? RequiredBones.GetPoseBoneIndexForBoneName(BodySetup->BoneName) : INDEX_NONE;
+			BodyBoneIndices.Add(MeshBoneIndex != INDEX_NONE ? RequiredBones.MakeCompactPoseIndex(FMeshPoseBoneIndex(MeshBoneIndex)) : FCompactPoseBoneIndex(INDEX_NONE));
+		}
+	}
 }
 
 bool FAnimNode_DrawPhysicsAsset::IsValidToEvaluate(const class USkeleton* Skeleton, const struct FBoneContainer& RequiredBones)
@@ -21,57 +55,106 @@ bool FAnimNode_DrawPhysicsAsset::IsValidToEvaluate(const class USkeleton* Skelet
 
 namespace
 {
-	// UPhysicsAssetEditorSkeletalMeshComponent::GetPrimitiveTransform()QlɂĂ
-	FTransform GetPrimitiveTransform(UBodySetup* SharedBodySetup, FTransform& BoneTM, int32 BodyIndex, EAggCollisionShape::Type PrimType, int32 PrimIndex, float Scale)
+	// UPhysicsAssetEditorSkeletalMeshComponent::GetPrimitiveColor()ElemSelectedColor̐FfobKŒl𒲂ׂ
+	const FColor ElemSelectedColor = FColor(222, 163, 9);
+
+	/** Shape to draw in world space. Size is radius in X for spheres, half extent for boxes, radius in X and length in Z for capsules and radii in X, Y and length in Z for tapered capsules */
+	struct FDrawPhysicsAssetShape
+	{
+		EAggCollisionShape::Type Type;
+		FTransform Transform;
+		FVector Size;
+	};
+
+	FTransform GetElemTransform(const FKShapeElem& Elem, const FTransform& BoneTM, float Scale)
+	{
+		// UPhysicsAssetEditorSkeletalMeshComponent::GetPrimitiveTransform()QlɂĂ
+		FTransform ElemTM = Elem.GetTransform();
+		ElemTM.ScaleTranslation(FVector(Scale));
+		return ElemTM * BoneTM;
+	}
+
+	void DrawShape(UWorld* World, const FDrawPhysicsAssetShape& Shape)
 	{
-		FVector Scale3D(Scale);
+		const bool bPersistent = false;
+		const float LifeTime = 0.0f;
+		const FVector Location = Shape.Transform.GetLocation();
 
-		if (PrimType == EAggCollisionShape::Sphere)
+		switch (Shape.Type)
 		{
-			FTransform PrimTM = SharedBodySetup->AggGeom.SphereElems[PrimIndex].GetTransform();
-			PrimTM.ScaleTranslation(Scale3D);
-			return PrimTM * BoneTM;
-		}
-		else if (PrimType == EAggCollisionShape::Box)
+		case EAggCollisionShape::Sphere:
+			::DrawDebugSphere(World, Location, Shape.Size.X, 16, ElemSelectedColor, bPersistent, LifeTime, ESceneDepthPriorityGroup::SDPG_Foreground);
+			break;
+		case EAggCollisionShape::Box:
+			::DrawDebugBox(World, Location, Shape.Size, Shape.Transform.GetRotation(), ElemSelectedColor, bPersistent, LifeTime, ESceneDepthPriorityGroup::SDPG_Foreground);
+			break;
+		case EAggCollisionShape::Sphyl:
+			::DrawDebugCapsule(World, Location, Shape.Size.Z, Shape.Size.X, Shape.Transform.GetRotation(), ElemSelectedColor, bPersistent, LifeTime, ESceneDepthPriorityGroup::SDPG_Foreground);
+			break;
+		case EAggCollisionShape::TaperedCapsule:
 		{
-			FTransform PrimTM = SharedBodySetup->AggGeom.BoxElems[PrimIndex].GetTransform();
-			PrimTM.ScaleTranslation(Scale3D);
-			return PrimTM * BoneTM;
+			// Same segment as the collision of KawaiiPhysics. Radius0 is at +Z
+			const FVector HalfSegment = Shape.Transform.GetUnitAxis(EAxis::Z) * Shape.Size.Z * 0.5f;
+			const FVector StartPoint = Location + HalfSegment;
+			const FVector EndPoint = Location - HalfSegment;
+			::DrawDebugSphere(World, StartPoint, Shape.Size.X, 16, ElemSelectedColor, bPersistent, LifeTime, ESceneDepthPriorityGroup::SDPG_Foreground);
+			::DrawDebugSphere(World, EndPoint, Shape.Size.Y, 16, ElemSelectedColor, bPersistent, LifeTime, ESceneDepthPriorityGroup::SDPG_Foreground);
+			for (const EAxis::Type Axis : { EAxis::X, EAxis::Y })
+			{
+				const FVector Side = Shape.Transform.GetUnitAxis(Axis);
+				::DrawDebugLine(World, StartPoint + Side * Shape.Size.X, EndPoint + Side * Shape.Size.Y, ElemSelectedColor, bPersistent, LifeTime, ESceneDepthPriorityGroup::SDPG_Foreground);
+				::DrawDebugLine(World, StartPoint - Side * Shape.Size.X, EndPoint - Side * Shape.Size.Y, ElemSelectedColor, bPersistent, LifeTime, ESceneDepthPriorityGroup::SDPG_Foreground);
+			}
+			break;
 		}
-		else if (PrimType == EAggCollisionShape::Sphyl)
-		{
-			FTransform PrimTM = SharedBodySetup->AggGeom.SphylElems[PrimIndex].GetTransform();
-			PrimTM.ScaleTranslation(Scale3D);
-			return PrimTM * BoneTM;
+		default:
+			break;
 		}
-		else if (PrimType == EAggCollisionShape::Convex)
+	}
+
+	void AddConvexLines(const FKConvexElem& Convex, const FTransform& ElemTM, float Scale, TArray<FBatchedLine>& OutLines)
+	{
+		auto AddLine = [&OutLines](const FVector& Start, const FVector& End)
 		{
-			FTransform PrimTM = SharedBodySetup->AggGeom.ConvexElems[PrimIndex].GetTransform();
-			PrimTM.ScaleTranslation(Scale3D);
-			return PrimTM * BoneTM;
-		}
-		else if (PrimType == EAggCollisionShape::TaperedCapsule)
+			OutLines.Add(FBatchedLine(Start, End, ElemSelectedColor, 0.0f, 0.0f, ESceneDepthPriorityGroup::SDPG_Foreground));
+		};
+
+		// Edges of the triangles. Shared edges are drawn twice, which is fine for debug drawing
+		const TArray<FVector>& Vertices = Convex.VertexData;
+		const TArray<int32>& Indices = Convex.IndexData;
+		for (int32 i = 0; i + 2 < Indices.Num(); i += 3)
 		{
-			FTransform PrimTM = SharedBodySetup->AggGeom.TaperedCapsuleElems[PrimIndex].GetTransform();
-			PrimTM.ScaleTranslation(Scale3D);
-			return PrimTM * BoneTM;
-		}
+			if (!Vertices.IsValidIndex(Indices[i]) || !Vertices.IsValidIndex(Indices[i + 1]) || !Vertices.IsValidIndex(Indices[i + 2]))
+			{
+				continue;
+			}
 
-		// Should never reach here
-		check(0);
-		return FTransform::Identity;
+			const FVector V0 = ElemTM.TransformPosition(Vertices[Indices[i]] * Scale);
+			const FVector V1 = ElemTM.TransformPosition(Vertices[Indices[i + 1]] * Scale);
+			const FVector V2 = ElemTM.TransformPosition(Vertices[Indices[i + 2]] * Scale);
+			AddLine(V0, V1);
+			AddLine(V1, V2);
+			AddLine(V2, V0);
+		}
 	}
 }
 
 void FAnimNode_DrawPhysicsAsset::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms)
 {
-	const USkeletalMeshComponent* SkeletalMeshComp = Output.AnimInstanceProxy->GetSkelMeshComponent();
-	UWorld* World = GEngine->GetWorldFromContextObject(SkeletalMeshComp, EGetWorldErrorMode::LogAndReturnNull);
+	SCOPE_CYCLE_COUNTER(STAT_KawaiiPhysics_DrawPhysicsAsset);
 
-	// UPhysicsAssetEditorSkeletalMeshComponent::GetPrimitiveColor()ElemSelectedColor̐FfobKŒl𒲂ׂ
-	const FColor ElemSelectedColor = FColor(222, 163, 9);
+	if (BodyBoneIndicesPhysicsAsset != UsePhysicsAsset || BodyBoneIndices.Num() != UsePhysicsAsset->SkeletalBodySetups.Num())
+	{
+		InitializeBodyBoneIndices(Output.Pose.GetPose().GetBoneContainer());
+	}
+
+	// Bones are read from the pose, so nothing of the component is touched on the worker thread
+	const FTransform& ComponentTransform = Output.AnimInstanceProxy->GetComponentTransform();
 
 	// UPhysicsAssetEditorSkeletalMeshComponent::RenderAssetTools()QlɂĂ
+	// Shapes of all bodies are collected and drawn in one game thread task per frame
+	TArray<FDrawPhysicsAssetShape> Shapes;
+	TArray<FBatchedLine> Lines;
 
 	// Draw bodies
 	for (int32 i = 0; i <UsePhysicsAsset->SkeletalBodySetups.Num(); ++i)
@@ -80,96 +163,68 @@ void FAnimNode_DrawPhysicsAsset::EvaluateSkeletalControl_AnyThread(FComponentSpa
 		{
 			continue;
 		}
-		int32 BoneIndex = SkeletalMeshComp->GetBoneIndex(UsePhysicsAsset->SkeletalBodySetups[i]->BoneName);
+		const FCompactPoseBoneIndex BoneIndex = BodyBoneIndices[i];
 
 		// If we found a bone for it, draw the collision.
-		// The logic is as follows; always render in the ViewMode requested when not in hit mode - but if we are in hit mode and the right editing mode, render as solid
-		if (BoneIndex != INDEX_NONE)
+		if (BoneIndex.IsValid())
 		{
-			FTransform BoneTM = SkeletalMeshComp->GetBoneTransform(BoneIndex);
+			FTransform BoneTM = Output.Pose.GetComponentSpaceTransform(BoneIndex) * ComponentTransform;
 			float Scale = BoneTM.GetScale3D().GetAbsMax();
-			FVector VectorScale(Scale);
 			BoneTM.RemoveScaling();
 
-			FKAggregateGeom* AggGeom = &UsePhysicsAsset->SkeletalBodySetups[i]->AggGeom;
+			const FKAggregateGeom& AggGeom = UsePhysicsAsset->SkeletalBodySetups[i]->AggGeom;
 
-			for (int32 j = 0; j <AggGeom->SphereElems.Num(); ++j)
+			for (const FKSphereElem& Sphere : AggGeom.SphereElems)
 			{
-				FTransform ElemTM = AggGeom->SphereElems[j].GetTransform();
-				ElemTM.ScaleTranslation(VectorScale);
-				ElemTM *= BoneTM;
-
-				FFunctionGraphTask::CreateAndDispatchWhenReady(
-					[World, ElemTM, AggGeom, j, Scale, ElemSelectedColor]() {
-						bool bPersistent = false;
-						float LifeTime = 0.0f;
-						const FColor& ShapeColor = FColor::Blue;
-
-						::DrawDebugSphere(World, ElemTM.GetLocation(), AggGeom->SphereElems[j].Radius * Scale, 16, ElemSelectedColor, bPersistent, LifeTime, ESceneDepthPriorityGroup::SDPG_Foreground);
-					},
-					TStatId(), nullptr, ENamedThreads::GameThread
-				);
+				Shapes.Add({ EAggCollisionShape::Sphere, GetElemTransform(Sphere, BoneTM, Scale), FVector(Sphere.Radius * Scale) });
 			}
 
-			for (int32 j = 0; j <AggGeom->BoxElems.Num(); ++j)
+			for (const FKBoxElem& Box : AggGeom.BoxElems)
 			{
-				FTransform ElemTM = AggGeom->BoxElems[j].GetTransform();
-				ElemTM.ScaleTranslation(VectorScale);
-				ElemTM *= BoneTM;
-
-				FFunctionGraphTask::CreateAndDispatchWhenReady(
-					[World, ElemTM, AggGeom, j, Scale, ElemSelectedColor]() {
-						bool bPersistent = false;
-						float LifeTime = 0.0f;
-
-						::DrawDebugBox(World, ElemTM.GetLocation(), Scale * 0.5f * FVector(AggGeom->BoxElems[j].X, AggGeom->BoxElems[j].Y, AggGeom->BoxElems[j].Z), ElemTM.GetRotation(), ElemSelectedColor, bPersistent, LifeTime, ESceneDepthPriorityGroup::SDPG_Foreground);
-					},
-					TStatId(), nullptr, ENamedThreads::GameThread
-				);
+				Shapes.Add({ EAggCollisionShape::Box, GetElemTransform(Box, BoneTM, Scale), Scale * 0.5f * FVector(Box.X, Box.Y, Box.Z) });
 			}
 
-			for (int32 j = 0; j <AggGeom->SphylElems.Num(); ++j)
+			for (const FKSphylElem& Sphyl : AggGeom.SphylElems)
 			{
-				FTransform ElemTM = AggGeom->SphylElems[j].GetTransform();
-				ElemTM.ScaleTranslation(VectorScale);
-				ElemTM *= BoneTM;
-
-				FFunctionGraphTask::CreateAndDispatchWhenReady(
-					[World, ElemTM, AggGeom, j, Scale, ElemSelectedColor]() {
-						bool bPersistent = false;
-						float LifeTime = 0.0f;
-						const FColor& ShapeColor = FColor::Blue;
-
-						::DrawDebugCapsule(World, ElemTM.GetLocation(), AggGeom->SphylElems[j].Length * Scale, AggGeom->SphylElems[j].Radius * Scale, ElemTM.GetRotation(), ElemSelectedColor, bPersistent, LifeTime, ESceneDepthPriorityGroup::SDPG_Foreground);
-					},
-					TStatId(), nullptr, ENamedThreads::GameThread
-				);
+				Shapes.Add({ EAggCollisionShape::Sphyl, GetElemTransform(Sphyl, BoneTM, Scale), FVector(Sphyl.Radius, 0.0f, Sphyl.Length) * Scale });
 			}
 
-			for (int32 j = 0; j <AggGeom->ConvexElems.Num(); ++j)
+			for (const FKConvexElem& Convex : AggGeom.ConvexElems)
 			{
-				FTransform ElemTM = AggGeom->ConvexElems[j].GetTransform();
-				ElemTM.ScaleTranslation(VectorScale);
-				ElemTM *= BoneTM;
-
-#if 0 // TODO:Ƃ肠ȗ
-				//convex doesn't have solid draw so render lines if we're in hitTestAndBodyMode
-				AggGeom->ConvexElems[j].DrawElemWire(PDI, ElemTM, Scale, ElemSelectedColor);
-#endif
+				AddConvexLines(Convex, GetElemTransform(Convex, BoneTM, Scale), Scale, Lines);
 			}
 
-			for (int32 j = 0; j <AggGeom->TaperedCapsuleElems.Num(); ++j)
+			for (const FKTaperedCapsuleElem& TaperedCapsule : AggGeom.TaperedCapsuleElems)
 			{
-				FTransform ElemTM = AggGeom->TaperedCapsuleElems[j].GetTransform();
-				ElemTM.ScaleTranslation(VectorScale);
-				ElemTM *= BoneTM;
-
-#if 0 // TODO:Ƃ肠ȗ
-				AggGeom->TaperedCapsuleElems[j].DrawElemSolid(PDI, ElemTM, VectorScale, ElemSelectedMaterial->GetRenderProxy());
-				AggGeom->TaperedCapsuleElems[j].DrawElemWire(PDI, ElemTM, VectorScale, ElemSelectedColor);
-#endif
+				Shapes.Add({ EAggCollisionShape::TaperedCapsule, GetElemTransform(TaperedCapsule, BoneTM, Scale),
+					FVector(TaperedCapsule.Radius0, TaperedCapsule.Radius1, TaperedCapsule.Length) * Scale });
 			}
 		}
 	}
-}
 
+	if (Shapes.Num() == 0 && Lines.Num() == 0)
+	{
+		return;
+	}
+
+	FFunctionGraphTask::CreateAndDispatchWhenReady(
+		[World = DrawWorld, Shapes = MoveTemp(Shapes), Lines = MoveTemp(Lines)]() {
+			UWorld* DrawWorldPtr = World.Get();
+			if (DrawWorldPtr == nullptr)
+			{
+				return;
+			}
+
+			for (const FDrawPhysicsAssetShape& Shape : Shapes)
+			{
+				DrawShape(DrawWorldPtr, Shape);
+			}
+
+			if (Lines.Num() > 0 && DrawWorldPtr->ForegroundLineBatcher != nullptr)
+			{
+				DrawWorldPtr->ForegroundLineBatcher->DrawLines(Lines);
+			}
+		},
+		TStatId(), nullptr, ENamedThreads::GameThread
+	);
+}
@@ -2,36 +2,258 @@
 
 #include "KawaiiPhysics.h"
 #include "AnimationRuntime.h"
+#include "Animation/AnimInstance.h"
 #include "Animation/AnimInstanceProxy.h"
 #include "Curves/CurveFloat.h"
 #include "KawaiiPhysicsLimitsDataAsset.h"
+#include "KawaiiPhysicsSDFDataAsset.h"
+#include "KawaiiPhysicsSolver.h"
+#include "KawaiiPhysicsBudget.h"
+#include "KawaiiPhysicsCapture.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Misc/ScopeExit.h"
+#include "GameFramework/Actor.h"
+#include "Misc/Paths.h"
+#include "Algo/Transform.h"
 
 TAutoConsoleVariable<int32> CVarEnableOldPhysicsMethodGrayity(TEXT("p.KawaiiPhysics.EnableOldPhysicsMethodGravity"), 0, 
 	TEXT("Enables/Disables old physics method for gravity before v1.3.1. This is the setting for the transition period when changing the physical calculation."));
 TAutoConsoleVariable<int32> CVarEnableOldPhysicsMethodSphereLimit(TEXT("p.KawaiiPhysics.EnableOldPhysicsMethodSphereLimit"), 0,
 	TEXT("Enables/Disables old physics method for sphere limit before v1.3.1. This is the setting for the transition period when changing the physical calculation."));
+TAutoConsoleVariable<int32> CVarDeterministic(TEXT("p.KawaiiPhysics.Deterministic"), 0,
+	TEXT("Enables/Disables determinism mode. Wind gusts use a fixed seed per node and the frame budget is ignored so that identical inputs give bit-identical outputs."));
+
+#if STATS || CSV_PROFILER
+TAutoConsoleVariable<int32> CVarPhaseTiming(TEXT("p.KawaiiPhysics.PhaseTiming"), 0,
+	TEXT("Enables/Disables the timing of Integrate, Collide and Constraints phases in the bone loop. Costs a few cycle reads per bone."));
+#endif
+
+#if !UE_BUILD_SHIPPING
+TAutoConsoleVariable<FString> CVarCaptureDirectory(TEXT("p.KawaiiPhysics.CaptureDirectory"), TEXT(""),
+	TEXT("Directory to capture the inputs of every KawaiiPhysics node for offline replay. One file per node. Empty stops capturing."));
+#endif
+
+namespace
+{
+	// Radius0 is at the +Z end and Radius1 is at the -Z end
+	void GetTaperedCapsuleSegment(const FKTaperedCapsuleElem& Capsule, const FTransform& ElemTM, FVector& OutStartPoint, FVector& OutEndPoint)
+	{
+		const FVector HalfSegment = ElemTM.GetUnitAxis(EAxis::Z) * Capsule.Length * 0.5f;
+		OutStartPoint = ElemTM.GetLocation() + HalfSegment;
+		OutEndPoint = ElemTM.GetLocation() - HalfSegment;
+	}
+
+	/**
+	 * Where a bone can be in the space of Root. The first bone of its chain below Root is at ChildLength from Root within
+	 * ChildLimitAngle of ChildDirection, and the bone is within RemainingLength from it
+	 */
+	struct FBoneReach
+	{
+		float ChildLength = 0.0f;
+		FVector ChildDirection = FVector::ForwardVector;
+		float ChildLimitAngle = PI;
+		float RemainingLength = 0.0f;
+	};
+
+	/** Where a limit can be relative to Root, and the distance from its center within which bones collide */
+	struct FLimitReach
+	{
+		int32 CollisionGroup = -1;
+		/** Limits without a driving bone are in component space, which the animation moves Root in. Never culled */
+		bool bAnalyzed = false;
+		/** Only limits driven by Root have a fixed Center in the space of Root */
+		bool bFixedToRoot = false;
+		FVector Center = FVector::ZeroVector;
+		/** The bones between Root and the driving bone are rotated by the animation, so only the range of the distance is known */
+		float MinDistance = 0.0f;
+		float MaxDistance = 0.0f;
+		float Extent = 0.0f;
+		/** Bones collide outside of Extent */
+		bool bInner = false;
+		/** Bones collide behind the plane through Center. Analyzed only if fixed to Root */
+		bool bPlane = false;
+		FVector PlaneNormal = FVector::UpVector;
+	};
+
+	/** Distance from Point to the points at Radius from the origin within HalfAngle of Axis */
+	float CalcDistanceToSphericalCap(const FVector& Point, float Radius, const FVector& Axis, float HalfAngle)
+	{
+		const float PointDistance = Point.Size();
+		const float Angle = PointDistance > KINDA_SMALL_NUMBER ? FMath::Acos(FMath::Clamp(FVector::DotProduct(Point / PointDistance, Axis), -1.0f, 1.0f)) : 0.0f;
+		const float AngleToCap = FMath::Max(Angle - HalfAngle, 0.0f);
+
+		// The nearest point is on the edge of the cap in the plane of Axis and Point, if not within the cap
+		return FMath::Sqrt(FMath::Max(PointDistance * PointDistance + Radius * Radius - 2.0f * PointDistance * Radius * FMath::Cos(AngleToCap), 0.0f));
+	}
+
+	bool IsLimitUnreachable(const FBoneReach& Bone, float BoneRadius, const FLimitReach& Limit)
+	{
+		if (!Limit.bAnalyzed)
+		{
+			return false;
+		}
+
+		if (Limit.bPlane)
+		{
+			// Lowest height of the bone above the plane
+			const float NormalAngle = FMath::Acos(FMath::Clamp(FVector::DotProduct(Limit.PlaneNormal, Bone.ChildDirection), -1.0f, 1.0f));
+			const float MinHeight = -FVector::DotProduct(Limit.PlaneNormal, Limit.Center) +
+				Bone.ChildLength * FMath::Cos(FMath::Min(NormalAngle + Bone.ChildLimitAngle, PI)) - Bone.RemainingLength;
+			return MinHeight > BoneRadius;
+		}
+
+		if (Limit.bInner)
+		{
+			const float MaxDistance = Limit.MaxDistance + Bone.ChildLength + Bone.RemainingLength;
+			return MaxDistance + BoneRadius < Limit.Extent;
+		}
+
+		float MinDistance;
+		if (Limit.bFixedToRoot)
+		{
+			MinDistance = CalcDistanceToSphericalCap(Limit.Center, Bone.ChildLength, Bone.ChildDirection, Bone.ChildLimitAngle) - Bone.RemainingLength;
+		}
+		else
+		{
+			// The bone is between ChildLength -/+ RemainingLength from Root
+			MinDistance = FMath::Max(Limit.MinDistance - (Bone.ChildLength + Bone.RemainingLength), (Bone.ChildLength - Bone.RemainingLength) - Limit.MaxDistance);
+		}
+		return MinDistance > Limit.Extent + BoneRadius;
+	}
+
+	// Clamped to the instances because the editor may change the data asset before the node applies it
+	template<typename LimitType>
+	TArrayView<const LimitType> GetLimitsDataView(const TArray<LimitType>* Limits, int32 NumInstances)
+	{
+		return Limits ? MakeArrayView(Limits->GetData(), FMath::Min(Limits->Num(), NumInstances)) : TArrayView<const LimitType>();
+	}
+
+	// Driving bones of shared limits are resolved without touching the limits.
+	// Skeleton bone indices cooked into the data asset skip the lookup by name
+	FCompactPoseBoneIndex InitializeDrivingBone(const FBoneReference& DrivingBone, const int32* SkeletonBoneIndex, const FBoneContainer& RequiredBones)
+	{
+		if (SkeletonBoneIndex)
+		{
+			return RequiredBones.GetSkeletonToPoseBoneIndexArray().IsValidIndex(*SkeletonBoneIndex) ?
+				RequiredBones.GetCompactPoseIndexFromSkeletonIndex(*SkeletonBoneIndex) : FCompactPoseBoneIndex(INDEX_NONE);
+		}
+
+		FBoneReference BoneReference = DrivingBone;
+		BoneReference.Initialize(RequiredBones);
+		return BoneReference.BoneIndex >= 0 ? BoneReference.GetCompactPoseIndex(RequiredBones) : FCompactPoseBoneIndex(INDEX_NONE);
+	}
+
+	template<typename LimitType>
+	void InitializeLimitInstancesDrivingBone(TArrayView<const LimitType> Limits, TArrayView<const int32> SkeletonBoneIndices,
+		FKawaiiPhysicsLimitInstance* Instances, const FBoneContainer& RequiredBones)
+	{
+		for (int32 i = 0; i < Limits.Num(); ++i)
+		{
+			const int32* SkeletonBoneIndex = SkeletonBoneIndices.IsValidIndex(i) ? &SkeletonBoneIndices[i] : nullptr;
+			Instances[i].DrivingBoneIndex = InitializeDrivingBone(Limits[i].DrivingBone, SkeletonBoneIndex, RequiredBones);
+		}
+	}
+
+	template<typename LimitType>
+	void AddDrivenLimits(const TArray<LimitType>& Limits, ECollisionLimitType Type, const FBoneContainer& BoneContainer, TArray<FKawaiiPhysicsDrivenLimit>& OutDrivenLimits)
+	{
+		for (int32 i = 0; i < Limits.Num(); ++i)
+		{
+			const LimitType& Limit = Limits[i];
+			FKawaiiPhysicsDrivenLimit& DrivenLimit = OutDrivenLimits.AddDefaulted_GetRef();
+			DrivenLimit.Offset = FTransform(Limit.OffsetRotation, Limit.OffsetLocation);
+			if (Limit.DrivingBone.BoneIndex >= 0)
+			{
+				DrivenLimit.DrivingBoneIndex = Limit.DrivingBone.GetCompactPoseIndex(BoneContainer);
+			}
+			DrivenLimit.Type = Type;
+			DrivenLimit.Index = i;
+		}
+	}
+
+	// Offsets are read from the cooked limits. Converted from the limits if the cooked ones are out of date
+	template<typename LimitType>
+	void AddDrivenLimitsData(TArrayView<const LimitType> Limits, ECollisionLimitType Type, TArrayView<const FKawaiiPhysicsCookedLimit> CookedLimits,
+		const FKawaiiPhysicsLimitInstance* Instances, TArray<FKawaiiPhysicsDrivenLimit>& OutDrivenLimits)
+	{
+		const bool bCooked = CookedLimits.Num() >= Limits.Num();
+		for (int32 i = 0; i < Limits.Num(); ++i)
+		{
+			const LimitType& Limit = Limits[i];
+			FKawaiiPhysicsDrivenLimit& DrivenLimit = OutDrivenLimits.AddDefaulted_GetRef();
+			DrivenLimit.Offset = bCooked ? FTransform(CookedLimits[i].OffsetRotation, CookedLimits[i].OffsetLocation) :
+				FTransform(Limit.OffsetRotation, Limit.OffsetLocation);
+			DrivenLimit.DrivingBoneIndex = Instances[i].DrivingBoneIndex;
+			DrivenLimit.Type = Type;
+			DrivenLimit.Index = i;
+			DrivenLimit.bFromDataAsset = true;
+		}
+	}
+
+	// Limits of a data asset combined with the state of a node. For the debug drawing and captures
+	template<typename LimitType>
+	void CopyLimitsData(TArrayView<const LimitType> Limits, const FKawaiiPhysicsLimitInstance* Instances, TArray<LimitType>& OutLimits)
+	{
+		OutLimits.Reset(Limits.Num());
+		for (int32 i = 0; i < Limits.Num(); ++i)
+		{
+			LimitType& Limit = OutLimits.Add_GetRef(Limits[i]);
+			Limit.Location = Instances[i].Location;
+			Limit.Rotation = Instances[i].Rotation;
+		}
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+namespace
+{
+	// Live nodes for KawaiiPhysics.Dump. Registered on initialization and removed on destruction.
+	// Allocated once and never freed so that nodes destroyed at exit don't touch a destroyed registry
+	FCriticalSection& GetDebugNodesCritical()
+	{
+		static FCriticalSection* Critical = new FCriticalSection();
+		return *Critical;
+	}
+
+	TSet<FAnimNode_KawaiiPhysics*>& GetDebugNodes()
+	{
+		static TSet<FAnimNode_KawaiiPhysics*>* Nodes = new TSet<FAnimNode_KawaiiPhysics*>();
+		return *Nodes;
+	}
+}
+
+static FAutoConsoleCommandWithOutputDevice GKawaiiPhysicsDumpCommand(
+	TEXT("KawaiiPhysics.Dump"),
+	TEXT("Lists every live KawaiiPhysics node with its owner, bones, colliders and average/peak evaluation time"),
+	FConsoleCommandWithOutputDeviceDelegate::CreateStatic(&FAnimNode_KawaiiPhysics::DumpAllDebugCosts));
+#endif
 
 FAnimNode_KawaiiPhysics::FAnimNode_KawaiiPhysics()
 {
 
 }
 
+FAnimNode_KawaiiPhysics::~FAnimNode_KawaiiPhysics()
+{
+	WaitForAsyncSimulation();
+
+	FKawaiiPhysicsBudget::Get().Unregister(this);
+
+#if !UE_BUILD_SHIPPING
+	FScopeLock Lock(&GetDebugNodesCritical());
+	GetDebugNodes().Remove(this);
+#endif
+}
+
 void FAnimNode_KawaiiPhysics::Initialize_AnyThread(const FAnimationInitializeContext& Context)
 {
+	WaitForAsyncSimulation();
+
 	FAnimNode_SkeletalControlBase::Initialize_AnyThread(Context);
 	FBoneContainer& RequiredBones = Context.AnimInstanceProxy->GetRequiredBones();
 
 	ApplyLimitsDataAsset(RequiredBones);
 
-	if (bUsePhysicsAssetAsLimits)
-	{
-		const USkeletalMeshComponent* SkeletalMeshComp = Context.AnimInstanceProxy->GetSkelMeshComponent();
-		const USkeletalMesh* SkeletalMeshAsset = SkeletalMeshComp->SkeletalMesh;
-
-		const FReferenceSkeleton& SkelMeshRefSkel = SkeletalMeshAsset->RefSkeleton;
-		UsePhysicsAssetAsLimits = OverridePhysicsAssetAsLimits ? OverridePhysicsAssetAsLimits : SkeletalMeshComp->GetPhysicsAsset();
-	}
-
 	InitializeBoneReferences(RequiredBones);
 
 	ModifyBones.Empty();
@@ -39,14 +261,49 @@ void FAnimNode_KawaiiPhysics::Initialize_AnyThread(const FAnimationInitializeCon
 	// For Avoiding Zero Divide in the first frame
 	DeltaTimeOld = 1.0f / TargetFramerate;
 
+	// Fixed seed in determinism mode. Otherwise vary gusts between nodes
+	WindRandomStream.Initialize(IsDeterministic() ?
+		(int32)(FCrc::StrCrc32(*RootBone.BoneName.ToString()) ^ (uint32)WindRandomSeed) :
+		(int32)(FPlatformTime::Cycles() ^ PointerHash(this)));
+
+	BudgetTier = EKawaiiPhysicsSimulationTier::Full;
+	BudgetAccumulatedDeltaTime = 0.0f;
+	BudgetSkippedFrames = 0;
+	BudgetPhaseSlot = INDEX_NONE;
+
+#if !UE_BUILD_SHIPPING
+	DebugCostNumSamples = 0;
+	DebugCostNextSample = 0;
+	{
+		FScopeLock Lock(&GetDebugNodesCritical());
+		GetDebugNodes().Add(this);
+	}
+#endif
+}
+
+void FAnimNode_KawaiiPhysics::OnInitializeAnimInstance(const FAnimInstanceProxy* InProxy, const UAnimInstance* InAnimInstance)
+{
 #if WITH_EDITOR
-	auto World = Context.AnimInstanceProxy->GetSkelMeshComponent()->GetWorld();
-	if (World->WorldType == EWorldType::Editor ||
-		World->WorldType == EWorldType::EditorPreview)
+	const UWorld* World = InAnimInstance->GetWorld();
+	if (World && (World->WorldType == EWorldType::Editor ||
+		World->WorldType == EWorldType::EditorPreview))
 	{
 		bEditing = true;
 	}
 #endif
+
+#if !UE_BUILD_SHIPPING
+	DebugSkelMeshComp = InAnimInstance->GetSkelMeshComponent();
+	DebugAnimInstance = InAnimInstance;
+#endif
+
+	UpdateInputSnapshot(InAnimInstance->GetSkelMeshComponent());
+}
+
+void FAnimNode_KawaiiPhysics::PreUpdate(const UAnimInstance* InAnimInstance)
+{
+	WaitForAsyncSimulation();
+	UpdateInputSnapshot(InAnimInstance->GetSkelMeshComponent());
 }
 
 void FAnimNode_KawaiiPhysics::CacheBones_AnyThread(const FAnimationCacheBonesContext& Context)
@@ -59,14 +316,109 @@ void FAnimNode_KawaiiPhysics::UpdateInternal(const FAnimationUpdateContext& Cont
 {
 	FAnimNode_SkeletalControlBase::UpdateInternal(Context);
 
+	WaitForAsyncSimulation();
 	DeltaTime = Context.GetDeltaTime();
 }
 
-DECLARE_CYCLE_STAT(TEXT("KawaiiPhysics_Eval"), STAT_KawaiiPhysics_Eval, STATGROUP_Anim);
+DECLARE_CYCLE_STAT(TEXT("Eval"), STAT_KawaiiPhysics_Eval, STATGROUP_KawaiiPhysics);
+DECLARE_CYCLE_STAT(TEXT("Settings"), STAT_KawaiiPhysics_Settings, STATGROUP_KawaiiPhysics);
+DECLARE_CYCLE_STAT(TEXT("Limit Update"), STAT_KawaiiPhysics_LimitUpdate, STATGROUP_KawaiiPhysics);
+DECLARE_CYCLE_STAT(TEXT("Simulate"), STAT_KawaiiPhysics_Simulate, STATGROUP_KawaiiPhysics);
+DECLARE_CYCLE_STAT(TEXT("Apply"), STAT_KawaiiPhysics_Apply, STATGROUP_KawaiiPhysics);
+DECLARE_CYCLE_STAT(TEXT("Input Snapshot"), STAT_KawaiiPhysics_InputSnapshot, STATGROUP_KawaiiPhysics);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Simulate - Integrate (ms)"), STAT_KawaiiPhysics_Integrate, STATGROUP_KawaiiPhysics);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Simulate - Collide (ms)"), STAT_KawaiiPhysics_Collide, STATGROUP_KawaiiPhysics);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Simulate - Constraints (ms)"), STAT_KawaiiPhysics_Constraints, STATGROUP_KawaiiPhysics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bones Simulated"), STAT_KawaiiPhysics_BonesSimulated, STATGROUP_KawaiiPhysics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Collider Pairs Tested"), STAT_KawaiiPhysics_ColliderPairsTested, STATGROUP_KawaiiPhysics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Push Outs Applied"), STAT_KawaiiPhysics_PushOutsApplied, STATGROUP_KawaiiPhysics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Teleports Detected"), STAT_KawaiiPhysics_TeleportsDetected, STATGROUP_KawaiiPhysics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Nodes Skipped"), STAT_KawaiiPhysics_NodesSkipped, STATGROUP_KawaiiPhysics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Nodes Full Rate"), STAT_KawaiiPhysics_NodesFullRate, STATGROUP_KawaiiPhysics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Nodes Reduced Rate"), STAT_KawaiiPhysics_NodesReducedRate, STATGROUP_KawaiiPhysics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Nodes Frozen"), STAT_KawaiiPhysics_NodesFrozen, STATGROUP_KawaiiPhysics);
+
+CSV_DEFINE_CATEGORY(KawaiiPhysics, true);
+
+// Scope of a phase for stat, CSV profiler and Insights (cycle stats are forwarded to the CPU trace channel)
+#define KAWAIIPHYSICS_SCOPE_PHASE(Phase) \
+	SCOPE_CYCLE_COUNTER(STAT_KawaiiPhysics_##Phase); \
+	CSV_SCOPED_TIMING_STAT(KawaiiPhysics, Phase)
+
+#define KAWAIIPHYSICS_INC_COUNTER(Counter, Amount) \
+	INC_DWORD_STAT_BY(STAT_KawaiiPhysics_##Counter, Amount); \
+	CSV_CUSTOM_STAT(KawaiiPhysics, Counter, (int32)(Amount), ECsvCustomStatOp::Accumulate)
+
+#define KAWAIIPHYSICS_ADD_PHASE_CYCLES(Phase, Cycles) \
+	INC_FLOAT_STAT_BY(STAT_KawaiiPhysics_##Phase, FPlatformTime::ToMilliseconds(Cycles)); \
+	CSV_CUSTOM_STAT(KawaiiPhysics, Phase, FPlatformTime::ToMilliseconds(Cycles), ECsvCustomStatOp::Accumulate)
+
+// Accumulate cycles of a phase interleaved in the bone loop, reported once per node instead of a stat scope per bone.
+// Reading the cycles per bone isn't free, so only enabled by p.KawaiiPhysics.PhaseTiming
+struct FKawaiiPhysicsScopedPhaseCycles
+{
+#if STATS || CSV_PROFILER
+	static bool IsEnabled()
+	{
+		return CVarPhaseTiming.GetValueOnAnyThread() != 0;
+	}
+
+	FKawaiiPhysicsScopedPhaseCycles(uint32& InCycles, bool bInEnabled)
+		: Cycles(InCycles)
+		, StartCycles(bInEnabled ? FPlatformTime::Cycles() : 0)
+		, bEnabled(bInEnabled)
+	{
+	}
+
+	~FKawaiiPhysicsScopedPhaseCycles()
+	{
+		if (bEnabled)
+		{
+			Cycles += FPlatformTime::Cycles() - StartCycles;
+		}
+	}
+
+private:
+	uint32& Cycles;
+	uint32 StartCycles;
+	bool bEnabled;
+#else
+	static bool IsEnabled()
+	{
+		return false;
+	}
+
+	FKawaiiPhysicsScopedPhaseCycles(uint32& InCycles, bool bInEnabled)
+	{
+	}
+#endif
+};
 
 void FAnimNode_KawaiiPhysics::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms)
 {
-	SCOPE_CYCLE_COUNTER(STAT_KawaiiPhysics_Eval);
+	KAWAIIPHYSICS_SCOPE_PHASE(Eval);
+
+	WaitForAsyncSimulation();
+
+	// Cost of this evaluation for the frame budget and KawaiiPhysics.Dump. Async simulation is counted in the next frame
+	const uint32 CostStartCycles = FPlatformTime::Cycles();
+	const float AsyncCostMicroseconds = AsyncSimulationMicroseconds;
+	AsyncSimulationMicroseconds = 0.0f;
+	bool bSimulated = false;
+	ON_SCOPE_EXIT
+	{
+		const float CostMicroseconds = FPlatformTime::ToMilliseconds(FPlatformTime::Cycles() - CostStartCycles) * 1000.0f + AsyncCostMicroseconds;
+		BudgetTier = FKawaiiPhysicsBudget::Get().Report(this, BudgetSignificance, CostMicroseconds, bSimulated, BudgetPhaseSlot);
+#if !UE_BUILD_SHIPPING
+		AddDebugCostSample(CostMicroseconds);
+
+		// The async task publishes when it finishes
+		if (!AsyncSimulationTask.IsValid())
+		{
+			PublishDebugSnapshot();
+		}
+#endif
+	};
 
 	check(OutBoneTransforms.Num() == 0);
 
@@ -74,26 +426,19 @@ void FAnimNode_KawaiiPhysics::EvaluateSkeletalControl_AnyThread(FComponentSpaceP
 	FTransform ComponentTransform = Output.AnimInstanceProxy->GetComponentTransform();
 
 #if WITH_EDITOR
-	// sync editing on other Nodes
-	if (LimitsDataAsset)
-	{ 
-		ApplyLimitsDataAsset(BoneContainer);
-	}
-	if (bUsePhysicsAssetAsLimits)
-	{
-		const USkeletalMeshComponent* SkeletalMeshComp = Output.AnimInstanceProxy->GetSkelMeshComponent();
-		const USkeletalMesh* SkeletalMeshAsset = SkeletalMeshComp->SkeletalMesh;
-
-		const FReferenceSkeleton& SkelMeshRefSkel = SkeletalMeshAsset->RefSkeleton;
-		UsePhysicsAssetAsLimits = OverridePhysicsAssetAsLimits ? OverridePhysicsAssetAsLimits : SkeletalMeshComp->GetPhysicsAsset();
-	}
+	// Refresh only what the editor changed, including edits of the data asset on other nodes
+	ApplyEditorChanges(BoneContainer);
 #endif
 
 	if (!RootBone.IsValidToEvaluate(BoneContainer))
 	{
+		KAWAIIPHYSICS_INC_COUNTER(NodesSkipped, 1);
 		return;
 	}
 
+	BudgetSignificance = InputSnapshot.Significance;
+	bSimulated = ShouldSimulateInBudget();
+
 	if (ModifyBones.Num() == 0)
 	{
 		InitModifyBones(Output, BoneContainer);
@@ -104,20 +449,19 @@ void FAnimNode_KawaiiPhysics::EvaluateSkeletalControl_AnyThread(FComponentSpaceP
 	if (!bInitPhysicsSettings || bUpdatePhysicsSettingsInGame)
 	{
 		UpdatePhysicsSettingsOfModifyBones();
-		
-#if WITH_EDITORONLY_DATA
-		if (!bEditing)
-#endif
+		bInitPhysicsSettings = true;
+	}
+	if (bSimulated)
+	{
+		KAWAIIPHYSICS_SCOPE_PHASE(LimitUpdate);
+
+		UpdateLimitTransforms(Output, BoneContainer);
+		if (!bInitLimitsReachability)
 		{
-			bInitPhysicsSettings = true;
+			UpdateLimitsReachability(BoneContainer);
+			bInitLimitsReachability = true;
 		}
 	}
-	UpdateSphericalLimits(SphericalLimits, Output, BoneContainer, ComponentTransform);
-	UpdateSphericalLimits(SphericalLimitsData, Output, BoneContainer, ComponentTransform);
-	UpdateCapsuleLimits(CapsuleLimits, Output, BoneContainer, ComponentTransform);
-	UpdateCapsuleLimits(CapsuleLimitsData, Output, BoneContainer, ComponentTransform);
-	UpdatePlanerLimits(PlanarLimits,Output, BoneContainer, ComponentTransform);
-	UpdatePlanerLimits(PlanarLimitsData, Output, BoneContainer, ComponentTransform);
 	for (auto& Bone : ModifyBones)
 	{
 		if (!Bone.bDummy)
@@ -133,25 +477,111 @@ void FAnimNode_KawaiiPhysics::EvaluateSkeletalControl_AnyThread(FComponentSpaceP
 		}
 	}
 	
+	if (!bSimulated)
+	{
+		// Frozen nodes drop the movement. Reduced rate nodes take it in the next simulated frame
+		if (BudgetTier == EKawaiiPhysicsSimulationTier::Frozen)
+		{
+			PreSkelCompTransform = ComponentTransform;
+			FollowPoseWithoutSimulation();
+			ApplySimuateResult(Output, BoneContainer, OutBoneTransforms);
+		}
+		else
+		{
+			ApplyExtrapolatedResult(Output, BoneContainer, OutBoneTransforms, BudgetAccumulatedDeltaTime);
+		}
+		return;
+	}
+
+	// Read once here so that the simulation, which may run on another thread or in a replay, doesn't read the console variables
+	bOldPhysicsMethodGravity = CVarEnableOldPhysicsMethodGrayity.GetValueOnAnyThread() != 0;
+	bOldPhysicsMethodSphereLimit = CVarEnableOldPhysicsMethodSphereLimit.GetValueOnAnyThread() != 0;
+
+#if !UE_BUILD_SHIPPING
+	CaptureInput(ComponentTransform);
+#endif
+
+	UpdateSkelCompMove(ComponentTransform);
+
+	if (ShouldSimulateAsync())
+	{
+		// Apply the result of the last frame and simulate this frame while the rest of the graph is evaluated
+		ApplyExtrapolatedResult(Output, BoneContainer, OutBoneTransforms, bAsyncExtrapolation ? DeltaTime : 0.0f);
+		LaunchAsyncSimulation(ComponentTransform);
+		return;
+	}
+
+	// Simulate Physics and Apply
+	SimulateModifyBones(ComponentTransform);
+	ApplySimuateResult(Output, BoneContainer, OutBoneTransforms);
+}
 
+void FAnimNode_KawaiiPhysics::UpdateSkelCompMove(const FTransform& ComponentTransform)
+{
 	// Calc SkeletalMeshComponent movement in World Space
+	bool bTeleported = false;
 	SkelCompMoveVector = ComponentTransform.InverseTransformPosition(PreSkelCompTransform.GetLocation());
 	if (SkelCompMoveVector.SizeSquared() > TeleportDistanceThreshold * TeleportDistanceThreshold)
 	{
 		SkelCompMoveVector = FVector::ZeroVector;
+		bTeleported = true;
 	}
 
 	SkelCompMoveRotation = ComponentTransform.InverseTransformRotation(PreSkelCompTransform.GetRotation());
 	if ( TeleportRotationThreshold >= 0 && FMath::RadiansToDegrees( SkelCompMoveRotation.GetAngle() ) > TeleportRotationThreshold )
 	{
 		SkelCompMoveRotation = FQuat::Identity;
+		bTeleported = true;
+	}
+
+	if (bTeleported)
+	{
+		KAWAIIPHYSICS_INC_COUNTER(TeleportsDetected, 1);
 	}
 
 	PreSkelCompTransform = ComponentTransform;
+}
 
-	// Simulate Physics and Apply
-	SimulateModifyBones(Output, BoneContainer, ComponentTransform);
-	ApplySimuateResult(Output, BoneContainer, OutBoneTransforms);
+bool FAnimNode_KawaiiPhysics::ShouldSimulateAsync() const
+{
+#if WITH_EDITORONLY_DATA
+	// Edit mode draws the bones on the game thread
+	if (bEditing)
+	{
+		return false;
+	}
+#endif
+	return bAsyncSimulation;
+}
+
+void FAnimNode_KawaiiPhysics::LaunchAsyncSimulation(const FTransform& ComponentTransform)
+{
+	check(!AsyncSimulationTask.IsValid());
+
+	AsyncSimulationTask = FFunctionGraphTask::CreateAndDispatchWhenReady([this, ComponentTransform]()
+	{
+		const uint32 StartCycles = FPlatformTime::Cycles();
+		SimulateModifyBones(ComponentTransform);
+		AsyncSimulationMicroseconds = FPlatformTime::ToMilliseconds(FPlatformTime::Cycles() - StartCycles) * 1000.0f;
+#if !UE_BUILD_SHIPPING
+		PublishDebugSnapshot();
+#endif
+	}, TStatId(), nullptr, ENamedThreads::AnyHiPriThreadHiPriTask);
+}
+
+void FAnimNode_KawaiiPhysics::WaitForAsyncSimulation()
+{
+	if (AsyncSimulationTask.IsValid())
+	{
+		// Usually finished long ago. The task ran while the rest of the last frame was processed
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(AsyncSimulationTask);
+		AsyncSimulationTask.SafeRelease();
+	}
+}
+
+bool FAnimNode_KawaiiPhysics::IsDeterministic()
+{
+	return CVarDeterministic.GetValueOnAnyThread() != 0;
 }
 
 bool FAnimNode_KawaiiPhysics::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones)
@@ -180,10 +610,158 @@ void FAnimNode_KawaiiPhysics::InitializeBoneReferences(const FBoneContainer& Req
 	{
 		Planer.DrivingBone.Initialize(RequiredBones);
 	}
+	for (auto& SDF : SDFLimits)
+	{
+		SDF.DrivingBone.Initialize(RequiredBones);
+	}
 
+	InitializeLimitsDataBoneReferences(RequiredBones);
+	InitializeDrivenLimits(RequiredBones);
 }
 
-DECLARE_CYCLE_STAT(TEXT("KawaiiPhysics_InitModifyBones"), STAT_KawaiiPhysics_InitModifyBones, STATGROUP_Anim);
+void FAnimNode_KawaiiPhysics::UpdateInputSnapshot(const USkeletalMeshComponent* SkelMeshComp)
+{
+	KAWAIIPHYSICS_SCOPE_PHASE(InputSnapshot);
+
+	if (SkelMeshComp == nullptr)
+	{
+		return;
+	}
+
+	InputSnapshot.Significance = CalcBudgetSignificance(SkelMeshComp);
+
+	// Scales of physics asset shapes. Bones added in the first evaluation use 1 until the next frame
+	if (bUsePhysicsAssetAsShapes)
+	{
+		InputSnapshot.BoneScales.Init(1.0f, SkelMeshComp->GetNumBones());
+		for (const FKawaiiPhysicsModifyBone& Bone : ModifyBones)
+		{
+			if (InputSnapshot.BoneScales.IsValidIndex(Bone.BoneRef.BoneIndex))
+			{
+				InputSnapshot.BoneScales[Bone.BoneRef.BoneIndex] = SkelMeshComp->GetBoneTransform(Bone.BoneRef.BoneIndex, FTransform::Identity).GetScale3D().GetAbsMax();
+			}
+		}
+	}
+	else
+	{
+		InputSnapshot.BoneScales.Reset();
+	}
+
+	// Bodies of physics asset as limits in component space
+	if (bUsePhysicsAssetAsLimits)
+	{
+		UsePhysicsAssetAsLimits = OverridePhysicsAssetAsLimits ? OverridePhysicsAssetAsLimits : SkelMeshComp->GetPhysicsAsset();
+	}
+	if (bUsePhysicsAssetAsLimits && UsePhysicsAssetAsLimits)
+	{
+		if (InputSnapshot.LimitBodyBoneIndexCache.Update(UsePhysicsAssetAsLimits, SkelMeshComp))
+		{
+			InputSnapshot.LimitBodyBoneIndices = InputSnapshot.LimitBodyBoneIndexCache.GetBoneIndices();
+		}
+
+		InputSnapshot.LimitBodyTransforms.SetNumUninitialized(InputSnapshot.LimitBodyBoneIndices.Num());
+		for (int32 i = 0; i < InputSnapshot.LimitBodyBoneIndices.Num(); ++i)
+		{
+			const int32 BoneIndex = InputSnapshot.LimitBodyBoneIndices[i];
+			InputSnapshot.LimitBodyTransforms[i] = BoneIndex != INDEX_NONE ? SkelMeshComp->GetBoneTransform(BoneIndex, FTransform::Identity) : FTransform::Identity;
+		}
+	}
+	else
+	{
+		InputSnapshot.LimitBodyBoneIndices.Reset();
+		InputSnapshot.LimitBodyTransforms.Reset();
+		InputSnapshot.LimitBodyBoneIndexCache.Reset();
+	}
+
+	// Wind at the pose of the last evaluation. Gusts are added in the evaluation so that the random stream stays on one thread
+	InputSnapshot.WindVelocities.Reset();
+	const UWorld* World = SkelMeshComp->GetWorld();
+	if (bEnableWind && World && World->Scene)
+	{
+		const FTransform& ComponentTransform = SkelMeshComp->GetComponentTransform();
+		InputSnapshot.WindVelocities.SetNumUninitialized(ModifyBones.Num());
+		for (int32 i = 0; i < ModifyBones.Num(); ++i)
+		{
+			FVector WindDirection;
+			float WindSpeed;
+			float WindMinGust;
+			float WindMaxGust;
+			World->Scene->GetWindParameters_GameThread(ComponentTransform.TransformPosition(ModifyBones[i].PoseLocation), WindDirection, WindSpeed, WindMinGust, WindMaxGust);
+			InputSnapshot.WindVelocities[i] = ComponentTransform.Inverse().TransformVector(WindDirection) * WindSpeed;
+		}
+	}
+}
+
+float FAnimNode_KawaiiPhysics::CalcBudgetSignificance(const USkeletalMeshComponent* SkelMeshComp) const
+{
+	if (SkelMeshComp == nullptr)
+	{
+		return BudgetPriority;
+	}
+
+	// Detailed LOD means large on screen. Offscreen meshes are far behind visible ones
+	float Significance = BudgetPriority / (1.0f + SkelMeshComp->PredictedLODLevel);
+	if (!SkelMeshComp->WasRecentlyRendered())
+	{
+		Significance *= 0.01f;
+	}
+	return Significance;
+}
+
+bool FAnimNode_KawaiiPhysics::ShouldSimulateInBudget()
+{
+	// The tier is from the last report. Don't wait for it when the budget was disabled
+	if (!FKawaiiPhysicsBudget::IsEnabled())
+	{
+		BudgetTier = EKawaiiPhysicsSimulationTier::Full;
+	}
+
+	BudgetAccumulatedDeltaTime += DeltaTime;
+
+	switch (BudgetTier)
+	{
+	case EKawaiiPhysicsSimulationTier::Reduced:
+		KAWAIIPHYSICS_INC_COUNTER(NodesReducedRate, 1);
+		// Simulate in the phase slot to spread reduced rate nodes across frames. Also when the slot was missed
+		if (!FKawaiiPhysicsBudget::IsPhaseSlotFrame(BudgetPhaseSlot) && ++BudgetSkippedFrames < FKawaiiPhysicsBudget::GetReducedRateInterval())
+		{
+			return false;
+		}
+		break;
+	case EKawaiiPhysicsSimulationTier::Frozen:
+		KAWAIIPHYSICS_INC_COUNTER(NodesFrozen, 1);
+		BudgetAccumulatedDeltaTime = 0.0f;
+		BudgetSkippedFrames = 0;
+		return false;
+	default:
+		KAWAIIPHYSICS_INC_COUNTER(NodesFullRate, 1);
+		break;
+	}
+
+	// Simulate the time of skipped frames in one step
+	DeltaTime = BudgetAccumulatedDeltaTime;
+	BudgetAccumulatedDeltaTime = 0.0f;
+	BudgetSkippedFrames = 0;
+	return true;
+}
+
+void FAnimNode_KawaiiPhysics::FollowPoseWithoutSimulation()
+{
+	if (ModifyBones.Num() == 0)
+	{
+		return;
+	}
+
+	// Move the whole chain with the root keeping the last result. Rotation of the root is ignored
+	const FVector RootMoveVector = ModifyBones[0].PoseLocation - ModifyBones[0].Location;
+	for (auto& Bone : ModifyBones)
+	{
+		Bone.Location += RootMoveVector;
+		Bone.PrevLocation += RootMoveVector;
+	}
+}
+
+DECLARE_CYCLE_STAT(TEXT("Init Modify Bones"), STAT_KawaiiPhysics_InitModifyBones, STATGROUP_KawaiiPhysics);
 
 void FAnimNode_KawaiiPhysics::InitModifyBones(FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer)
 {
@@ -193,10 +771,12 @@ void FAnimNode_KawaiiPhysics::InitModifyBones(FComponentSpacePoseContext& Output
 	auto& RefSkeleton = Skeleton->GetReferenceSkeleton();
 
 	ModifyBones.Empty();
+	bInitLimitsReachability = false;
 	AddModifyBone(Output, BoneContainer, RefSkeleton, RefSkeleton.FindBoneIndex(RootBone.BoneName));
 	if (ModifyBones.Num() > 0)
 	{
 		CalcBoneLength(ModifyBones[0], BoneContainer.GetRefPoseCompactArray());
+		InitModifyBonesCollisionMask();
 	}
 
 	if (bUsePhysicsAssetAsShapes && PhysicsAssetAsShapes != nullptr)
@@ -229,31 +809,246 @@ void FAnimNode_KawaiiPhysics::InitModifyBonesPhysicsBodiesSetup(FComponentSpaceP
 
 void FAnimNode_KawaiiPhysics::ApplyLimitsDataAsset(const FBoneContainer& RequiredBones)
 {
-	SphericalLimitsData.Empty();
-	CapsuleLimitsData.Empty();
-	PlanarLimitsData.Empty();
-	if (LimitsDataAsset)
+	// The limits stay in the data asset and are shared by every node using it. Only the state of this node is allocated
+	NumSphericalLimitsData = LimitsDataAsset ? LimitsDataAsset->SphericalLimits.Num() : 0;
+	NumCapsuleLimitsData = LimitsDataAsset ? LimitsDataAsset->CapsuleLimits.Num() : 0;
+	NumPlanarLimitsData = LimitsDataAsset ? LimitsDataAsset->PlanarLimits.Num() : 0;
+	LimitsDataInstances.Reset();
+	LimitsDataInstances.SetNum(NumSphericalLimitsData + NumCapsuleLimitsData + NumPlanarLimitsData);
+
+	InitializeLimitsDataBoneReferences(RequiredBones);
+	InitializeDrivenLimits(RequiredBones);
+
+#if WITH_EDITOR
+	AppliedLimitsDataAsset = LimitsDataAsset;
+	AppliedLimitsDataAssetRevision = LimitsDataAsset ? LimitsDataAsset->GetRevision() : 0;
+#endif
+}
+
+void FAnimNode_KawaiiPhysics::InitializeLimitsDataBoneReferences(const FBoneContainer& RequiredBones)
+{
+	// Resolved per node because nodes of different skeletons may share the data asset
+	InitializeLimitInstancesDrivingBone(GetSphericalLimitsData(), FindCookedLimitsDataBoneIndices(ECollisionLimitType::Spherical, RequiredBones),
+		GetLimitsDataInstances(ECollisionLimitType::Spherical), RequiredBones);
+	InitializeLimitInstancesDrivingBone(GetCapsuleLimitsData(), FindCookedLimitsDataBoneIndices(ECollisionLimitType::Capsule, RequiredBones),
+		GetLimitsDataInstances(ECollisionLimitType::Capsule), RequiredBones);
+	InitializeLimitInstancesDrivingBone(GetPlanarLimitsData(), FindCookedLimitsDataBoneIndices(ECollisionLimitType::Planar, RequiredBones),
+		GetLimitsDataInstances(ECollisionLimitType::Planar), RequiredBones);
+}
+
+TArrayView<const int32> FAnimNode_KawaiiPhysics::FindCookedLimitsDataBoneIndices(ECollisionLimitType Type, const FBoneContainer& RequiredBones) const
+{
+	// Empty if the data asset isn't cooked for the skeleton. The driving bones are resolved by name then
+	return LimitsDataAsset ? LimitsDataAsset->FindCookedBoneIndices(RequiredBones.GetSkeletonAsset(), Type) : TArrayView<const int32>();
+}
+
+TArrayView<const FKawaiiPhysicsCookedLimit> FAnimNode_KawaiiPhysics::GetCookedLimitsData(ECollisionLimitType Type) const
+{
+	return LimitsDataAsset ? LimitsDataAsset->GetCookedLimits(Type) : TArrayView<const FKawaiiPhysicsCookedLimit>();
+}
+
+const FKawaiiPhysicsLimitInstance* FAnimNode_KawaiiPhysics::GetLimitsDataInstances(ECollisionLimitType Type) const
+{
+	switch (Type)
 	{
-		SphericalLimitsData = LimitsDataAsset->SphericalLimits;
-		CapsuleLimitsData = LimitsDataAsset->CapsuleLimits;
-		PlanarLimitsData = LimitsDataAsset->PlanarLimits;
+	case ECollisionLimitType::Spherical:
+		return LimitsDataInstances.GetData();
+	case ECollisionLimitType::Capsule:
+		return LimitsDataInstances.GetData() + NumSphericalLimitsData;
+	case ECollisionLimitType::Planar:
+		return LimitsDataInstances.GetData() + NumSphericalLimitsData + NumCapsuleLimitsData;
 	}
+	return nullptr;
+}
+
+TArrayView<const FSphericalLimit> FAnimNode_KawaiiPhysics::GetSphericalLimitsData() const
+{
+	return GetLimitsDataView(LimitsDataAsset ? &LimitsDataAsset->SphericalLimits : nullptr, NumSphericalLimitsData);
+}
+
+TArrayView<const FCapsuleLimit> FAnimNode_KawaiiPhysics::GetCapsuleLimitsData() const
+{
+	return GetLimitsDataView(LimitsDataAsset ? &LimitsDataAsset->CapsuleLimits : nullptr, NumCapsuleLimitsData);
+}
+
+TArrayView<const FPlanarLimit> FAnimNode_KawaiiPhysics::GetPlanarLimitsData() const
+{
+	return GetLimitsDataView(LimitsDataAsset ? &LimitsDataAsset->PlanarLimits : nullptr, NumPlanarLimitsData);
+}
 
-	for (auto& Sphere : SphericalLimitsData)
+const FKawaiiPhysicsLimitInstance* FAnimNode_KawaiiPhysics::GetLimitsDataInstance(ECollisionLimitType Type, int32 Index) const
+{
+	int32 NumLimits = 0;
+	switch (Type)
 	{
-		Sphere.DrivingBone.Initialize(RequiredBones);
+	case ECollisionLimitType::Spherical:
+		NumLimits = GetSphericalLimitsData().Num();
+		break;
+	case ECollisionLimitType::Capsule:
+		NumLimits = GetCapsuleLimitsData().Num();
+		break;
+	case ECollisionLimitType::Planar:
+		NumLimits = GetPlanarLimitsData().Num();
+		break;
 	}
+	return Index >= 0 && Index < NumLimits ? GetLimitsDataInstances(Type) + Index : nullptr;
+}
 
-	for (auto& Capsule : CapsuleLimitsData)
+#if WITH_EDITOR
+bool FAnimNode_KawaiiPhysics::ApplyLimitsDataAssetLimit(ECollisionLimitType Type, int32 Index, const FBoneContainer& BoneContainer)
+{
+	// The limit itself is read from the data asset in place. Only its driving bone may have changed
+	const FCollisionLimitBase* Limit = nullptr;
+	switch (Type)
 	{
-		Capsule.DrivingBone.Initialize(RequiredBones);
+	case ECollisionLimitType::Spherical:
+		Limit = GetSphericalLimitsData().IsValidIndex(Index) ? &GetSphericalLimitsData()[Index] : nullptr;
+		break;
+	case ECollisionLimitType::Capsule:
+		Limit = GetCapsuleLimitsData().IsValidIndex(Index) ? &GetCapsuleLimitsData()[Index] : nullptr;
+		break;
+	case ECollisionLimitType::Planar:
+		Limit = GetPlanarLimitsData().IsValidIndex(Index) ? &GetPlanarLimitsData()[Index] : nullptr;
+		break;
 	}
-	for (auto& Planer : PlanarLimitsData)
+
+	// The number of limits must not have changed
+	if (!Limit || !LimitsDataAsset || LimitsDataAsset->SphericalLimits.Num() != NumSphericalLimitsData ||
+		LimitsDataAsset->CapsuleLimits.Num() != NumCapsuleLimitsData || LimitsDataAsset->PlanarLimits.Num() != NumPlanarLimitsData)
 	{
-		Planer.DrivingBone.Initialize(RequiredBones);
+		return false;
 	}
+
+	const TArrayView<const int32> SkeletonBoneIndices = FindCookedLimitsDataBoneIndices(Type, BoneContainer);
+	const int32* SkeletonBoneIndex = SkeletonBoneIndices.IsValidIndex(Index) ? &SkeletonBoneIndices[Index] : nullptr;
+	GetLimitsDataInstances(Type)[Index].DrivingBoneIndex = InitializeDrivingBone(Limit->DrivingBone, SkeletonBoneIndex, BoneContainer);
+	InitializeDrivenLimits(BoneContainer);
+	return true;
+}
+
+void FAnimNode_KawaiiPhysics::ApplyEditorChanges(const FBoneContainer& BoneContainer)
+{
+	// Edits of the data asset are pulled by its revision. A single limit updated in place is refreshed alone
+	const int32 LimitsDataAssetRevision = EditorLimitsDataAssetRevision.GetValue();
+	const int32 DataAssetRevision = LimitsDataAsset ? LimitsDataAsset->GetRevision() : 0;
+	if (LimitsDataAssetRevision != AppliedEditorLimitsDataAssetRevision ||
+		LimitsDataAsset != AppliedLimitsDataAsset || DataAssetRevision != AppliedLimitsDataAssetRevision)
+	{
+		ECollisionLimitType UpdatedType = ECollisionLimitType::None;
+		int32 UpdatedIndex = INDEX_NONE;
+		const bool bSingleLimit = LimitsDataAssetRevision == AppliedEditorLimitsDataAssetRevision &&
+			LimitsDataAsset && LimitsDataAsset == AppliedLimitsDataAsset && DataAssetRevision == AppliedLimitsDataAssetRevision + 1 &&
+			LimitsDataAsset->GetUpdatedLimit(DataAssetRevision, UpdatedType, UpdatedIndex);
+
+		AppliedEditorLimitsDataAssetRevision = LimitsDataAssetRevision;
+		if (bSingleLimit && ApplyLimitsDataAssetLimit(UpdatedType, UpdatedIndex, BoneContainer))
+		{
+			AppliedLimitsDataAssetRevision = DataAssetRevision;
+		}
+		else
+		{
+			ApplyLimitsDataAsset(BoneContainer);
+		}
+	}
+
+	const int32 LimitsRevision = EditorLimitsRevision.GetValue();
+	if (LimitsRevision != AppliedEditorLimitsRevision)
+	{
+		AppliedEditorLimitsRevision = LimitsRevision;
+
+		// Driving bones may have been renamed
+		for (auto& Sphere : SphericalLimits)
+		{
+			Sphere.DrivingBone.Initialize(BoneContainer);
+		}
+		for (auto& Capsule : CapsuleLimits)
+		{
+			Capsule.DrivingBone.Initialize(BoneContainer);
+		}
+		for (auto& Planer : PlanarLimits)
+		{
+			Planer.DrivingBone.Initialize(BoneContainer);
+		}
+		for (auto& SDF : SDFLimits)
+		{
+			SDF.DrivingBone.Initialize(BoneContainer);
+		}
+		InitializeDrivenLimits(BoneContainer);
+	}
+
+	const int32 PhysicsSettingsRevision = EditorPhysicsSettingsRevision.GetValue();
+	if (PhysicsSettingsRevision != AppliedEditorPhysicsSettingsRevision)
+	{
+		AppliedEditorPhysicsSettingsRevision = PhysicsSettingsRevision;
+
+		// Reachability depends on the settings of the bones and PlanarConstraint
+		bInitPhysicsSettings = false;
+		bInitLimitsReachability = false;
+	}
+}
+
+void FAnimNode_KawaiiPhysics::NotifyPhysicsSettingsChanged()
+{
+	EditorPhysicsSettingsRevision.Increment();
 }
 
+void FAnimNode_KawaiiPhysics::NotifyLimitsChanged()
+{
+	EditorLimitsRevision.Increment();
+}
+
+void FAnimNode_KawaiiPhysics::NotifyLimitsDataAssetChanged()
+{
+	EditorLimitsDataAssetRevision.Increment();
+}
+
+void FAnimNode_KawaiiPhysics::NotifyPropertyChanged(const FProperty* MemberProperty)
+{
+	const FName PropertyName = MemberProperty ? MemberProperty->GetFName() : NAME_None;
+	if (PropertyName == NAME_None)
+	{
+		NotifyPhysicsSettingsChanged();
+		NotifyLimitsChanged();
+		NotifyLimitsDataAssetChanged();
+	}
+	else if (PropertyName == GET_MEMBER_NAME_CHECKED(FAnimNode_KawaiiPhysics, LimitsDataAsset))
+	{
+		NotifyLimitsDataAssetChanged();
+	}
+	else if (PropertyName == GET_MEMBER_NAME_CHECKED(FAnimNode_KawaiiPhysics, SphericalLimits) ||
+		PropertyName == GET_MEMBER_NAME_CHECKED(FAnimNode_KawaiiPhysics, CapsuleLimits) ||
+		PropertyName == GET_MEMBER_NAME_CHECKED(FAnimNode_KawaiiPhysics, PlanarLimits) ||
+		PropertyName == GET_MEMBER_NAME_CHECKED(FAnimNode_KawaiiPhysics, SDFLimits) ||
+		PropertyName == GET_MEMBER_NAME_CHECKED(FAnimNode_KawaiiPhysics, bCullUnreachableLimits) ||
+		PropertyName == GET_MEMBER_NAME_CHECKED(FAnimNode_KawaiiPhysics, ReachabilityMargin))
+	{
+		NotifyLimitsChanged();
+	}
+	else
+	{
+		NotifyPhysicsSettingsChanged();
+	}
+}
+
+void FAnimNode_KawaiiPhysics::NotifyObjectChanged(const UObject* Object)
+{
+	if (!Object)
+	{
+		return;
+	}
+
+	FScopeLock Lock(&GetDebugNodesCritical());
+	for (FAnimNode_KawaiiPhysics* Node : GetDebugNodes())
+	{
+		if (Node->DampingCurve == Object || Node->WorldDampingLocationCurve == Object || Node->WorldDampingRotationCurve == Object ||
+			Node->StiffnessCurve == Object || Node->RadiusCurve == Object || Node->LimitAngleCurve == Object)
+		{
+			Node->NotifyPhysicsSettingsChanged();
+		}
+	}
+}
+#endif
+
 int FAnimNode_KawaiiPhysics::AddModifyBone(FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer, 
 	const FReferenceSkeleton& RefSkeleton, int BoneIndex)
 {
@@ -366,14 +1161,57 @@ void FAnimNode_KawaiiPhysics::CalcBoneLength(FKawaiiPhysicsModifyBone& Bone, con
 	}
 }
 
-DECLARE_CYCLE_STAT(TEXT("KawaiiPhysics_UpdatePhysicsSetting"), STAT_KawaiiPhysics_UpdatePhysicsSetting, STATGROUP_Anim);
+void FAnimNode_KawaiiPhysics::InitModifyBonesCollisionMask()
+{
+	for (auto& Bone : ModifyBones)
+	{
+		Bone.CollisionMask = DefaultCollisionMask;
+
+		if (TotalBoneLength > 0)
+		{
+			float LengthRate = Bone.LengthFromRoot / TotalBoneLength;
+			for (auto& Setting : BoneCollisionMasks)
+			{
+				if (Setting.Bones.Num() == 0 && LengthRate >= Setting.MinLengthRate && LengthRate <= Setting.MaxLengthRate)
+				{
+					Bone.CollisionMask = Setting.CollisionMask;
+				}
+			}
+		}
+	}
+
+	// Explicit bone list takes priority over range of bone length rate
+	for (auto& Setting : BoneCollisionMasks)
+	{
+		for (auto& BoneRef : Setting.Bones)
+		{
+			for (auto& Bone : ModifyBones)
+			{
+				if (!Bone.bDummy && Bone.BoneRef.BoneName == BoneRef.BoneName)
+				{
+					SetCollisionMaskOfSubChain(Bone, Setting.CollisionMask);
+					break;
+				}
+			}
+		}
+	}
+}
+
+void FAnimNode_KawaiiPhysics::SetCollisionMaskOfSubChain(FKawaiiPhysicsModifyBone& Bone, int32 CollisionMask)
+{
+	Bone.CollisionMask = CollisionMask;
+	for (int ChildIndex : Bone.ChildIndexs)
+	{
+		SetCollisionMaskOfSubChain(ModifyBones[ChildIndex], CollisionMask);
+	}
+}
 
 void FAnimNode_KawaiiPhysics::UpdatePhysicsSettingsOfModifyBones()
 {
+	KAWAIIPHYSICS_SCOPE_PHASE(Settings);
+
 	for (auto& Bone : ModifyBones)
 	{
-		SCOPE_CYCLE_COUNTER(STAT_KawaiiPhysics_UpdatePhysicsSetting);
-
 		float LengthRate = Bone.LengthFromRoot / TotalBoneLength;
 
 		// Damping
@@ -408,6 +1246,10 @@ void FAnimNode_KawaiiPhysics::UpdatePhysicsSettingsOfModifyBones()
 		}
 		Bone.PhysicsSettings.Stiffness = FMath::Clamp<float>(Bone.PhysicsSettings.Stiffness, 0.0f, 1.0f);
 
+		// Reachability of the limits depends on the radius and the limit angle
+		const float OldRadius = Bone.PhysicsSettings.Radius;
+		const float OldLimitAngle = Bone.PhysicsSettings.LimitAngle;
+
 		// Radius
 		Bone.PhysicsSettings.Radius = PhysicsSettings.Radius;
 		if (TotalBoneLength > 0 && RadiusCurve && RadiusCurve->GetCurves().Num() > 0)
@@ -423,131 +1265,312 @@ void FAnimNode_KawaiiPhysics::UpdatePhysicsSettingsOfModifyBones()
 			Bone.PhysicsSettings.LimitAngle *= LimitAngleCurve->GetFloatValue(LengthRate);
 		}
 		Bone.PhysicsSettings.LimitAngle = FMath::Max<float>(Bone.PhysicsSettings.LimitAngle, 0.0f);
+
+		if (Bone.PhysicsSettings.Radius != OldRadius || Bone.PhysicsSettings.LimitAngle != OldLimitAngle)
+		{
+			bInitLimitsReachability = false;
+		}
 	}
 }
 
-DECLARE_CYCLE_STAT(TEXT("KawaiiPhysics_UpdateSphericalLimit"), STAT_KawaiiPhysics_UpdateSphericalLimit, STATGROUP_Anim);
-
-void FAnimNode_KawaiiPhysics::UpdateSphericalLimits(TArray<FSphericalLimit>& Limits, FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer, FTransform& ComponentTransform)
+void FAnimNode_KawaiiPhysics::UpdateLimitsReachability(const FBoneContainer& BoneContainer)
 {
-	for (auto& Sphere : Limits)
+	const FReferenceSkeleton& RefSkeleton = BoneContainer.GetReferenceSkeleton();
+	const TArray<FTransform>& RefBonePose = RefSkeleton.GetRefBonePose();
+	const int32 RootBoneIndex = RefSkeleton.FindBoneIndex(RootBone.BoneName);
+
+	// Bone shapes of physics asset are not covered by Radius, so don't cull in that case
+	const bool bCull = bCullUnreachableLimits && !bUsePhysicsAssetAsShapes && RootBoneIndex != INDEX_NONE && ModifyBones.Num() > 0;
+
+	TArray<int32> RootAncestors;
+	for (int32 BoneIndex = RootBoneIndex; BoneIndex != INDEX_NONE; BoneIndex = RefSkeleton.GetParentIndex(BoneIndex))
 	{
-		SCOPE_CYCLE_COUNTER(STAT_KawaiiPhysics_UpdateSphericalLimit);
+		RootAncestors.Add(BoneIndex);
+	}
 
-		if (Sphere.DrivingBone.BoneIndex >= 0)
-		{		
-			FCompactPoseBoneIndex CompactPoseIndex = Sphere.DrivingBone.GetCompactPoseIndex(BoneContainer);
-			FTransform BoneTransform = Output.Pose.GetComponentSpaceTransform(CompactPoseIndex);
+	// Location of LocalCenter in the space of the driving bone relative to Root
+	auto CalcLimitReach = [&](const FCollisionLimitBase& Limit, const FVector& LocalCenter)
+	{
+		FLimitReach Reach;
+		Reach.CollisionGroup = Limit.CollisionGroup;
 
-			FAnimationRuntime::ConvertCSTransformToBoneSpace(ComponentTransform, Output.Pose, BoneTransform, CompactPoseIndex, BCS_BoneSpace);
-			BoneTransform.SetRotation(Sphere.OffsetRotation.Quaternion() * BoneTransform.GetRotation());
-			BoneTransform.AddToTranslation(Sphere.OffsetLocation);
+		const int32 DrivingBoneIndex = RefSkeleton.FindBoneIndex(Limit.DrivingBone.BoneName);
+		if (!bCull || DrivingBoneIndex == INDEX_NONE)
+		{
+			return Reach;
+		}
 
-			FAnimationRuntime::ConvertBoneSpaceTransformToCS(ComponentTransform, Output.Pose, BoneTransform, CompactPoseIndex, BCS_BoneSpace);
-			Sphere.Location = BoneTransform.GetLocation();
-			Sphere.Rotation = BoneTransform.GetRotation();
+		const FVector Offset = FTransform(Limit.OffsetRotation.Quaternion(), Limit.OffsetLocation).TransformPosition(LocalCenter);
+		Reach.bAnalyzed = true;
+		if (DrivingBoneIndex == RootBoneIndex)
+		{
+			Reach.bFixedToRoot = true;
+			Reach.Center = Offset;
+			Reach.MinDistance = Reach.MaxDistance = Offset.Size();
+			return Reach;
 		}
-		else
+
+		// Path from Root to the center through the common ancestor of Root and the driving bone. Each bone of the path
+		// may rotate, so the center is at most the sum of the segments away, and at least the longest one minus the others
+		float SumLength = Offset.Size();
+		float MaxLength = SumLength;
+		auto AddSegment = [&](int32 BoneIndex)
 		{
-			Sphere.Location = Sphere.OffsetLocation;
+			const float Length = RefBonePose[BoneIndex].GetTranslation().Size();
+			SumLength += Length;
+			MaxLength = FMath::Max(MaxLength, Length);
+		};
+
+		int32 CommonAncestorIndex = DrivingBoneIndex;
+		while (!RootAncestors.Contains(CommonAncestorIndex))
+		{
+			AddSegment(CommonAncestorIndex);
+			CommonAncestorIndex = RefSkeleton.GetParentIndex(CommonAncestorIndex);
 		}
-	}
-}
+		for (int32 i = 0; RootAncestors[i] != CommonAncestorIndex; ++i)
+		{
+			AddSegment(RootAncestors[i]);
+		}
+		Reach.MinDistance = FMath::Max(2.0f * MaxLength - SumLength, 0.0f);
+		Reach.MaxDistance = SumLength;
+		return Reach;
+	};
 
-DECLARE_CYCLE_STAT(TEXT("KawaiiPhysics_UpdateCapsuleLimit"), STAT_KawaiiPhysics_UpdateCapsuleLimit, STATGROUP_Anim);
+	auto CalcSphericalLimitReach = [&](const FSphericalLimit& Sphere)
+	{
+		FLimitReach Reach = CalcLimitReach(Sphere, FVector::ZeroVector);
+		Reach.Extent = Sphere.Radius;
+		Reach.bInner = Sphere.LimitType == ESphericalLimitType::Inner;
+		return Reach;
+	};
 
-void FAnimNode_KawaiiPhysics::UpdateCapsuleLimits(TArray<FCapsuleLimit>& Limits, FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer, FTransform& ComponentTransform)
-{
-	for (auto& Capsule : Limits)
+	auto CalcCapsuleLimitReach = [&](const FCapsuleLimit& Capsule)
 	{
-		SCOPE_CYCLE_COUNTER(STAT_KawaiiPhysics_UpdateCapsuleLimit);
+		FLimitReach Reach = CalcLimitReach(Capsule, FVector::ZeroVector);
+		Reach.Extent = Capsule.Radius + Capsule.Length * 0.5f;
+		return Reach;
+	};
 
-		if (Capsule.DrivingBone.BoneIndex >= 0)
-		{			
-			FCompactPoseBoneIndex CompactPoseIndex = Capsule.DrivingBone.GetCompactPoseIndex(BoneContainer);
-			FTransform BoneTransform = Output.Pose.GetComponentSpaceTransform(CompactPoseIndex);
+	auto CalcPlanarLimitReach = [&](const FPlanarLimit& Planar)
+	{
+		FLimitReach Reach = CalcLimitReach(Planar, FVector::ZeroVector);
+		Reach.bAnalyzed &= Reach.bFixedToRoot;
+		Reach.bPlane = true;
+		Reach.PlaneNormal = Planar.OffsetRotation.Quaternion().GetNormalized().GetUpVector();
+		return Reach;
+	};
+
+	auto CalcSDFLimitReach = [&](const FSDFLimit& SDF)
+	{
+		if (SDF.SDFDataAsset == nullptr || !SDF.SDFDataAsset->IsValidField())
+		{
+			FLimitReach Reach;
+			Reach.CollisionGroup = SDF.CollisionGroup;
+			return Reach;
+		}
 
-			FAnimationRuntime::ConvertCSTransformToBoneSpace(ComponentTransform, Output.Pose, BoneTransform, CompactPoseIndex, BCS_BoneSpace);
-			BoneTransform.SetRotation(Capsule.OffsetRotation.Quaternion() * BoneTransform.GetRotation());
-			BoneTransform.AddToTranslation(Capsule.OffsetLocation);
+		// The field is sampled only within its bounds
+		const FBox Bounds = SDF.SDFDataAsset->GetBounds();
+		FLimitReach Reach = CalcLimitReach(SDF, Bounds.GetCenter());
+		Reach.Extent = Bounds.GetExtent().Size();
+		return Reach;
+	};
+
+	TArray<FLimitReach> SphericalReaches;
+	TArray<FLimitReach> SphericalDataReaches;
+	TArray<FLimitReach> CapsuleReaches;
+	TArray<FLimitReach> CapsuleDataReaches;
+	TArray<FLimitReach> PlanarReaches;
+	TArray<FLimitReach> PlanarDataReaches;
+	TArray<FLimitReach> SDFReaches;
+	Algo::Transform(SphericalLimits, SphericalReaches, CalcSphericalLimitReach);
+	Algo::Transform(GetSphericalLimitsData(), SphericalDataReaches, CalcSphericalLimitReach);
+	Algo::Transform(CapsuleLimits, CapsuleReaches, CalcCapsuleLimitReach);
+	Algo::Transform(GetCapsuleLimitsData(), CapsuleDataReaches, CalcCapsuleLimitReach);
+	Algo::Transform(PlanarLimits, PlanarReaches, CalcPlanarLimitReach);
+	Algo::Transform(GetPlanarLimitsData(), PlanarDataReaches, CalcPlanarLimitReach);
+	Algo::Transform(SDFLimits, SDFReaches, CalcSDFLimitReach);
+
+	for (FKawaiiPhysicsModifyBone& Bone : ModifyBones)
+	{
+		// The first bone below Root is kept at its length, and within its angle limit of the reference pose unless the
+		// planar constraint moves it after the angle limit
+		FBoneReach Reach;
+		if (Bone.ParentIndex >= 0)
+		{
+			const FKawaiiPhysicsModifyBone* ChildBone = &Bone;
+			while (ModifyBones[ChildBone->ParentIndex].ParentIndex >= 0)
+			{
+				ChildBone = &ModifyBones[ChildBone->ParentIndex];
+			}
+			Reach.ChildLength = ChildBone->LengthFromRoot;
 
-			FAnimationRuntime::ConvertBoneSpaceTransformToCS(ComponentTransform, Output.Pose, BoneTransform, CompactPoseIndex, BCS_BoneSpace);
-			Capsule.Location = BoneTransform.GetLocation();
-			Capsule.Rotation = BoneTransform.GetRotation();
-		}
-		else
-		{			
-			Capsule.Location = Capsule.OffsetLocation;
-			Capsule.Rotation = Capsule.OffsetRotation.Quaternion();
+			const int32 ChildBoneIndex = ChildBone->bDummy ? INDEX_NONE : RefSkeleton.FindBoneIndex(ChildBone->BoneRef.BoneName);
+			const FVector ChildDirection = ChildBoneIndex != INDEX_NONE ? RefBonePose[ChildBoneIndex].GetTranslation().GetSafeNormal() : FVector::ZeroVector;
+			if (!ChildDirection.IsZero() && ChildBone->PhysicsSettings.LimitAngle > 0.0f && PlanarConstraint == EPlanarConstraint::None)
+			{
+				Reach.ChildDirection = ChildDirection;
+				Reach.ChildLimitAngle = FMath::Min(FMath::DegreesToRadians(ChildBone->PhysicsSettings.LimitAngle), PI);
+			}
 		}
+		Reach.RemainingLength = Bone.LengthFromRoot - Reach.ChildLength + ReachabilityMargin;
+
+		auto AddReachableLimits = [&Bone, &Reach](const TArray<FLimitReach>& LimitReaches, TArray<int32>& OutLimitIndices)
+		{
+			OutLimitIndices.Reset();
+			for (int32 i = 0; i < LimitReaches.Num(); ++i)
+			{
+				const FLimitReach& LimitReach = LimitReaches[i];
+				if ((LimitReach.CollisionGroup & Bone.CollisionMask) != 0 && !IsLimitUnreachable(Reach, Bone.PhysicsSettings.Radius, LimitReach))
+				{
+					OutLimitIndices.Add(i);
+				}
+			}
+		};
+
+		FKawaiiPhysicsReachableLimits& ReachableLimits = Bone.ReachableLimits;
+		AddReachableLimits(SphericalReaches, ReachableLimits.Spherical);
+		AddReachableLimits(SphericalDataReaches, ReachableLimits.SphericalData);
+		AddReachableLimits(CapsuleReaches, ReachableLimits.Capsule);
+		AddReachableLimits(CapsuleDataReaches, ReachableLimits.CapsuleData);
+		AddReachableLimits(PlanarReaches, ReachableLimits.Planar);
+		AddReachableLimits(PlanarDataReaches, ReachableLimits.PlanarData);
+		AddReachableLimits(SDFReaches, ReachableLimits.SDF);
 	}
 }
 
-DECLARE_CYCLE_STAT(TEXT("KawaiiPhysics_UpdatePlanerLimit"), STAT_KawaiiPhysics_UpdatePlanerLimit, STATGROUP_Anim);
+int32 FAnimNode_KawaiiPhysics::GetNumDrivenLimits() const
+{
+	return SphericalLimits.Num() + CapsuleLimits.Num() + PlanarLimits.Num() + SDFLimits.Num() +
+		GetSphericalLimitsData().Num() + GetCapsuleLimitsData().Num() + GetPlanarLimitsData().Num();
+}
+
+void FAnimNode_KawaiiPhysics::InitializeDrivenLimits(const FBoneContainer& BoneContainer)
+{
+	// Indices of the reachable limits are of the old limits
+	bInitLimitsReachability = false;
+
+	DrivenLimits.Reset(GetNumDrivenLimits());
+	// The type is passed in because FCollisionLimitBase::Type is editor only data
+	AddDrivenLimits(SphericalLimits, ECollisionLimitType::Spherical, BoneContainer, DrivenLimits);
+	AddDrivenLimits(CapsuleLimits, ECollisionLimitType::Capsule, BoneContainer, DrivenLimits);
+	AddDrivenLimits(PlanarLimits, ECollisionLimitType::Planar, BoneContainer, DrivenLimits);
+	AddDrivenLimits(SDFLimits, ECollisionLimitType::SDF, BoneContainer, DrivenLimits);
+	AddDrivenLimitsData(GetSphericalLimitsData(), ECollisionLimitType::Spherical, GetCookedLimitsData(ECollisionLimitType::Spherical),
+		GetLimitsDataInstances(ECollisionLimitType::Spherical), DrivenLimits);
+	AddDrivenLimitsData(GetCapsuleLimitsData(), ECollisionLimitType::Capsule, GetCookedLimitsData(ECollisionLimitType::Capsule),
+		GetLimitsDataInstances(ECollisionLimitType::Capsule), DrivenLimits);
+	AddDrivenLimitsData(GetPlanarLimitsData(), ECollisionLimitType::Planar, GetCookedLimitsData(ECollisionLimitType::Planar),
+		GetLimitsDataInstances(ECollisionLimitType::Planar), DrivenLimits);
+
+	// Limits without a driving bone come first
+	DrivenLimits.Sort([](const FKawaiiPhysicsDrivenLimit& A, const FKawaiiPhysicsDrivenLimit& B)
+	{
+		return A.DrivingBoneIndex.GetInt() < B.DrivingBoneIndex.GetInt();
+	});
+}
 
-void FAnimNode_KawaiiPhysics::UpdatePlanerLimits(TArray<FPlanarLimit>& Limits, FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer, FTransform& ComponentTransform)
+void FAnimNode_KawaiiPhysics::UpdateLimitTransforms(FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer)
 {
-	for (auto& Planar : Limits)
+	// Limits were added or removed without initializing the bones
+	if (DrivenLimits.Num() != GetNumDrivenLimits())
 	{
-		SCOPE_CYCLE_COUNTER(STAT_KawaiiPhysics_UpdatePlanerLimit);
+		InitializeDrivenLimits(BoneContainer);
+	}
 
-		if (Planar.DrivingBone.BoneIndex >= 0)
+	FCompactPoseBoneIndex BoneIndex(INDEX_NONE);
+	FTransform BoneTransform = FTransform::Identity;
+	for (const FKawaiiPhysicsDrivenLimit& DrivenLimit : DrivenLimits)
+	{
+		if (DrivenLimit.DrivingBoneIndex != BoneIndex)
 		{
-			FCompactPoseBoneIndex CompactPoseIndex = Planar.DrivingBone.GetCompactPoseIndex(BoneContainer);
-			FTransform BoneTransform = Output.Pose.GetComponentSpaceTransform(CompactPoseIndex);
+			BoneIndex = DrivenLimit.DrivingBoneIndex;
+			BoneTransform = Output.Pose.GetComponentSpaceTransform(BoneIndex);
+		}
 
-			FAnimationRuntime::ConvertCSTransformToBoneSpace(ComponentTransform, Output.Pose, BoneTransform, CompactPoseIndex, BCS_BoneSpace);
-			BoneTransform.SetRotation(Planar.OffsetRotation.Quaternion() * BoneTransform.GetRotation());
-			BoneTransform.AddToTranslation(Planar.OffsetLocation);
+		// Same as applying the offset in the bone space of the driving bone
+		const FTransform LimitTransform = DrivenLimit.Offset * BoneTransform;
 
-			FAnimationRuntime::ConvertBoneSpaceTransformToCS(ComponentTransform, Output.Pose, BoneTransform, CompactPoseIndex, BCS_BoneSpace);
-			Planar.Location = BoneTransform.GetLocation();
-			Planar.Rotation = BoneTransform.GetRotation();
-			Planar.Rotation.Normalize();
-			Planar.Plane = FPlane(Planar.Location, Planar.Rotation.GetUpVector());
+		FVector* Location = nullptr;
+		FQuat* Rotation = nullptr;
+		if (DrivenLimit.bFromDataAsset)
+		{
+			FKawaiiPhysicsLimitInstance& Instance = GetLimitsDataInstances(DrivenLimit.Type)[DrivenLimit.Index];
+			Location = &Instance.Location;
+			Rotation = &Instance.Rotation;
 		}
 		else
 		{
-			Planar.Location = Planar.OffsetLocation;
-			Planar.Rotation = Planar.OffsetRotation.Quaternion();
-			Planar.Rotation.Normalize();
-			Planar.Plane = FPlane(Planar.Location, Planar.Rotation.GetUpVector());
+			FCollisionLimitBase* Limit = nullptr;
+			switch (DrivenLimit.Type)
+			{
+			case ECollisionLimitType::Spherical:
+				Limit = &SphericalLimits[DrivenLimit.Index];
+				break;
+			case ECollisionLimitType::Capsule:
+				Limit = &CapsuleLimits[DrivenLimit.Index];
+				break;
+			case ECollisionLimitType::Planar:
+				Limit = &PlanarLimits[DrivenLimit.Index];
+				break;
+			case ECollisionLimitType::SDF:
+				Limit = &SDFLimits[DrivenLimit.Index];
+				break;
+			}
+			Location = &Limit->Location;
+			Rotation = &Limit->Rotation;
 		}
+		*Location = LimitTransform.GetLocation();
+		*Rotation = LimitTransform.GetRotation();
 	}
-}
 
-DECLARE_CYCLE_STAT(TEXT("KawaiiPhysics_SimulatemodifyBones"), STAT_KawaiiPhysics_SimulatemodifyBones, STATGROUP_Anim);
-DECLARE_CYCLE_STAT(TEXT("KawaiiPhysics_SimulatemodifyBone"), STAT_KawaiiPhysics_SimulatemodifyBone, STATGROUP_Anim);
-DECLARE_CYCLE_STAT(TEXT("KawaiiPhysics_AdjustBone"), STAT_KawaiiPhysics_AdjustBone, STATGROUP_Anim);
-DECLARE_CYCLE_STAT(TEXT("KawaiiPhysics_Wind"), STAT_KawaiiPhysics_Wind, STATGROUP_Anim);
+	for (auto& Planar : PlanarLimits)
+	{
+		Planar.Rotation.Normalize();
+		Planar.Plane = FPlane(Planar.Location, Planar.Rotation.GetUpVector());
+	}
+
+	const TArrayView<const FPlanarLimit> PlanarLimitsData = GetPlanarLimitsData();
+	FKawaiiPhysicsLimitInstance* PlanarInstances = GetLimitsDataInstances(ECollisionLimitType::Planar);
+	for (int32 i = 0; i < PlanarLimitsData.Num(); ++i)
+	{
+		FKawaiiPhysicsLimitInstance& Instance = PlanarInstances[i];
+		Instance.Rotation.Normalize();
+		Instance.Plane = FPlane(Instance.Location, Instance.Rotation.GetUpVector());
+	}
+}
 
-void FAnimNode_KawaiiPhysics::SimulateModifyBones(FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer, FTransform& ComponentTransform)
+void FAnimNode_KawaiiPhysics::SimulateModifyBones(const FTransform& ComponentTransform)
 {
-	SCOPE_CYCLE_COUNTER(STAT_KawaiiPhysics_SimulatemodifyBones);
+	KAWAIIPHYSICS_SCOPE_PHASE(Simulate);
 
 	if (DeltaTime <= 0.0f)
 	{
+		KAWAIIPHYSICS_INC_COUNTER(NodesSkipped, 1);
 		return;
 	}
 
-	// for wind
-	FVector WindDirection;
-	float WindSpeed;
-	float WindMinGust;
-	float WindMaxGust;
-
-	const USkeletalMeshComponent* SkelComp = Output.AnimInstanceProxy->GetSkelMeshComponent();
-	const UWorld* World = SkelComp ? SkelComp->GetWorld() : nullptr;
-	FSceneInterface* Scene = World && World->Scene ? World->Scene : nullptr;
-	const float Exponent = TargetFramerate * DeltaTime;
-
 	//transform gravity to component space
 	FVector GravityCS = ComponentTransform.InverseTransformVector(Gravity);
 
+	KawaiiPhysicsSolver::FStepParams StepParams;
+	StepParams.DeltaTime = DeltaTime;
+	StepParams.DeltaTimeOld = DeltaTimeOld;
+	StepParams.StiffnessExponent = TargetFramerate * DeltaTime;
+	StepParams.GravityStep = KawaiiPhysicsSolver::CalcGravityStep(GravityCS, DeltaTime, bOldPhysicsMethodGravity);
+	StepParams.MoveVector = SkelCompMoveVector;
+	StepParams.MoveRotation = SkelCompMoveRotation;
+
+	uint32 IntegrateCycles = 0;
+	uint32 CollideCycles = 0;
+	uint32 ConstraintsCycles = 0;
+	const bool bPhaseTiming = FKawaiiPhysicsScopedPhaseCycles::IsEnabled();
+	int32 NumSimulatedBones = 0;
+	NumPairsTested = 0;
+	NumPushOuts = 0;
+
 	for (int i = 0; i < ModifyBones.Num(); ++i)
 	{
-		SCOPE_CYCLE_COUNTER(STAT_KawaiiPhysics_SimulatemodifyBone);
-
 		auto& Bone = ModifyBones[i];
 		if (Bone.BoneRef.BoneIndex < 0 && !Bone.bDummy)
 		{
@@ -565,167 +1588,164 @@ void FAnimNode_KawaiiPhysics::SimulateModifyBones(FComponentSpacePoseContext& Ou
 		FVector BonePoseLocation = Bone.PoseLocation;
 		FVector ParentBonePoseLocation = ParentBone.PoseLocation;
 
-		if (bUseDelayMode)
+		++NumSimulatedBones;
+
 		{
-			Bone.PrevLocation = Bone.Location;
+			FKawaiiPhysicsScopedPhaseCycles ScopedCycles(IntegrateCycles, bPhaseTiming);
 
-			FVector BoneNotDelayedLocation;
-			if (ParentBone.ParentIndex < 0)
+			if (bUseDelayMode)
 			{
-				// Parent[ĝƂ͓͈ʒuDelaỹKChƂ:w
-				BoneNotDelayedLocation = Bone.PoseLocation;
+				Bone.PrevLocation = Bone.Location;
+
+				FVector BoneNotDelayedLocation;
+				if (ParentBone.ParentIndex < 0)
+				{
+					// Parent[ĝƂ͓͈ʒuDelaỹKChƂ:w
+					BoneNotDelayedLocation = Bone.PoseLocation;
+				}
+				else
+				{
+					// Parent[głȂƂGrandParentParent񂾕Ƀ[JRotationʒuDelaỹKChƂ
+					//const FQuat& BoneLocalPoseRotation = ParentBone.PoseRotation.Inverse() * Bone.PoseRotation;
+					auto& GrandParentBone = ModifyBones[ParentBone.ParentIndex];
+					const FQuat& BoneLocalPoseRotation = FQuat::FindBetweenVectors(ParentBone.PoseLocation - GrandParentBone.PoseLocation, Bone.PoseLocation - ParentBone.PoseLocation);
+					BoneNotDelayedLocation = ParentBone.Location + BoneLocalPoseRotation * (ParentBone.Location - GrandParentBone.Location).GetSafeNormal() * (Bone.PoseLocation - ParentBone.PoseLocation).Size();
+				}
+
+				Bone.Location = FMath::Lerp(Bone.PrevLocation, BoneNotDelayedLocation, Bone.PhysicsSettings.DelayAlpha);
 			}
 			else
 			{
-				// Parent[głȂƂGrandParentParent񂾕Ƀ[JRotationʒuDelaỹKChƂ
-				//const FQuat& BoneLocalPoseRotation = ParentBone.PoseRotation.Inverse() * Bone.PoseRotation;
-				auto& GrandParentBone = ModifyBones[ParentBone.ParentIndex];
-				const FQuat& BoneLocalPoseRotation = FQuat::FindBetweenVectors(ParentBone.PoseLocation - GrandParentBone.PoseLocation, Bone.PoseLocation - ParentBone.PoseLocation);
-				BoneNotDelayedLocation = ParentBone.Location + BoneLocalPoseRotation * (ParentBone.Location - GrandParentBone.Location).GetSafeNormal() * (Bone.PoseLocation - ParentBone.PoseLocation).Size();
-			}
-
-			Bone.Location = FMath::Lerp(Bone.PrevLocation, BoneNotDelayedLocation, Bone.PhysicsSettings.DelayAlpha);
-		}
-		else
-		{
-			// Move using Velocity( = movement amount in pre frame ) and Damping
-			{
-				FVector Velocity = (Bone.Location - Bone.PrevLocation) / DeltaTimeOld;
-				Bone.PrevLocation = Bone.Location;
-				Velocity *= (1.0f - Bone.PhysicsSettings.Damping);
-
 				// wind
-				if (bEnableWind && Scene)
+				FVector WindVelocity = FVector::ZeroVector;
+				if (bEnableWind && InputSnapshot.WindVelocities.IsValidIndex(i))
 				{
-					SCOPE_CYCLE_COUNTER(STAT_KawaiiPhysics_Wind);
-
-					Scene->GetWindParameters_GameThread(ComponentTransform.TransformPosition(Bone.PoseLocation), WindDirection, WindSpeed, WindMinGust, WindMaxGust);
-					WindDirection = ComponentTransform.Inverse().TransformVector(WindDirection);
-					FVector WindVelocity = WindDirection * WindSpeed * WindScale;
+					WindVelocity = InputSnapshot.WindVelocities[i] * WindScale;
 
 					// TODO:Migrate if there are more good method (Currently copying AnimDynamics implementation)
-					WindVelocity *= FMath::FRandRange(0.0f, 2.0f);
-
-					Velocity += WindVelocity * TargetFramerate;
+					WindVelocity *= WindRandomStream.FRandRange(0.0f, 2.0f) * TargetFramerate;
 				}
-				Bone.Location += Velocity * DeltaTime;
-			}
-
-			// Follow Translation
-			Bone.Location += SkelCompMoveVector * (1.0f - Bone.PhysicsSettings.WorldDampingLocation);
 
-			// Follow Rotation
-			Bone.Location += (SkelCompMoveRotation.RotateVector(Bone.PrevLocation) - Bone.PrevLocation)
-				* (1.0f - Bone.PhysicsSettings.WorldDampingRotation);
+				KawaiiPhysicsSolver::FBoneParams BoneParams;
+				BoneParams.Damping = Bone.PhysicsSettings.Damping;
+				BoneParams.WorldDampingLocation = Bone.PhysicsSettings.WorldDampingLocation;
+				BoneParams.WorldDampingRotation = Bone.PhysicsSettings.WorldDampingRotation;
+				BoneParams.Stiffness = Bone.PhysicsSettings.Stiffness;
 
-			// Gravity
-			// TODO:Migrate if there are more good method (Currently copying AnimDynamics implementation)
-			if (CVarEnableOldPhysicsMethodGrayity.GetValueOnAnyThread() == 0)
-			{
-				Bone.Location += 0.5 * GravityCS * DeltaTime * DeltaTime;
-			}
-			else
-			{
-				Bone.Location += GravityCS * DeltaTime;
+				FVector BaseLocation = ParentBone.Location + (BonePoseLocation - ParentBonePoseLocation);
+				FVector NewLocation = KawaiiPhysicsSolver::Integrate(Bone.Location, Bone.PrevLocation, BaseLocation, WindVelocity, BoneParams, StepParams);
+				Bone.PrevLocation = Bone.Location;
+				Bone.Location = NewLocation;
 			}
-			
-			// Pull to Pose Location
-			FVector BaseLocation = ParentBone.Location + (BonePoseLocation - ParentBonePoseLocation);
-			Bone.Location += (BaseLocation - Bone.Location) *
-				(1.0f - FMath::Pow(1.0f - Bone.PhysicsSettings.Stiffness, Exponent));
-		}
 
-		// Calculate Rotation before adjusting collision
-		ParentBone.Rotation = ParentBone.PoseRotation;
-		if (i > 0)
-		{
-			if (ParentBone.BoneRef.BoneIndex >= 0)
+			// Calculate Rotation before adjusting collision
+			ParentBone.Rotation = ParentBone.PoseRotation;
+			if (i > 0)
 			{
-				FVector PoseVector = Bone.PoseLocation - ParentBone.PoseLocation;
-				FVector SimulateVector = Bone.Location - ParentBone.Location;
-
-				if (PoseVector.GetSafeNormal() != SimulateVector.GetSafeNormal())
+				if (ParentBone.BoneRef.BoneIndex >= 0)
 				{
-					if (BoneForwardAxis == EBoneForwardAxis::X_Negative || BoneForwardAxis == EBoneForwardAxis::Y_Negative || BoneForwardAxis == EBoneForwardAxis::Z_Negative)
+					FVector PoseVector = Bone.PoseLocation - ParentBone.PoseLocation;
+					FVector SimulateVector = Bone.Location - ParentBone.Location;
+
+					if (PoseVector.GetSafeNormal() != SimulateVector.GetSafeNormal())
 					{
-						PoseVector *= -1;
-						SimulateVector *= -1;
-					}
+						if (BoneForwardAxis == EBoneForwardAxis::X_Negative || BoneForwardAxis == EBoneForwardAxis::Y_Negative || BoneForwardAxis == EBoneForwardAxis::Z_Negative)
+						{
+							PoseVector *= -1;
+							SimulateVector *= -1;
+						}
 
-					FQuat SimulateRotation = FQuat::FindBetweenVectors(PoseVector, SimulateVector) * ParentBone.PoseRotation;
-					ParentBone.Rotation = SimulateRotation;
+						FQuat SimulateRotation = FQuat::FindBetweenVectors(PoseVector, SimulateVector) * ParentBone.PoseRotation;
+						ParentBone.Rotation = SimulateRotation;
+					}
 				}
 			}
 		}
 
 		{
-			SCOPE_CYCLE_COUNTER(STAT_KawaiiPhysics_AdjustBone);
+			FKawaiiPhysicsScopedPhaseCycles ScopedCycles(CollideCycles, bPhaseTiming);
 
-			// Adjust by each collisions
-			AdjustBySphereCollision(SkelComp, ParentBone, Bone, SphericalLimits);
-			AdjustBySphereCollision(SkelComp, ParentBone, Bone, SphericalLimitsData);
-			AdjustByCapsuleCollision(SkelComp, ParentBone, Bone, CapsuleLimits);
-			AdjustByCapsuleCollision(SkelComp, ParentBone, Bone, CapsuleLimitsData);
-			AdjustByPlanerCollision(SkelComp, ParentBone, Bone, PlanarLimits);
-			AdjustByPlanerCollision(SkelComp, ParentBone, Bone, PlanarLimitsData);
-			AdjustByPhysicsAssetCollision(SkelComp, ParentBone, Bone);
-
-			// Adjust by angle limit
-			AdjustByAngleLimit(Output, BoneContainer, ComponentTransform, Bone, ParentBone);
+			AdjustByCollisionLimits(ParentBone, Bone);
+		}
 
-			// Adjust by Planar Constraint
-			AdjustByPlanarConstraint(Bone, ParentBone);
+		{
+			FKawaiiPhysicsScopedPhaseCycles ScopedCycles(ConstraintsCycles, bPhaseTiming);
+			AdjustByConstraints(Bone, ParentBone);
 		}
+	}
 
-		// Restore Bone Length
-		float BoneLength = (BonePoseLocation - ParentBonePoseLocation).Size();
-		Bone.Location = (Bone.Location - ParentBone.Location).GetSafeNormal() * BoneLength + ParentBone.Location;
+	if (bEnableSelfCollision)
+	{
+		AdjustBySelfCollision();
+	}
+
+	if (bPhaseTiming)
+	{
+		KAWAIIPHYSICS_ADD_PHASE_CYCLES(Integrate, IntegrateCycles);
+		KAWAIIPHYSICS_ADD_PHASE_CYCLES(Collide, CollideCycles);
+		KAWAIIPHYSICS_ADD_PHASE_CYCLES(Constraints, ConstraintsCycles);
 	}
+	KAWAIIPHYSICS_INC_COUNTER(BonesSimulated, NumSimulatedBones);
+	KAWAIIPHYSICS_INC_COUNTER(ColliderPairsTested, NumPairsTested);
+	KAWAIIPHYSICS_INC_COUNTER(PushOutsApplied, NumPushOuts);
+
 	DeltaTimeOld = DeltaTime;
 }
 
-void FAnimNode_KawaiiPhysics::AdjustBySphereCollision(const USkeletalMeshComponent* SkeletalMeshComp, FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone, TArray<FSphericalLimit>& Limits)
+void FAnimNode_KawaiiPhysics::AdjustByCollisionLimits(FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone)
+{
+	// Adjust by each collisions
+	const FKawaiiPhysicsReachableLimits& ReachableLimits = Bone.ReachableLimits;
+	AdjustBySphereCollision(ParentBone, Bone, SphericalLimits, ReachableLimits.Spherical);
+	AdjustBySphereCollision(ParentBone, Bone, GetSphericalLimitsData(), ReachableLimits.SphericalData, GetLimitsDataInstances(ECollisionLimitType::Spherical));
+	AdjustByCapsuleCollision(ParentBone, Bone, CapsuleLimits, ReachableLimits.Capsule);
+	AdjustByCapsuleCollision(ParentBone, Bone, GetCapsuleLimitsData(), ReachableLimits.CapsuleData, GetLimitsDataInstances(ECollisionLimitType::Capsule));
+	AdjustByPlanerCollision(ParentBone, Bone, PlanarLimits, ReachableLimits.Planar);
+	AdjustByPlanerCollision(ParentBone, Bone, GetPlanarLimitsData(), ReachableLimits.PlanarData, GetLimitsDataInstances(ECollisionLimitType::Planar));
+	AdjustBySDFCollision(ParentBone, Bone, SDFLimits, ReachableLimits.SDF);
+	AdjustByPhysicsAssetCollision(ParentBone, Bone);
+}
+
+void FAnimNode_KawaiiPhysics::AdjustByConstraints(FKawaiiPhysicsModifyBone& Bone, FKawaiiPhysicsModifyBone& ParentBone)
+{
+	// Adjust by angle limit
+	AdjustByAngleLimit(Bone, ParentBone);
+
+	// Adjust by Planar Constraint
+	AdjustByPlanarConstraint(Bone, ParentBone);
+
+	// Restore Bone Length
+	float BoneLength = (Bone.PoseLocation - ParentBone.PoseLocation).Size();
+	Bone.Location = KawaiiPhysicsSolver::RestoreBoneLength(Bone.Location, ParentBone.Location, BoneLength);
+}
+
+void FAnimNode_KawaiiPhysics::AdjustBySphereCollision(FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone, TArrayView<const FSphericalLimit> Limits,
+	TArrayView<const int32> LimitIndices, const FKawaiiPhysicsLimitInstance* Instances)
 {
 	if (!bUsePhysicsAssetAsShapes)
 	{
-		for (auto& Sphere : Limits)
+		for (const int32 LimitIndex : LimitIndices)
 		{
-			if (Sphere.Radius <= 0.0f)
+			const FSphericalLimit& Sphere = Limits[LimitIndex];
+			const FVector& SphereLocation = Instances ? Instances[LimitIndex].Location : Sphere.Location;
+
+			if (Sphere.Radius <= 0.0f || (Sphere.CollisionGroup & Bone.CollisionMask) == 0)
 			{
 				continue;
 			}
-
-			float LimitDistance = Bone.PhysicsSettings.Radius + Sphere.Radius;
-			if (Sphere.LimitType == ESphericalLimitType::Outer)
-			{
-				if ((Bone.Location - Sphere.Location).SizeSquared() > LimitDistance * LimitDistance)
-				{
-					continue;
-				}
-				else
-				{
-					Bone.Location += (LimitDistance - (Bone.Location - Sphere.Location).Size())
-						* (Bone.Location - Sphere.Location).GetSafeNormal();
-				}
+
+			++NumPairsTested;
+			bool bPushed = false;
+			if (Sphere.LimitType == ESphericalLimitType::Outer)
+			{
+				bPushed = KawaiiPhysicsSolver::PushOutFromSphere(Bone.Location, Bone.PhysicsSettings.Radius, SphereLocation, Sphere.Radius);
 			}
 			else
 			{
-				if ((Bone.Location - Sphere.Location).SizeSquared() < LimitDistance * LimitDistance)
-				{
-					continue;
-				}
-				else
-				{
-					if (CVarEnableOldPhysicsMethodSphereLimit.GetValueOnAnyThread() == 0)
-					{
-						Bone.Location = Sphere.Location + (Sphere.Radius - Bone.PhysicsSettings.Radius) * (Bone.Location - Sphere.Location).GetSafeNormal();
-					}
-					else
-					{
-						Bone.Location = Sphere.Location + Sphere.Radius * (Bone.Location - Sphere.Location).GetSafeNormal();
-					}
-				}
+				bPushed = KawaiiPhysicsSolver::PushInToSphere(Bone.Location, Bone.PhysicsSettings.Radius, SphereLocation, Sphere.Radius,
+					bOldPhysicsMethodSphereLimit);
 			}
+			NumPushOuts += bPushed ? 1 : 0;
 		}
 	}
 	else
@@ -733,7 +1753,7 @@ void FAnimNode_KawaiiPhysics::AdjustBySphereCollision(const USkeletalMeshCompone
 		if (Bone.PhysicsBodySetup != nullptr)
 		{
 			check(Bone.BoneRef.BoneIndex != INDEX_NONE);
-			float Scale = SkeletalMeshComp->GetBoneTransform(Bone.BoneRef.BoneIndex, FTransform::Identity).GetScale3D().GetAbsMax(); // R|[lgWłTransform̃XP[
+			float Scale = GetSnapshotBoneScale(Bone.BoneRef.BoneIndex); // R|[lgWłTransform̃XP[
 			FVector VectorScale(Scale);
 
 			FTransform BoneTM = FTransform(Bone.Rotation, Bone.Location);
@@ -756,43 +1776,47 @@ void FAnimNode_KawaiiPhysics::AdjustBySphereCollision(const USkeletalMeshCompone
 
 				FVector SphereShapeLocation = ElemTM.GetLocation();
 
-				for (auto& Sphere : Limits)
+				for (const int32 LimitIndex : LimitIndices)
 				{
-					if (Sphere.Radius <= 0.0f)
+					const FSphericalLimit& Sphere = Limits[LimitIndex];
+					const FVector& SphereLocation = Instances ? Instances[LimitIndex].Location : Sphere.Location;
+
+					if (Sphere.Radius <= 0.0f || (Sphere.CollisionGroup & Bone.CollisionMask) == 0)
 					{
 						continue;
 					}
 
+					++NumPairsTested;
 					FVector PushOutVector = FVector::ZeroVector;
 
 					float LimitDistance = SphereShape.Radius + Sphere.Radius;
 					if (Sphere.LimitType == ESphericalLimitType::Outer)
 					{
-						if ((SphereShapeLocation - Sphere.Location).SizeSquared() > LimitDistance * LimitDistance)
+						if ((SphereShapeLocation - SphereLocation).SizeSquared() > LimitDistance * LimitDistance)
 						{
 							continue;
 						}
 						else
 						{
-							PushOutVector = (LimitDistance - (SphereShapeLocation - Sphere.Location).Size())
-								* (SphereShapeLocation - Sphere.Location).GetSafeNormal();
+							PushOutVector = (LimitDistance - (SphereShapeLocation - SphereLocation).Size())
+								* (SphereShapeLocation - SphereLocation).GetSafeNormal();
 						}
 					}
 					else
 					{
-						if ((SphereShapeLocation - Sphere.Location).SizeSquared() < LimitDistance * LimitDistance)
+						if ((SphereShapeLocation - SphereLocation).SizeSquared() < LimitDistance * LimitDistance)
 						{
 							continue;
 						}
 						else
 						{
-							if (CVarEnableOldPhysicsMethodSphereLimit.GetValueOnAnyThread() == 0)
+							if (!bOldPhysicsMethodSphereLimit)
 							{
-								PushOutVector = Sphere.Location + (Sphere.Radius - SphereShape.Radius) * (SphereShapeLocation - Sphere.Location).GetSafeNormal() - SphereShapeLocation;
+								PushOutVector = SphereLocation + (Sphere.Radius - SphereShape.Radius) * (SphereShapeLocation - SphereLocation).GetSafeNormal() - SphereShapeLocation;
 							}
 							else
 							{
-								PushOutVector = Sphere.Location + Sphere.Radius * (SphereShapeLocation - Sphere.Location).GetSafeNormal() - SphereShapeLocation;
+								PushOutVector = SphereLocation + Sphere.Radius * (SphereShapeLocation - SphereLocation).GetSafeNormal() - SphereShapeLocation;
 							}
 						}
 					}
@@ -800,41 +1824,120 @@ void FAnimNode_KawaiiPhysics::AdjustBySphereCollision(const USkeletalMeshCompone
 					SphereShapeLocation += PushOutVector;
 					// SphereShapeoꂽxNg{[ړƂPȌvZ
 					Bone.Location += PushOutVector;
+					NumPushOuts += PushOutVector.IsZero() ? 0 : 1;
 				}
 
 				// VFCvɕĂꍇAׂĂ𖞑鉟oʒu1Ce[Vł͌vZłȂ̂ŁAЂƂovZ炻őł؂
 				break;
 			}
 
-			for (int32 i = 0; i <AggGeom->BoxElems.Num(); ++i)
+			for (int32 i = 0; i < AggGeom->BoxElems.Num(); ++i)
 			{
-				FTransform ElemTM = AggGeom->BoxElems[i].GetTransform();
-				ElemTM.ScaleTranslation(VectorScale);
-				ElemTM *= BoneTM;
-				// TODO:
-			}
+				const FKBoxElem& BoxShape = AggGeom->BoxElems[i];
+				const FVector BoxShapeHalfExtent = FVector(BoxShape.X, BoxShape.Y, BoxShape.Z) * 0.5f;
 
-			for (int32 i = 0; i <AggGeom->ConvexElems.Num(); ++i)
-			{
-				FTransform ElemTM = AggGeom->ConvexElems[i].GetTransform();
+				FTransform ElemTM = BoxShape.GetTransform();
 				ElemTM.ScaleTranslation(VectorScale);
 				ElemTM *= BoneTM;
-				// TODO:
+
+				for (const int32 LimitIndex : LimitIndices)
+				{
+					const FSphericalLimit& Sphere = Limits[LimitIndex];
+					const FVector& SphereLocation = Instances ? Instances[LimitIndex].Location : Sphere.Location;
+
+					if (Sphere.Radius <= 0.0f || (Sphere.CollisionGroup & Bone.CollisionMask) == 0)
+					{
+						continue;
+					}
+
+					++NumPairsTested;
+					FVector PushOutVector = FVector::ZeroVector;
+					if (Sphere.LimitType == ESphericalLimitType::Outer)
+					{
+						// Move the box opposite to the vector which pushes the sphere out of the box
+						if (KawaiiPhysicsSolver::CalcSpherePushOutFromBox(SphereLocation, Sphere.Radius, ElemTM, BoxShapeHalfExtent, PushOutVector))
+						{
+							PushOutVector = -PushOutVector;
+						}
+					}
+					else
+					{
+						PushOutVector = KawaiiPhysicsSolver::CalcBoxPushInToSphere(ElemTM, BoxShapeHalfExtent, SphereLocation, Sphere.Radius);
+					}
+
+					ElemTM.AddToTranslation(PushOutVector);
+					Bone.Location += PushOutVector;
+					NumPushOuts += PushOutVector.IsZero() ? 0 : 1;
+				}
+
+				// Same as sphere shapes, only the first shape is used in one iteration
+				break;
 			}
 
-			for (int32 i = 0; i <AggGeom->TaperedCapsuleElems.Num(); ++i)
+			for (int32 i = 0; i < AggGeom->TaperedCapsuleElems.Num(); ++i)
 			{
-				FTransform ElemTM = AggGeom->TaperedCapsuleElems[i].GetTransform();
+				const FKTaperedCapsuleElem& TaperedCapsuleShape = AggGeom->TaperedCapsuleElems[i];
+
+				FTransform ElemTM = TaperedCapsuleShape.GetTransform();
 				ElemTM.ScaleTranslation(VectorScale);
 				ElemTM *= BoneTM;
-				// TODO:
+
+				FVector StartPoint;
+				FVector EndPoint;
+				GetTaperedCapsuleSegment(TaperedCapsuleShape, ElemTM, StartPoint, EndPoint);
+
+				for (const int32 LimitIndex : LimitIndices)
+				{
+					const FSphericalLimit& Sphere = Limits[LimitIndex];
+					const FVector& SphereLocation = Instances ? Instances[LimitIndex].Location : Sphere.Location;
+
+					if (Sphere.Radius <= 0.0f || (Sphere.CollisionGroup & Bone.CollisionMask) == 0)
+					{
+						continue;
+					}
+
+					++NumPairsTested;
+					FVector PushOutVector = FVector::ZeroVector;
+					if (Sphere.LimitType == ESphericalLimitType::Outer)
+					{
+						if (KawaiiPhysicsSolver::CalcSpherePushOutFromTaperedCapsule(SphereLocation, Sphere.Radius, StartPoint, EndPoint, TaperedCapsuleShape.Radius0, TaperedCapsuleShape.Radius1, PushOutVector))
+						{
+							PushOutVector = -PushOutVector;
+						}
+					}
+					else
+					{
+						// Keep the end which sticks out more inside of the sphere
+						const float StartPointOverDistance = (StartPoint - SphereLocation).Size() + TaperedCapsuleShape.Radius0 - Sphere.Radius;
+						const float EndPointOverDistance = (EndPoint - SphereLocation).Size() + TaperedCapsuleShape.Radius1 - Sphere.Radius;
+						if (StartPointOverDistance >= EndPointOverDistance)
+						{
+							if (StartPointOverDistance > 0.0f)
+							{
+								PushOutVector = (SphereLocation - StartPoint).GetSafeNormal() * StartPointOverDistance;
+							}
+						}
+						else if (EndPointOverDistance > 0.0f)
+						{
+							PushOutVector = (SphereLocation - EndPoint).GetSafeNormal() * EndPointOverDistance;
+						}
+					}
+
+					StartPoint += PushOutVector;
+					EndPoint += PushOutVector;
+					Bone.Location += PushOutVector;
+					NumPushOuts += PushOutVector.IsZero() ? 0 : 1;
+				}
+
+				// Same as sphere shapes, only the first shape is used in one iteration
+				break;
 			}
 		}
 
 		if (ParentBone.PhysicsBodySetup != nullptr)
 		{
 			// CapsulȅꍇParentBoneJvZ̃RWɂParentBoneBonëʒuo
-			float ParentScale = SkeletalMeshComp->GetBoneTransform(ParentBone.BoneRef.BoneIndex, FTransform::Identity).GetScale3D().GetAbsMax(); // R|[lgWłTransform̃XP[
+			float ParentScale = GetSnapshotBoneScale(ParentBone.BoneRef.BoneIndex); // R|[lgWłTransform̃XP[
 			FVector ParentVectorScale(ParentScale);
 			FTransform ParentBoneTM = FTransform(ParentBone.Rotation, ParentBone.Location);
 			FKAggregateGeom* ParentAggGeom = &ParentBone.PhysicsBodySetup->AggGeom;
@@ -854,13 +1957,17 @@ void FAnimNode_KawaiiPhysics::AdjustBySphereCollision(const USkeletalMeshCompone
 
 				FVector CapsuleShapeLocation = ElemTM.GetLocation();
 
-				for (auto& Sphere : Limits)
+				for (const int32 LimitIndex : LimitIndices)
 				{
-					if (Sphere.Radius <= 0.0f)
+					const FSphericalLimit& Sphere = Limits[LimitIndex];
+					const FVector& SphereLocation = Instances ? Instances[LimitIndex].Location : Sphere.Location;
+
+					if (Sphere.Radius <= 0.0f || (Sphere.CollisionGroup & Bone.CollisionMask) == 0)
 					{
 						continue;
 					}
 
+					++NumPairsTested;
 					FVector PushOutVector = FVector::ZeroVector;
 
 					FVector StartPoint = CapsuleShapeLocation + ElemTM.GetRotation().GetAxisZ() * Capsule.Length * 0.5f;
@@ -869,11 +1976,11 @@ void FAnimNode_KawaiiPhysics::AdjustBySphereCollision(const USkeletalMeshCompone
 					if (Sphere.LimitType == ESphericalLimitType::Outer)
 					{
 						float LimitDistance = Capsule.Radius + Sphere.Radius;
-						float DistSquared = FMath::PointDistToSegmentSquared(Sphere.Location, StartPoint, EndPoint);
+						float DistSquared = FMath::PointDistToSegmentSquared(SphereLocation, StartPoint, EndPoint);
 						if (DistSquared < LimitDistance * LimitDistance)
 						{
-							FVector ClosestPoint = FMath::ClosestPointOnSegment(Sphere.Location, StartPoint, EndPoint);
-							PushOutVector = (ClosestPoint - Sphere.Location).GetSafeNormal() * LimitDistance - (ClosestPoint - Sphere.Location);
+							FVector ClosestPoint = FMath::ClosestPointOnSegment(SphereLocation, StartPoint, EndPoint);
+							PushOutVector = (ClosestPoint - SphereLocation).GetSafeNormal() * LimitDistance - (ClosestPoint - SphereLocation);
 						}
 					}
 					else // Inner
@@ -883,20 +1990,20 @@ void FAnimNode_KawaiiPhysics::AdjustBySphereCollision(const USkeletalMeshCompone
 						// Rotation܂ŕςȂ̂ŁAȂĂu
 						if (Sphere.Radius * 2.0f > Capsule.Radius * 2.0f + Capsule.Length) // ̏̓JvZXtBAɓKvBȂꍇ͉oȂ
 						{
-							float StartPointDistSquared = (StartPoint - Sphere.Location).SizeSquared();
-							float EndPointDistSquared = (EndPoint - Sphere.Location).SizeSquared();
+							float StartPointDistSquared = (StartPoint - SphereLocation).SizeSquared();
+							float EndPointDistSquared = (EndPoint - SphereLocation).SizeSquared();
 							if (StartPointDistSquared >= EndPointDistSquared)
 							{
 								if (StartPointDistSquared > Sphere.Radius - Capsule.Radius)
 								{
-									PushOutVector = ((StartPoint - Sphere.Location).GetSafeNormal() * LimitDistance + Sphere.Location) - StartPoint;
+									PushOutVector = ((StartPoint - SphereLocation).GetSafeNormal() * LimitDistance + SphereLocation) - StartPoint;
 								}
 							}
 							else
 							{
 								if (EndPointDistSquared > Sphere.Radius - Capsule.Radius)
 								{
-									PushOutVector = ((EndPoint - Sphere.Location).GetSafeNormal() * LimitDistance + Sphere.Location) - EndPoint;
+									PushOutVector = ((EndPoint - SphereLocation).GetSafeNormal() * LimitDistance + SphereLocation) - EndPoint;
 								}
 							}
 						}
@@ -909,6 +2016,7 @@ void FAnimNode_KawaiiPhysics::AdjustBySphereCollision(const USkeletalMeshCompone
 						ParentBone.Location += PushOutVector;
 					}
 					Bone.Location += PushOutVector;
+					NumPushOuts += PushOutVector.IsZero() ? 0 : 1;
 				}
 
 				// VFCvɕĂꍇAׂĂ𖞑鉟oʒu1Ce[Vł͌vZłȂ̂ŁAЂƂovZ炻őł؂
@@ -918,27 +2026,26 @@ void FAnimNode_KawaiiPhysics::AdjustBySphereCollision(const USkeletalMeshCompone
 	}
 }
 
-void FAnimNode_KawaiiPhysics::AdjustByCapsuleCollision(const USkeletalMeshComponent* SkeletalMeshComp, FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone, TArray<FCapsuleLimit>& Limits)
+void FAnimNode_KawaiiPhysics::AdjustByCapsuleCollision(FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone, TArrayView<const FCapsuleLimit> Limits,
+	TArrayView<const int32> LimitIndices, const FKawaiiPhysicsLimitInstance* Instances)
 {
 	if (!bUsePhysicsAssetAsShapes)
 	{
-		for (auto& Capsule : Limits)
+		for (const int32 LimitIndex : LimitIndices)
 		{
-			if (Capsule.Radius <= 0 || Capsule.Length <= 0)
+			const FCapsuleLimit& Capsule = Limits[LimitIndex];
+			const FVector& CapsuleLocation = Instances ? Instances[LimitIndex].Location : Capsule.Location;
+			const FQuat& CapsuleRotation = Instances ? Instances[LimitIndex].Rotation : Capsule.Rotation;
+
+			if (Capsule.Radius <= 0 || Capsule.Length <= 0 || (Capsule.CollisionGroup & Bone.CollisionMask) == 0)
 			{
 				continue;
 			}
 
-			FVector StartPoint = Capsule.Location + Capsule.Rotation.GetAxisZ() * Capsule.Length * 0.5f;
-			FVector EndPoint = Capsule.Location + Capsule.Rotation.GetAxisZ() * Capsule.Length * -0.5f;
-			float DistSquared = FMath::PointDistToSegmentSquared(Bone.Location, StartPoint, EndPoint);
-
-			float LimitDistance = Bone.PhysicsSettings.Radius + Capsule.Radius;
-			if (DistSquared < LimitDistance * LimitDistance)
-			{
-				FVector ClosestPoint = FMath::ClosestPointOnSegment(Bone.Location, StartPoint, EndPoint);
-				Bone.Location = ClosestPoint + (Bone.Location - ClosestPoint).GetSafeNormal() * LimitDistance;
-			}
+			FVector StartPoint = CapsuleLocation + CapsuleRotation.GetAxisZ() * Capsule.Length * 0.5f;
+			FVector EndPoint = CapsuleLocation + CapsuleRotation.GetAxisZ() * Capsule.Length * -0.5f;
+			++NumPairsTested;
+			NumPushOuts += KawaiiPhysicsSolver::PushOutFromCapsule(Bone.Location, Bone.PhysicsSettings.Radius, StartPoint, EndPoint, Capsule.Radius) ? 1 : 0;
 		}
 	}
 	else
@@ -946,7 +2053,7 @@ void FAnimNode_KawaiiPhysics::AdjustByCapsuleCollision(const USkeletalMeshCompon
 		if (Bone.PhysicsBodySetup != nullptr)
 		{
 			check(Bone.BoneRef.BoneIndex != INDEX_NONE);
-			float Scale = SkeletalMeshComp->GetBoneTransform(Bone.BoneRef.BoneIndex, FTransform::Identity).GetScale3D().GetAbsMax(); // R|[lgWłTransform̃XP[
+			float Scale = GetSnapshotBoneScale(Bone.BoneRef.BoneIndex); // R|[lgWłTransform̃XP[
 			FVector VectorScale(Scale);
 
 			FTransform BoneTM = FTransform(Bone.Rotation, Bone.Location);
@@ -969,17 +2076,22 @@ void FAnimNode_KawaiiPhysics::AdjustByCapsuleCollision(const USkeletalMeshCompon
 
 				FVector SphereShapeLocation = ElemTM.GetLocation();
 
-				for (auto& Capsule : Limits)
+				for (const int32 LimitIndex : LimitIndices)
 				{
-					if (Capsule.Radius <= 0 || Capsule.Length <= 0)
+					const FCapsuleLimit& Capsule = Limits[LimitIndex];
+					const FVector& CapsuleLocation = Instances ? Instances[LimitIndex].Location : Capsule.Location;
+					const FQuat& CapsuleRotation = Instances ? Instances[LimitIndex].Rotation : Capsule.Rotation;
+
+					if (Capsule.Radius <= 0 || Capsule.Length <= 0 || (Capsule.CollisionGroup & Bone.CollisionMask) == 0)
 					{
 						continue;
 					}
 
+					++NumPairsTested;
 					FVector PushOutVector = FVector::ZeroVector;
 
-					FVector StartPoint = Capsule.Location + Capsule.Rotation.GetAxisZ() * Capsule.Length * 0.5f;
-					FVector EndPoint = Capsule.Location + Capsule.Rotation.GetAxisZ() * Capsule.Length * -0.5f;
+					FVector StartPoint = CapsuleLocation + CapsuleRotation.GetAxisZ() * Capsule.Length * 0.5f;
+					FVector EndPoint = CapsuleLocation + CapsuleRotation.GetAxisZ() * Capsule.Length * -0.5f;
 					float DistSquared = FMath::PointDistToSegmentSquared(SphereShapeLocation, StartPoint, EndPoint);
 
 					float LimitDistance = SphereShape.Radius + Capsule.Radius;
@@ -992,41 +2104,105 @@ void FAnimNode_KawaiiPhysics::AdjustByCapsuleCollision(const USkeletalMeshCompon
 					SphereShapeLocation += PushOutVector;
 					// SphereShapeoꂽxNg{[ړƂPȌvZ
 					Bone.Location += PushOutVector;
+					NumPushOuts += PushOutVector.IsZero() ? 0 : 1;
 				}
 
 				// VFCvɕĂꍇAׂĂ𖞑鉟oʒu1Ce[Vł͌vZłȂ̂ŁAЂƂovZ炻őł؂
 				break;
 			}
 
-			for (int32 i = 0; i <AggGeom->BoxElems.Num(); ++i)
+			for (int32 i = 0; i < AggGeom->BoxElems.Num(); ++i)
 			{
-				FTransform ElemTM = AggGeom->BoxElems[i].GetTransform();
-				ElemTM.ScaleTranslation(VectorScale);
-				ElemTM *= BoneTM;
-				// TODO:
-			}
+				const FKBoxElem& BoxShape = AggGeom->BoxElems[i];
+				const FVector BoxShapeHalfExtent = FVector(BoxShape.X, BoxShape.Y, BoxShape.Z) * 0.5f;
 
-			for (int32 i = 0; i <AggGeom->ConvexElems.Num(); ++i)
-			{
-				FTransform ElemTM = AggGeom->ConvexElems[i].GetTransform();
+				FTransform ElemTM = BoxShape.GetTransform();
 				ElemTM.ScaleTranslation(VectorScale);
 				ElemTM *= BoneTM;
-				// TODO:
+
+				for (const int32 LimitIndex : LimitIndices)
+				{
+					const FCapsuleLimit& Capsule = Limits[LimitIndex];
+					const FVector& CapsuleLocation = Instances ? Instances[LimitIndex].Location : Capsule.Location;
+					const FQuat& CapsuleRotation = Instances ? Instances[LimitIndex].Rotation : Capsule.Rotation;
+
+					if (Capsule.Radius <= 0 || Capsule.Length <= 0 || (Capsule.CollisionGroup & Bone.CollisionMask) == 0)
+					{
+						continue;
+					}
+
+					++NumPairsTested;
+					FVector PushOutVector = FVector::ZeroVector;
+
+					FVector StartPoint = CapsuleLocation + CapsuleRotation.GetAxisZ() * Capsule.Length * 0.5f;
+					FVector EndPoint = CapsuleLocation + CapsuleRotation.GetAxisZ() * Capsule.Length * -0.5f;
+					FVector ClosestPoint = KawaiiPhysicsSolver::ClosestPointOnSegmentToBox(StartPoint, EndPoint, ElemTM, BoxShapeHalfExtent);
+					if (KawaiiPhysicsSolver::CalcSpherePushOutFromBox(ClosestPoint, Capsule.Radius, ElemTM, BoxShapeHalfExtent, PushOutVector))
+					{
+						PushOutVector = -PushOutVector;
+					}
+
+					ElemTM.AddToTranslation(PushOutVector);
+					Bone.Location += PushOutVector;
+					NumPushOuts += PushOutVector.IsZero() ? 0 : 1;
+				}
+
+				// Same as sphere shapes, only the first shape is used in one iteration
+				break;
 			}
 
-			for (int32 i = 0; i <AggGeom->TaperedCapsuleElems.Num(); ++i)
+			for (int32 i = 0; i < AggGeom->TaperedCapsuleElems.Num(); ++i)
 			{
-				FTransform ElemTM = AggGeom->TaperedCapsuleElems[i].GetTransform();
+				const FKTaperedCapsuleElem& TaperedCapsuleShape = AggGeom->TaperedCapsuleElems[i];
+
+				FTransform ElemTM = TaperedCapsuleShape.GetTransform();
 				ElemTM.ScaleTranslation(VectorScale);
 				ElemTM *= BoneTM;
-				// TODO:
+
+				FVector StartPoint;
+				FVector EndPoint;
+				GetTaperedCapsuleSegment(TaperedCapsuleShape, ElemTM, StartPoint, EndPoint);
+
+				for (const int32 LimitIndex : LimitIndices)
+				{
+					const FCapsuleLimit& Capsule = Limits[LimitIndex];
+					const FVector& CapsuleLocation = Instances ? Instances[LimitIndex].Location : Capsule.Location;
+					const FQuat& CapsuleRotation = Instances ? Instances[LimitIndex].Rotation : Capsule.Rotation;
+
+					if (Capsule.Radius <= 0 || Capsule.Length <= 0 || (Capsule.CollisionGroup & Bone.CollisionMask) == 0)
+					{
+						continue;
+					}
+
+					++NumPairsTested;
+					FVector PushOutVector = FVector::ZeroVector;
+
+					FVector CapsuleStartPoint = CapsuleLocation + CapsuleRotation.GetAxisZ() * Capsule.Length * 0.5f;
+					FVector CapsuleEndPoint = CapsuleLocation + CapsuleRotation.GetAxisZ() * Capsule.Length * -0.5f;
+
+					FVector CapsuleClosestPoint;
+					FVector TaperedCapsuleClosestPoint;
+					FMath::SegmentDistToSegmentSafe(CapsuleStartPoint, CapsuleEndPoint, StartPoint, EndPoint, CapsuleClosestPoint, TaperedCapsuleClosestPoint);
+					if (KawaiiPhysicsSolver::CalcSpherePushOutFromTaperedCapsule(CapsuleClosestPoint, Capsule.Radius, StartPoint, EndPoint, TaperedCapsuleShape.Radius0, TaperedCapsuleShape.Radius1, PushOutVector))
+					{
+						PushOutVector = -PushOutVector;
+					}
+
+					StartPoint += PushOutVector;
+					EndPoint += PushOutVector;
+					Bone.Location += PushOutVector;
+					NumPushOuts += PushOutVector.IsZero() ? 0 : 1;
+				}
+
+				// Same as sphere shapes, only the first shape is used in one iteration
+				break;
 			}
 		}
 
 		if (ParentBone.PhysicsBodySetup != nullptr)
 		{
 			// CapsulȅꍇParentBoneJvZ̃RWɂParentBoneBonëʒuo
-			float ParentShapeScale = SkeletalMeshComp->GetBoneTransform(ParentBone.BoneRef.BoneIndex, FTransform::Identity).GetScale3D().GetAbsMax(); // R|[lgWłTransform̃XP[
+			float ParentShapeScale = GetSnapshotBoneScale(ParentBone.BoneRef.BoneIndex); // R|[lgWłTransform̃XP[
 			FVector ParentShapeVectorScale(ParentShapeScale);
 			FTransform ParentShapeBoneTM = FTransform(ParentBone.Rotation, ParentBone.Location);
 			FKAggregateGeom* ParentShapeAggGeom = &ParentBone.PhysicsBodySetup->AggGeom;
@@ -1046,20 +2222,25 @@ void FAnimNode_KawaiiPhysics::AdjustByCapsuleCollision(const USkeletalMeshCompon
 
 				FVector CapsuleShapeLocation = ElemTM.GetLocation();
 
-				for (auto& Capsule : Limits)
+				for (const int32 LimitIndex : LimitIndices)
 				{
-					if (Capsule.Radius <= 0 || Capsule.Length <= 0)
+					const FCapsuleLimit& Capsule = Limits[LimitIndex];
+					const FVector& CapsuleLocation = Instances ? Instances[LimitIndex].Location : Capsule.Location;
+					const FQuat& CapsuleRotation = Instances ? Instances[LimitIndex].Rotation : Capsule.Rotation;
+
+					if (Capsule.Radius <= 0 || Capsule.Length <= 0 || (Capsule.CollisionGroup & Bone.CollisionMask) == 0)
 					{
 						continue;
 					}
 
+					++NumPairsTested;
 					FVector PushOutVector = FVector::ZeroVector;
 
 					FVector CapsuleShapeStartPoint = CapsuleShapeLocation + ElemTM.GetRotation().GetAxisZ() * CapsuleShape.Length * 0.5f;
 					FVector CapsuleShapeEndPoint = CapsuleShapeLocation + ElemTM.GetRotation().GetAxisZ() * CapsuleShape.Length * -0.5f;
 
-					FVector CapsuleStartPoint = Capsule.Location + Capsule.Rotation.GetAxisZ() * Capsule.Length * 0.5f;
-					FVector CapsuleEndPoint = Capsule.Location + Capsule.Rotation.GetAxisZ() * Capsule.Length * -0.5f;
+					FVector CapsuleStartPoint = CapsuleLocation + CapsuleRotation.GetAxisZ() * Capsule.Length * 0.5f;
+					FVector CapsuleEndPoint = CapsuleLocation + CapsuleRotation.GetAxisZ() * Capsule.Length * -0.5f;
 
 					FVector CapsuleShapeClosestPoint;
 					FVector CapsuleClosestPoint;
@@ -1079,6 +2260,7 @@ void FAnimNode_KawaiiPhysics::AdjustByCapsuleCollision(const USkeletalMeshCompon
 						ParentBone.Location += PushOutVector;
 					}
 					Bone.Location += PushOutVector;
+					NumPushOuts += PushOutVector.IsZero() ? 0 : 1;
 				}
 
 				// VFCvɕĂꍇAׂĂ𖞑鉟oʒu1Ce[Vł͌vZłȂ̂ŁAЂƂovZ炻őł؂
@@ -1088,22 +2270,24 @@ void FAnimNode_KawaiiPhysics::AdjustByCapsuleCollision(const USkeletalMeshCompon
 	}
 }
 
-void FAnimNode_KawaiiPhysics::AdjustByPlanerCollision(const USkeletalMeshComponent* SkeletalMeshComp, FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone, TArray<FPlanarLimit>& Limits)
+void FAnimNode_KawaiiPhysics::AdjustByPlanerCollision(FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone, TArrayView<const FPlanarLimit> Limits,
+	TArrayView<const int32> LimitIndices, const FKawaiiPhysicsLimitInstance* Instances)
 {
 	if (!bUsePhysicsAssetAsShapes)
 	{
-		for (auto& Planar : Limits)
+		for (const int32 LimitIndex : LimitIndices)
 		{
-			FVector PointOnPlane = FVector::PointPlaneProject(Bone.Location, Planar.Plane);
-			float DistSquared = (Bone.Location - PointOnPlane).SizeSquared();
+			const FPlanarLimit& Planar = Limits[LimitIndex];
+			const FPlane& PlanarPlane = Instances ? Instances[LimitIndex].Plane : Planar.Plane;
+			const FQuat& PlanarRotation = Instances ? Instances[LimitIndex].Rotation : Planar.Rotation;
 
-			FVector IntersectionPoint;
-			if (DistSquared < Bone.PhysicsSettings.Radius * Bone.PhysicsSettings.Radius ||
-				FMath::SegmentPlaneIntersection(Bone.Location, Bone.PrevLocation, Planar.Plane, IntersectionPoint))
+			if ((Planar.CollisionGroup & Bone.CollisionMask) == 0)
 			{
-				Bone.Location = PointOnPlane + Planar.Rotation.GetUpVector() * Bone.PhysicsSettings.Radius;
 				continue;
 			}
+
+			++NumPairsTested;
+			NumPushOuts += KawaiiPhysicsSolver::PushOutFromPlane(Bone.Location, Bone.PrevLocation, Bone.PhysicsSettings.Radius, PlanarPlane, PlanarRotation.GetUpVector()) ? 1 : 0;
 		}
 	}
 	else
@@ -1111,7 +2295,7 @@ void FAnimNode_KawaiiPhysics::AdjustByPlanerCollision(const USkeletalMeshCompone
 		if (Bone.PhysicsBodySetup != nullptr)
 		{
 			check(Bone.BoneRef.BoneIndex != INDEX_NONE);
-			float Scale = SkeletalMeshComp->GetBoneTransform(Bone.BoneRef.BoneIndex, FTransform::Identity).GetScale3D().GetAbsMax(); // R|[lgWłTransform̃XP[
+			float Scale = GetSnapshotBoneScale(Bone.BoneRef.BoneIndex); // R|[lgWłTransform̃XP[
 			FVector VectorScale(Scale);
 
 			FTransform BoneTM = FTransform(Bone.Rotation, Bone.Location);
@@ -1134,58 +2318,125 @@ void FAnimNode_KawaiiPhysics::AdjustByPlanerCollision(const USkeletalMeshCompone
 
 				FVector SphereShapeLocation = ElemTM.GetLocation();
 
-				for (auto& Planar : Limits)
+				for (const int32 LimitIndex : LimitIndices)
 				{
+					const FPlanarLimit& Planar = Limits[LimitIndex];
+					const FPlane& PlanarPlane = Instances ? Instances[LimitIndex].Plane : Planar.Plane;
+					const FQuat& PlanarRotation = Instances ? Instances[LimitIndex].Rotation : Planar.Rotation;
+
+					if ((Planar.CollisionGroup & Bone.CollisionMask) == 0)
+					{
+						continue;
+					}
+
+					++NumPairsTested;
 					FVector PushOutVector = FVector::ZeroVector;
 
-					FVector PointOnPlane = FVector::PointPlaneProject(SphereShapeLocation, Planar.Plane);
+					FVector PointOnPlane = FVector::PointPlaneProject(SphereShapeLocation, PlanarPlane);
 					float DistSquared = (SphereShapeLocation - PointOnPlane).SizeSquared();
 
 					FVector IntersectionPoint;
 					if (DistSquared < SphereShape.Radius * SphereShape.Radius ||
-						FMath::SegmentPlaneIntersection(SphereShapeLocation, Bone.PrevLocation, Planar.Plane, IntersectionPoint)) // TODO:ђʔ肾AXtBAVFCv̑Ot[̈ʒu͋L^ĂȂ̂łƂ肠{[̑Ot[̈ʒugĂ
+						FMath::SegmentPlaneIntersection(SphereShapeLocation, Bone.PrevLocation, PlanarPlane, IntersectionPoint)) // TODO:ђʔ肾AXtBAVFCv̑Ot[̈ʒu͋L^ĂȂ̂łƂ肠{[̑Ot[̈ʒugĂ
 					{
-						PushOutVector = PointOnPlane + Planar.Rotation.GetUpVector() * SphereShape.Radius - SphereShapeLocation;
+						PushOutVector = PointOnPlane + PlanarRotation.GetUpVector() * SphereShape.Radius - SphereShapeLocation;
 					}
 
 					SphereShapeLocation += PushOutVector;
 					// SphereShapeoꂽxNg{[ړƂPȌvZ
 					Bone.Location += PushOutVector;
+					NumPushOuts += PushOutVector.IsZero() ? 0 : 1;
 				}
 
 				// VFCvɕĂꍇAׂĂ𖞑鉟oʒu1Ce[Vł͌vZłȂ̂ŁAЂƂovZ炻őł؂
 				break;
 			}
 
-			for (int32 i = 0; i <AggGeom->BoxElems.Num(); ++i)
+			for (int32 i = 0; i < AggGeom->BoxElems.Num(); ++i)
 			{
-				FTransform ElemTM = AggGeom->BoxElems[i].GetTransform();
-				ElemTM.ScaleTranslation(VectorScale);
-				ElemTM *= BoneTM;
-				// TODO:
-			}
+				const FKBoxElem& BoxShape = AggGeom->BoxElems[i];
+				const FVector BoxShapeHalfExtent = FVector(BoxShape.X, BoxShape.Y, BoxShape.Z) * 0.5f;
 
-			for (int32 i = 0; i <AggGeom->ConvexElems.Num(); ++i)
-			{
-				FTransform ElemTM = AggGeom->ConvexElems[i].GetTransform();
+				FTransform ElemTM = BoxShape.GetTransform();
 				ElemTM.ScaleTranslation(VectorScale);
 				ElemTM *= BoneTM;
-				// TODO:
+
+				for (const int32 LimitIndex : LimitIndices)
+				{
+					const FPlanarLimit& Planar = Limits[LimitIndex];
+					const FPlane& PlanarPlane = Instances ? Instances[LimitIndex].Plane : Planar.Plane;
+					const FQuat& PlanarRotation = Instances ? Instances[LimitIndex].Rotation : Planar.Rotation;
+
+					if ((Planar.CollisionGroup & Bone.CollisionMask) == 0)
+					{
+						continue;
+					}
+
+					++NumPairsTested;
+					FVector PushOutVector = FVector::ZeroVector;
+
+					float Penetration = KawaiiPhysicsSolver::CalcBoxPlanePenetration(ElemTM, BoxShapeHalfExtent, PlanarPlane);
+					if (Penetration > 0.0f)
+					{
+						PushOutVector = PlanarRotation.GetUpVector() * Penetration;
+					}
+
+					ElemTM.AddToTranslation(PushOutVector);
+					Bone.Location += PushOutVector;
+					NumPushOuts += PushOutVector.IsZero() ? 0 : 1;
+				}
+
+				// Same as sphere shapes, only the first shape is used in one iteration
+				break;
 			}
 
-			for (int32 i = 0; i <AggGeom->TaperedCapsuleElems.Num(); ++i)
+			for (int32 i = 0; i < AggGeom->TaperedCapsuleElems.Num(); ++i)
 			{
-				FTransform ElemTM = AggGeom->TaperedCapsuleElems[i].GetTransform();
+				const FKTaperedCapsuleElem& TaperedCapsuleShape = AggGeom->TaperedCapsuleElems[i];
+
+				FTransform ElemTM = TaperedCapsuleShape.GetTransform();
 				ElemTM.ScaleTranslation(VectorScale);
 				ElemTM *= BoneTM;
-				// TODO:
+
+				FVector StartPoint;
+				FVector EndPoint;
+				GetTaperedCapsuleSegment(TaperedCapsuleShape, ElemTM, StartPoint, EndPoint);
+
+				for (const int32 LimitIndex : LimitIndices)
+				{
+					const FPlanarLimit& Planar = Limits[LimitIndex];
+					const FPlane& PlanarPlane = Instances ? Instances[LimitIndex].Plane : Planar.Plane;
+					const FQuat& PlanarRotation = Instances ? Instances[LimitIndex].Rotation : Planar.Rotation;
+
+					if ((Planar.CollisionGroup & Bone.CollisionMask) == 0)
+					{
+						continue;
+					}
+
+					++NumPairsTested;
+					FVector PushOutVector = FVector::ZeroVector;
+
+					float Penetration = FMath::Max(TaperedCapsuleShape.Radius0 - PlanarPlane.PlaneDot(StartPoint), TaperedCapsuleShape.Radius1 - PlanarPlane.PlaneDot(EndPoint));
+					if (Penetration > 0.0f)
+					{
+						PushOutVector = PlanarRotation.GetUpVector() * Penetration;
+					}
+
+					StartPoint += PushOutVector;
+					EndPoint += PushOutVector;
+					Bone.Location += PushOutVector;
+					NumPushOuts += PushOutVector.IsZero() ? 0 : 1;
+				}
+
+				// Same as sphere shapes, only the first shape is used in one iteration
+				break;
 			}
 		}
 
 		if (ParentBone.PhysicsBodySetup != nullptr)
 		{
 			// CapsulȅꍇParentBoneJvZ̃RWɂParentBoneBonëʒuo
-			float ParentShapeScale = SkeletalMeshComp->GetBoneTransform(ParentBone.BoneRef.BoneIndex, FTransform::Identity).GetScale3D().GetAbsMax(); // R|[lgWłTransform̃XP[
+			float ParentShapeScale = GetSnapshotBoneScale(ParentBone.BoneRef.BoneIndex); // R|[lgWłTransform̃XP[
 			FVector ParentShapeVectorScale(ParentShapeScale);
 			FTransform ParentShapeBoneTM = FTransform(ParentBone.Rotation, ParentBone.Location);
 			FKAggregateGeom* ParentShapeAggGeom = &ParentBone.PhysicsBodySetup->AggGeom;
@@ -1205,20 +2456,30 @@ void FAnimNode_KawaiiPhysics::AdjustByPlanerCollision(const USkeletalMeshCompone
 
 				FVector CapsuleShapeLocation = ElemTM.GetLocation();
 
-				for (auto& Planar : Limits)
+				for (const int32 LimitIndex : LimitIndices)
 				{
+					const FPlanarLimit& Planar = Limits[LimitIndex];
+					const FPlane& PlanarPlane = Instances ? Instances[LimitIndex].Plane : Planar.Plane;
+					const FQuat& PlanarRotation = Instances ? Instances[LimitIndex].Rotation : Planar.Rotation;
+
+					if ((Planar.CollisionGroup & Bone.CollisionMask) == 0)
+					{
+						continue;
+					}
+
+					++NumPairsTested;
 					FVector StartPushOutVector = FVector::ZeroVector;
 					FVector EndPushOutVector = FVector::ZeroVector;
 
 					FVector CapsuleShapeStartPoint = CapsuleShapeLocation + ElemTM.GetRotation().GetAxisZ() * CapsuleShape.Length * 0.5f;
 					FVector CapsuleShapeEndPoint = CapsuleShapeLocation + ElemTM.GetRotation().GetAxisZ() * CapsuleShape.Length * -0.5f;
 
-					FVector StartPointOnPlane = FVector::PointPlaneProject(CapsuleShapeStartPoint, Planar.Plane);
-					FVector EndPointOnPlane = FVector::PointPlaneProject(CapsuleShapeEndPoint, Planar.Plane);
+					FVector StartPointOnPlane = FVector::PointPlaneProject(CapsuleShapeStartPoint, PlanarPlane);
+					FVector EndPointOnPlane = FVector::PointPlaneProject(CapsuleShapeEndPoint, PlanarPlane);
 
 					// XtBÂƂƈđx͍lⓚpɉoBStartEndłĂoB
-					float StartDotProduct = FVector::DotProduct(CapsuleShapeStartPoint - StartPointOnPlane, Planar.Rotation.GetUpVector());
-					float EndDotProduct = FVector::DotProduct(CapsuleShapeEndPoint - EndPointOnPlane, Planar.Rotation.GetUpVector());
+					float StartDotProduct = FVector::DotProduct(CapsuleShapeStartPoint - StartPointOnPlane, PlanarRotation.GetUpVector());
+					float EndDotProduct = FVector::DotProduct(CapsuleShapeEndPoint - EndPointOnPlane, PlanarRotation.GetUpVector());
 					if (StartDotProduct < CapsuleShape.Radius)
 					{
 						StartPushOutVector = StartPointOnPlane + (StartPointOnPlane - CapsuleShapeStartPoint).GetSafeNormal() * CapsuleShape.Radius - CapsuleShapeStartPoint;
@@ -1236,12 +2497,13 @@ void FAnimNode_KawaiiPhysics::AdjustByPlanerCollision(const USkeletalMeshCompone
 						ParentBone.Location += StartPushOutVector;
 					}
 					Bone.Location += EndPushOutVector;
+					NumPushOuts += StartPushOutVector.IsZero() && EndPushOutVector.IsZero() ? 0 : 1;
 
 					// CapsuleStartEndŉoႤ̂ŁAJvZPlaneɐ2LocationɂȂ{[̒␳ŖɂȂ̂œK
 					// Plane̕ʕɂ炵Ă
 					if ((ParentBone.Location - Bone.Location).SizeSquared() < KINDA_SMALL_NUMBER)
 					{
-						Bone.Location += Planar.Rotation.GetRightVector() * EndPushOutVector.Size() * 0.2f; // EndPushOutVector.Size() * 0.2f͓KȒݒ
+						Bone.Location += PlanarRotation.GetRightVector() * EndPushOutVector.Size() * 0.2f; // EndPushOutVector.Size() * 0.2f͓KȒݒ
 					}
 				}
 
@@ -1252,9 +2514,87 @@ void FAnimNode_KawaiiPhysics::AdjustByPlanerCollision(const USkeletalMeshCompone
 	}
 }
 
-void FAnimNode_KawaiiPhysics::AdjustByPhysicsAssetCollision(const USkeletalMeshComponent* SkeletalMeshComp, FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone)
+void FAnimNode_KawaiiPhysics::AdjustBySDFCollision(FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone, TArray<FSDFLimit>& Limits, TArrayView<const int32> LimitIndices)
+{
+	if (!bUsePhysicsAssetAsShapes)
+	{
+		for (const int32 LimitIndex : LimitIndices)
+		{
+			FSDFLimit& SDF = Limits[LimitIndex];
+			if (SDF.SDFDataAsset == nullptr || (SDF.CollisionGroup & Bone.CollisionMask) == 0)
+			{
+				continue;
+			}
+
+			++NumPairsTested;
+			FVector Gradient;
+			float Distance = SDF.SDFDataAsset->SampleDistance(SDF.Rotation.UnrotateVector(Bone.Location - SDF.Location), Gradient);
+			if (Distance < Bone.PhysicsSettings.Radius)
+			{
+				Bone.Location += SDF.Rotation.RotateVector(Gradient.GetSafeNormal()) * (Bone.PhysicsSettings.Radius - Distance);
+				++NumPushOuts;
+			}
+		}
+	}
+	else
+	{
+		if (Bone.PhysicsBodySetup != nullptr)
+		{
+			check(Bone.BoneRef.BoneIndex != INDEX_NONE);
+			float Scale = GetSnapshotBoneScale(Bone.BoneRef.BoneIndex);
+			FVector VectorScale(Scale);
+
+			FTransform BoneTM = FTransform(Bone.Rotation, Bone.Location);
+
+			FKAggregateGeom* AggGeom = &Bone.PhysicsBodySetup->AggGeom;
+
+			for (int32 i = 0; i < AggGeom->SphereElems.Num(); ++i)
+			{
+				const FKSphereElem& SphereShape = AggGeom->SphereElems[i];
+
+				if (SphereShape.Radius <= 0.0f)
+				{
+					continue;
+				}
+
+				FTransform ElemTM = SphereShape.GetTransform();
+				ElemTM.ScaleTranslation(VectorScale);
+				ElemTM *= BoneTM;
+
+				FVector SphereShapeLocation = ElemTM.GetLocation();
+
+				for (const int32 LimitIndex : LimitIndices)
+				{
+					FSDFLimit& SDF = Limits[LimitIndex];
+					if (SDF.SDFDataAsset == nullptr || (SDF.CollisionGroup & Bone.CollisionMask) == 0)
+					{
+						continue;
+					}
+
+					++NumPairsTested;
+					FVector Gradient;
+					float Distance = SDF.SDFDataAsset->SampleDistance(SDF.Rotation.UnrotateVector(SphereShapeLocation - SDF.Location), Gradient);
+					if (Distance < SphereShape.Radius)
+					{
+						FVector PushOutVector = SDF.Rotation.RotateVector(Gradient.GetSafeNormal()) * (SphereShape.Radius - Distance);
+						SphereShapeLocation += PushOutVector;
+						Bone.Location += PushOutVector;
+						++NumPushOuts;
+					}
+				}
+
+				// Same as other limits, only the first sphere shape is used
+				break;
+			}
+		}
+	}
+}
+
+void FAnimNode_KawaiiPhysics::AdjustByPhysicsAssetCollision(FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone)
 {
-	if (!bUsePhysicsAssetAsLimits || UsePhysicsAssetAsLimits == nullptr)
+	// Bodies are snapshotted in PreUpdate. Skip until the snapshot matches the asset
+	if (!bUsePhysicsAssetAsLimits || UsePhysicsAssetAsLimits == nullptr ||
+		InputSnapshot.LimitBodyTransforms.Num() != UsePhysicsAssetAsLimits->SkeletalBodySetups.Num())
 	{
 		return;
 	}
@@ -1267,11 +2607,11 @@ void FAnimNode_KawaiiPhysics::AdjustByPhysicsAssetCollision(const USkeletalMeshC
 			{
 				continue;
 			}
-			int32 BoneIndex = SkeletalMeshComp->GetBoneIndex(UsePhysicsAssetAsLimits->SkeletalBodySetups[i]->BoneName);
+			const int32 BoneIndex = InputSnapshot.LimitBodyBoneIndices[i];
 
 			if (BoneIndex != INDEX_NONE)
 			{
-				FTransform BoneTM = SkeletalMeshComp->GetBoneTransform(BoneIndex, FTransform::Identity); // R|[lgWłTransform
+				FTransform BoneTM = InputSnapshot.LimitBodyTransforms[i]; // R|[lgWłTransform
 				float Scale = BoneTM.GetScale3D().GetAbsMax();
 				FVector VectorScale(Scale);
 				BoneTM.RemoveScaling();
@@ -1292,25 +2632,25 @@ void FAnimNode_KawaiiPhysics::AdjustByPhysicsAssetCollision(const USkeletalMeshC
 					ElemTM.ScaleTranslation(VectorScale);
 					ElemTM *= BoneTM;
 
-					const FVector& SphereLocation = ElemTM.GetLocation();
-					float LimitDistance = Bone.PhysicsSettings.Radius + Sphere.Radius;
-					if ((Bone.Location - SphereLocation).SizeSquared() > LimitDistance * LimitDistance)
-					{
-						continue;
-					}
-					else
-					{
-						Bone.Location += (LimitDistance - (Bone.Location - SphereLocation).Size())
-							* (Bone.Location - SphereLocation).GetSafeNormal();
-					}
+					++NumPairsTested;
+					NumPushOuts += KawaiiPhysicsSolver::PushOutFromSphere(Bone.Location, Bone.PhysicsSettings.Radius, ElemTM.GetLocation(), Sphere.Radius) ? 1 : 0;
 				}
 
-				for (int32 j = 0; j <AggGeom->BoxElems.Num(); ++j)
+				for (int32 j = 0; j < AggGeom->BoxElems.Num(); ++j)
 				{
-					FTransform ElemTM = AggGeom->BoxElems[j].GetTransform();
+					const FKBoxElem& Box = AggGeom->BoxElems[j];
+
+					FTransform ElemTM = Box.GetTransform();
 					ElemTM.ScaleTranslation(VectorScale);
 					ElemTM *= BoneTM;
-					// TODO:
+
+					++NumPairsTested;
+					FVector PushOutVector;
+					if (KawaiiPhysicsSolver::CalcSpherePushOutFromBox(Bone.Location, Bone.PhysicsSettings.Radius, ElemTM, FVector(Box.X, Box.Y, Box.Z) * 0.5f, PushOutVector))
+					{
+						Bone.Location += PushOutVector;
+						++NumPushOuts;
+					}
 				}
 
 				for (int32 j = 0; j <AggGeom->SphylElems.Num(); ++j)
@@ -1329,30 +2669,30 @@ void FAnimNode_KawaiiPhysics::AdjustByPhysicsAssetCollision(const USkeletalMeshC
 					const FVector& CapsuleLocation = ElemTM.GetLocation();
 					FVector StartPoint = CapsuleLocation + ElemTM.GetUnitAxis(EAxis::Type::Z) * Capsule.Length * 0.5f;
 					FVector EndPoint = CapsuleLocation + ElemTM.GetUnitAxis(EAxis::Type::Z) * Capsule.Length * -0.5f;
-					float DistSquared = FMath::PointDistToSegmentSquared(Bone.Location, StartPoint, EndPoint);
 
-					float LimitDistance = Bone.PhysicsSettings.Radius + Capsule.Radius;
-					if (DistSquared < LimitDistance * LimitDistance)
-					{
-						FVector ClosestPoint = FMath::ClosestPointOnSegment(Bone.Location, StartPoint, EndPoint);
-						Bone.Location = ClosestPoint + (Bone.Location - ClosestPoint).GetSafeNormal() * LimitDistance;
-					}
+					++NumPairsTested;
+					NumPushOuts += KawaiiPhysicsSolver::PushOutFromCapsule(Bone.Location, Bone.PhysicsSettings.Radius, StartPoint, EndPoint, Capsule.Radius) ? 1 : 0;
 				}
 
-				for (int32 j = 0; j <AggGeom->ConvexElems.Num(); ++j)
+				for (int32 j = 0; j < AggGeom->TaperedCapsuleElems.Num(); ++j)
 				{
-					FTransform ElemTM = AggGeom->ConvexElems[j].GetTransform();
-					ElemTM.ScaleTranslation(VectorScale);
-					ElemTM *= BoneTM;
-					// TODO:
-				}
+					const FKTaperedCapsuleElem& Capsule = AggGeom->TaperedCapsuleElems[j];
 
-				for (int32 j = 0; j <AggGeom->TaperedCapsuleElems.Num(); ++j)
-				{
-					FTransform ElemTM = AggGeom->TaperedCapsuleElems[j].GetTransform();
+					FTransform ElemTM = Capsule.GetTransform();
 					ElemTM.ScaleTranslation(VectorScale);
 					ElemTM *= BoneTM;
-					// TODO:
+
+					FVector StartPoint;
+					FVector EndPoint;
+					GetTaperedCapsuleSegment(Capsule, ElemTM, StartPoint, EndPoint);
+
+					++NumPairsTested;
+					FVector PushOutVector;
+					if (KawaiiPhysicsSolver::CalcSpherePushOutFromTaperedCapsule(Bone.Location, Bone.PhysicsSettings.Radius, StartPoint, EndPoint, Capsule.Radius0, Capsule.Radius1, PushOutVector))
+					{
+						Bone.Location += PushOutVector;
+						++NumPushOuts;
+					}
 				}
 			}
 		}
@@ -1362,7 +2702,7 @@ void FAnimNode_KawaiiPhysics::AdjustByPhysicsAssetCollision(const USkeletalMeshC
 		if (Bone.PhysicsBodySetup != nullptr)
 		{
 			check(Bone.BoneRef.BoneIndex != INDEX_NONE);
-			float ShapeScale = SkeletalMeshComp->GetBoneTransform(Bone.BoneRef.BoneIndex, FTransform::Identity).GetScale3D().GetAbsMax(); // R|[lgWłTransform̃XP[
+			float ShapeScale = GetSnapshotBoneScale(Bone.BoneRef.BoneIndex); // R|[lgWłTransform̃XP[
 			FVector ShapeVectorScale(ShapeScale);
 
 			FTransform ShapeBoneTM = FTransform(Bone.Rotation, Bone.Location);
@@ -1391,13 +2731,13 @@ void FAnimNode_KawaiiPhysics::AdjustByPhysicsAssetCollision(const USkeletalMeshC
 					{
 						continue;
 					}
-					int32 BoneIndex = SkeletalMeshComp->GetBoneIndex(UsePhysicsAssetAsLimits->SkeletalBodySetups[j]->BoneName);
+					const int32 BoneIndex = InputSnapshot.LimitBodyBoneIndices[j];
 
 					if (BoneIndex != INDEX_NONE)
 					{
 						// RWĂ{[V~[VΏۂŉoŃ{[ăRWƂɂȂ̂
 						// ̃t[ł̉o̓RẄʒuɔfȂ
-						FTransform BoneTM = SkeletalMeshComp->GetBoneTransform(BoneIndex, FTransform::Identity); // R|[lgWłTransform
+						FTransform BoneTM = InputSnapshot.LimitBodyTransforms[j]; // R|[lgWłTransform
 						float Scale = BoneTM.GetScale3D().GetAbsMax();
 						FVector VectorScale(Scale);
 						BoneTM.RemoveScaling();
@@ -1419,6 +2759,7 @@ void FAnimNode_KawaiiPhysics::AdjustByPhysicsAssetCollision(const USkeletalMeshC
 							ElemTM *= BoneTM;
 							const FVector& SphereLocation = ElemTM.GetLocation();
 
+							++NumPairsTested;
 							FVector PushOutVector = FVector::ZeroVector;
 
 							float LimitDistance = SphereShape.Radius + Sphere.Radius;
@@ -1436,14 +2777,25 @@ void FAnimNode_KawaiiPhysics::AdjustByPhysicsAssetCollision(const USkeletalMeshC
 							// SphereShapeoꂽxNg{[ړƂPȌvZ
 							// TODO:SphereShapeɑ΂ĂЂƂȂ܂AɂȂĂƖ傫
 							Bone.Location += PushOutVector;
+							NumPushOuts += PushOutVector.IsZero() ? 0 : 1;
 						}
 
-						for (int32 k = 0; k <AggGeom->BoxElems.Num(); ++k)
+						for (int32 k = 0; k < AggGeom->BoxElems.Num(); ++k)
 						{
-							FTransform ElemTM = AggGeom->BoxElems[k].GetTransform();
+							const FKBoxElem& Box = AggGeom->BoxElems[k];
+
+							FTransform ElemTM = Box.GetTransform();
 							ElemTM.ScaleTranslation(VectorScale);
 							ElemTM *= BoneTM;
-							// TODO:
+
+							++NumPairsTested;
+							FVector PushOutVector;
+							if (KawaiiPhysicsSolver::CalcSpherePushOutFromBox(SphereShapeLocation, SphereShape.Radius, ElemTM, FVector(Box.X, Box.Y, Box.Z) * 0.5f, PushOutVector))
+							{
+								SphereShapeLocation += PushOutVector;
+								Bone.Location += PushOutVector;
+								++NumPushOuts;
+							}
 						}
 
 						for (int32 k = 0; k <AggGeom->SphylElems.Num(); ++k)
@@ -1459,6 +2811,7 @@ void FAnimNode_KawaiiPhysics::AdjustByPhysicsAssetCollision(const USkeletalMeshC
 							ElemTM.ScaleTranslation(VectorScale);
 							ElemTM *= BoneTM;
 
+							++NumPairsTested;
 							FVector PushOutVector = FVector::ZeroVector;
 
 							const FVector& CapsuleLocation = ElemTM.GetLocation();
@@ -1476,22 +2829,29 @@ void FAnimNode_KawaiiPhysics::AdjustByPhysicsAssetCollision(const USkeletalMeshC
 							SphereShapeLocation += PushOutVector;
 							// SphereShapeoꂽxNg{[ړƂPȌvZ
 							Bone.Location += PushOutVector;
+							NumPushOuts += PushOutVector.IsZero() ? 0 : 1;
 						}
 
-						for (int32 k = 0; k <AggGeom->ConvexElems.Num(); ++k)
+						for (int32 k = 0; k < AggGeom->TaperedCapsuleElems.Num(); ++k)
 						{
-							FTransform ElemTM = AggGeom->ConvexElems[k].GetTransform();
-							ElemTM.ScaleTranslation(VectorScale);
-							ElemTM *= BoneTM;
-							// TODO:
-						}
+							const FKTaperedCapsuleElem& Capsule = AggGeom->TaperedCapsuleElems[k];
 
-						for (int32 k = 0; k <AggGeom->TaperedCapsuleElems.Num(); ++k)
-						{
-							FTransform ElemTM = AggGeom->TaperedCapsuleElems[k].GetTransform();
+							FTransform ElemTM = Capsule.GetTransform();
 							ElemTM.ScaleTranslation(VectorScale);
 							ElemTM *= BoneTM;
-							// TODO:
+
+							FVector StartPoint;
+							FVector EndPoint;
+							GetTaperedCapsuleSegment(Capsule, ElemTM, StartPoint, EndPoint);
+
+							++NumPairsTested;
+							FVector PushOutVector;
+							if (KawaiiPhysicsSolver::CalcSpherePushOutFromTaperedCapsule(SphereShapeLocation, SphereShape.Radius, StartPoint, EndPoint, Capsule.Radius0, Capsule.Radius1, PushOutVector))
+							{
+								SphereShapeLocation += PushOutVector;
+								Bone.Location += PushOutVector;
+								++NumPushOuts;
+							}
 						}
 					}
 				}
@@ -1499,36 +2859,12 @@ void FAnimNode_KawaiiPhysics::AdjustByPhysicsAssetCollision(const USkeletalMeshC
 				// VFCvɕĂꍇAׂĂ𖞑鉟oʒu1Ce[Vł͌vZłȂ̂ŁAЂƂovZ炻őł؂
 				break;
 			}
-
-			for (int32 i = 0; i <ShapeAggGeom->BoxElems.Num(); ++i)
-			{
-				FTransform SphereShapeElemTM = ShapeAggGeom->BoxElems[i].GetTransform();
-				SphereShapeElemTM.ScaleTranslation(ShapeVectorScale);
-				SphereShapeElemTM *= ShapeBoneTM;
-				// TODO:
-			}
-
-			for (int32 i = 0; i <ShapeAggGeom->ConvexElems.Num(); ++i)
-			{
-				FTransform SphereShapeElemTM = ShapeAggGeom->ConvexElems[i].GetTransform();
-				SphereShapeElemTM.ScaleTranslation(ShapeVectorScale);
-				SphereShapeElemTM *= ShapeBoneTM;
-				// TODO:
-			}
-
-			for (int32 i = 0; i <ShapeAggGeom->TaperedCapsuleElems.Num(); ++i)
-			{
-				FTransform SphereShapeElemTM = ShapeAggGeom->TaperedCapsuleElems[i].GetTransform();
-				SphereShapeElemTM.ScaleTranslation(ShapeVectorScale);
-				SphereShapeElemTM *= ShapeBoneTM;
-				// TODO:
-			}
 		}
 
 		if (ParentBone.PhysicsBodySetup != nullptr)
 		{
 			// CapsulȅꍇParentBoneJvZ̃RWɂParentBoneBonëʒuo
-			float ParentShapeScale = SkeletalMeshComp->GetBoneTransform(ParentBone.BoneRef.BoneIndex, FTransform::Identity).GetScale3D().GetAbsMax(); // R|[lgWłTransform̃XP[
+			float ParentShapeScale = GetSnapshotBoneScale(ParentBone.BoneRef.BoneIndex); // R|[lgWłTransform̃XP[
 			FVector ParentShapeVectorScale(ParentShapeScale);
 			FTransform ParentShapeBoneTM = FTransform(ParentBone.Rotation, ParentBone.Location);
 			FKAggregateGeom* ParentShapeAggGeom = &ParentBone.PhysicsBodySetup->AggGeom;
@@ -1554,14 +2890,14 @@ void FAnimNode_KawaiiPhysics::AdjustByPhysicsAssetCollision(const USkeletalMeshC
 					{
 						continue;
 					}
-					int32 BoneIndex = SkeletalMeshComp->GetBoneIndex(UsePhysicsAssetAsLimits->SkeletalBodySetups[j]->BoneName);
+					const int32 BoneIndex = InputSnapshot.LimitBodyBoneIndices[j];
 
 					if (BoneIndex != INDEX_NONE)
 					{
 						// RWĂ{[V~[VΏۂŉoŃ{[ăRWƂɂȂ̂
 						// ̃t[ł̉o̓RẄʒuɔfȂ
-						FTransform BoneTM = SkeletalMeshComp->GetBoneTransform(BoneIndex, FTransform::Identity); // R|[lgWłTransform
-						float Scale = SkeletalMeshComp->GetBoneTransform(BoneIndex, FTransform::Identity).GetScale3D().GetAbsMax();
+						FTransform BoneTM = InputSnapshot.LimitBodyTransforms[j]; // R|[lgWłTransform
+						float Scale = BoneTM.GetScale3D().GetAbsMax();
 						FVector VectorScale(Scale);
 						BoneTM.RemoveScaling();
 
@@ -1582,6 +2918,7 @@ void FAnimNode_KawaiiPhysics::AdjustByPhysicsAssetCollision(const USkeletalMeshC
 							ElemTM *= BoneTM;
 							const FVector& SphereLocation = ElemTM.GetLocation();
 
+							++NumPairsTested;
 							FVector PushOutVector = FVector::ZeroVector;
 
 							FVector StartPoint = CapsuleShapeLocation + ElemTM.GetRotation().GetAxisZ() * CapsuleShape.Length * 0.5f;
@@ -1602,14 +2939,34 @@ void FAnimNode_KawaiiPhysics::AdjustByPhysicsAssetCollision(const USkeletalMeshC
 								ParentBone.Location += PushOutVector;
 							}
 							Bone.Location += PushOutVector;
+							NumPushOuts += PushOutVector.IsZero() ? 0 : 1;
 						}
 
-						for (int32 k = 0; k <AggGeom->BoxElems.Num(); ++k)
+						for (int32 k = 0; k < AggGeom->BoxElems.Num(); ++k)
 						{
-							FTransform ElemTM = AggGeom->BoxElems[k].GetTransform();
+							const FKBoxElem& Box = AggGeom->BoxElems[k];
+							const FVector BoxHalfExtent = FVector(Box.X, Box.Y, Box.Z) * 0.5f;
+
+							FTransform ElemTM = Box.GetTransform();
 							ElemTM.ScaleTranslation(VectorScale);
 							ElemTM *= BoneTM;
-							// TODO:
+
+							FVector CapsuleShapeStartPoint = CapsuleShapeLocation + CapsuleShapeElemTM.GetRotation().GetAxisZ() * CapsuleShape.Length * 0.5f;
+							FVector CapsuleShapeEndPoint = CapsuleShapeLocation + CapsuleShapeElemTM.GetRotation().GetAxisZ() * CapsuleShape.Length * -0.5f;
+							FVector CapsuleShapeClosestPoint = KawaiiPhysicsSolver::ClosestPointOnSegmentToBox(CapsuleShapeStartPoint, CapsuleShapeEndPoint, ElemTM, BoxHalfExtent);
+
+							++NumPairsTested;
+							FVector PushOutVector;
+							if (KawaiiPhysicsSolver::CalcSpherePushOutFromBox(CapsuleShapeClosestPoint, CapsuleShape.Radius, ElemTM, BoxHalfExtent, PushOutVector))
+							{
+								CapsuleShapeLocation += PushOutVector;
+								if (ParentBone.ParentIndex >= 0)
+								{
+									ParentBone.Location += PushOutVector;
+								}
+								Bone.Location += PushOutVector;
+								++NumPushOuts;
+							}
 						}
 
 						for (int32 k = 0; k <AggGeom->SphylElems.Num(); ++k)
@@ -1626,6 +2983,7 @@ void FAnimNode_KawaiiPhysics::AdjustByPhysicsAssetCollision(const USkeletalMeshC
 							ElemTM *= BoneTM;
 							const FVector& CapsuleLocation = ElemTM.GetLocation();
 
+							++NumPairsTested;
 							FVector PushOutVector = FVector::ZeroVector;
 
 							FVector CapsuleShapeStartPoint = CapsuleShapeLocation + CapsuleShapeElemTM.GetRotation().GetAxisZ() * CapsuleShape.Length * 0.5f;
@@ -1652,22 +3010,40 @@ void FAnimNode_KawaiiPhysics::AdjustByPhysicsAssetCollision(const USkeletalMeshC
 								ParentBone.Location += PushOutVector;
 							}
 							Bone.Location += PushOutVector;
+							NumPushOuts += PushOutVector.IsZero() ? 0 : 1;
 						}
 
-						for (int32 k = 0; k <AggGeom->ConvexElems.Num(); ++k)
+						for (int32 k = 0; k < AggGeom->TaperedCapsuleElems.Num(); ++k)
 						{
-							FTransform ElemTM = AggGeom->ConvexElems[k].GetTransform();
-							ElemTM.ScaleTranslation(VectorScale);
-							ElemTM *= BoneTM;
-							// TODO:
-						}
+							const FKTaperedCapsuleElem& Capsule = AggGeom->TaperedCapsuleElems[k];
 
-						for (int32 k = 0; k <AggGeom->TaperedCapsuleElems.Num(); ++k)
-						{
-							FTransform ElemTM = AggGeom->TaperedCapsuleElems[k].GetTransform();
+							FTransform ElemTM = Capsule.GetTransform();
 							ElemTM.ScaleTranslation(VectorScale);
 							ElemTM *= BoneTM;
-							// TODO:
+
+							FVector CapsuleStartPoint;
+							FVector CapsuleEndPoint;
+							GetTaperedCapsuleSegment(Capsule, ElemTM, CapsuleStartPoint, CapsuleEndPoint);
+
+							FVector CapsuleShapeStartPoint = CapsuleShapeLocation + CapsuleShapeElemTM.GetRotation().GetAxisZ() * CapsuleShape.Length * 0.5f;
+							FVector CapsuleShapeEndPoint = CapsuleShapeLocation + CapsuleShapeElemTM.GetRotation().GetAxisZ() * CapsuleShape.Length * -0.5f;
+
+							FVector CapsuleShapeClosestPoint;
+							FVector CapsuleClosestPoint;
+							FMath::SegmentDistToSegmentSafe(CapsuleShapeStartPoint, CapsuleShapeEndPoint, CapsuleStartPoint, CapsuleEndPoint, CapsuleShapeClosestPoint, CapsuleClosestPoint);
+
+							++NumPairsTested;
+							FVector PushOutVector;
+							if (KawaiiPhysicsSolver::CalcSpherePushOutFromTaperedCapsule(CapsuleShapeClosestPoint, CapsuleShape.Radius, CapsuleStartPoint, CapsuleEndPoint, Capsule.Radius0, Capsule.Radius1, PushOutVector))
+							{
+								CapsuleShapeLocation += PushOutVector;
+								if (ParentBone.ParentIndex >= 0)
+								{
+									ParentBone.Location += PushOutVector;
+								}
+								Bone.Location += PushOutVector;
+								++NumPushOuts;
+							}
 						}
 					}
 				}
@@ -1679,50 +3055,201 @@ void FAnimNode_KawaiiPhysics::AdjustByPhysicsAssetCollision(const USkeletalMeshC
 	}
 }
 
-void FAnimNode_KawaiiPhysics::AdjustByAngleLimit(FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer, FTransform& ComponentTransform, 
-	FKawaiiPhysicsModifyBone& Bone, FKawaiiPhysicsModifyBone& ParentBone)
+void FAnimNode_KawaiiPhysics::AdjustByAngleLimit(FKawaiiPhysicsModifyBone& Bone, FKawaiiPhysicsModifyBone& ParentBone)
 {
 	if (Bone.PhysicsSettings.LimitAngle == 0.0f)
 	{
 		return;
 	}
 
-	FVector BoneDir = (Bone.Location - ParentBone.Location).GetSafeNormal();
-	FVector PoseDir = (Bone.PoseLocation - ParentBone.PoseLocation).GetSafeNormal();
-	FVector Axis = FVector::CrossProduct(PoseDir, BoneDir);
-	float Angle = FMath::Atan2(Axis.Size(), FVector::DotProduct(PoseDir, BoneDir));
-	float AngleOverLimit= FMath::RadiansToDegrees(Angle) - Bone.PhysicsSettings.LimitAngle;
-
-	if (AngleOverLimit > 0.0f)
-	{
-		BoneDir = BoneDir.RotateAngleAxis(-AngleOverLimit, Axis);
-		Bone.Location = BoneDir * (Bone.Location - ParentBone.Location).Size() + ParentBone.Location;
-	}
+	KawaiiPhysicsSolver::ApplyAngleLimit(Bone.Location, ParentBone.Location, Bone.PoseLocation, ParentBone.PoseLocation, Bone.PhysicsSettings.LimitAngle);
 }
 
 void FAnimNode_KawaiiPhysics::AdjustByPlanarConstraint(FKawaiiPhysicsModifyBone& Bone, FKawaiiPhysicsModifyBone& ParentBone)
 {
-	FPlane Plane;
+	FVector PlaneNormal;
 	if (PlanarConstraint != EPlanarConstraint::None)
 	{
 		switch (PlanarConstraint)
 		{
 		case EPlanarConstraint::X:
-			Plane = FPlane(ParentBone.Location, ParentBone.PoseRotation.GetAxisX());
+			PlaneNormal = ParentBone.PoseRotation.GetAxisX();
 			break;
 		case EPlanarConstraint::Y:
-			Plane = FPlane(ParentBone.Location, ParentBone.PoseRotation.GetAxisY());
+			PlaneNormal = ParentBone.PoseRotation.GetAxisY();
 			break;
 		case EPlanarConstraint::Z:
-			Plane = FPlane(ParentBone.Location, ParentBone.PoseRotation.GetAxisZ());
+			PlaneNormal = ParentBone.PoseRotation.GetAxisZ();
+			break;
+		}
+		Bone.Location = KawaiiPhysicsSolver::ApplyPlanarConstraint(Bone.Location, ParentBone.Location, PlaneNormal);
+	}
+}
+
+DECLARE_CYCLE_STAT(TEXT("Self Collision"), STAT_KawaiiPhysics_SelfCollision, STATGROUP_KawaiiPhysics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Self Collision Pairs Tested"), STAT_KawaiiPhysics_SelfCollisionPairsTested, STATGROUP_KawaiiPhysics);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Self Collision Pairs Resolved"), STAT_KawaiiPhysics_SelfCollisionPairsResolved, STATGROUP_KawaiiPhysics);
+
+void FAnimNode_KawaiiPhysics::AdjustBySelfCollision()
+{
+	KAWAIIPHYSICS_SCOPE_PHASE(SelfCollision);
+
+	const int32 NumBones = ModifyBones.Num();
+	SelfCollisionLocations.SetNumUninitialized(NumBones, false);
+
+	float MaxRadius = 0.0f;
+	for (int32 i = 0; i < NumBones; ++i)
+	{
+		SelfCollisionLocations[i] = ModifyBones[i].Location;
+		MaxRadius = FMath::Max(MaxRadius, ModifyBones[i].PhysicsSettings.Radius);
+	}
+	if (MaxRadius <= 0.0f)
+	{
+		return;
+	}
+
+	// Overlapping bones are always in the same or neighbor cells when the cell size is the max diameter
+	const float InvCellSize = 0.5f / MaxRadius;
+	SelfCollisionCellHeads.Reset();
+	SelfCollisionNextIndices.SetNumUninitialized(NumBones, false);
+	SelfCollisionCells.SetNumUninitialized(NumBones, false);
+	for (int32 i = 0; i < NumBones; ++i)
+	{
+		const FKawaiiPhysicsModifyBone& Bone = ModifyBones[i];
+		SelfCollisionNextIndices[i] = INDEX_NONE;
+		if ((Bone.BoneRef.BoneIndex < 0 && !Bone.bDummy) || Bone.PhysicsSettings.Radius <= 0.0f)
+		{
+			continue;
+		}
+
+		const FVector& Location = SelfCollisionLocations[i];
+		const FIntVector Cell(FMath::FloorToInt(Location.X * InvCellSize), FMath::FloorToInt(Location.Y * InvCellSize), FMath::FloorToInt(Location.Z * InvCellSize));
+		SelfCollisionCells[i] = Cell;
+
+		if (int32* Head = SelfCollisionCellHeads.Find(Cell))
+		{
+			SelfCollisionNextIndices[i] = *Head;
+			*Head = i;
+		}
+		else
+		{
+			SelfCollisionCellHeads.Add(Cell, i);
+		}
+	}
+
+	// Start from the bone where the budget ran out last frame, so that every bone gets tested over a few frames
+	if (SelfCollisionStartIndex >= NumBones)
+	{
+		SelfCollisionStartIndex = 0;
+	}
+
+	int32 PairsTested = 0;
+	int32 PairsResolved = 0;
+	int32 NextStartIndex = SelfCollisionStartIndex;
+	for (int32 Count = 0; Count < NumBones; ++Count)
+	{
+		const int32 i = (SelfCollisionStartIndex + Count) % NumBones;
+		if (PairsTested >= SelfCollisionMaxPairs)
+		{
+			NextStartIndex = i;
 			break;
 		}
-		Bone.Location  = FVector::PointPlaneProject(Bone.Location, Plane);
+
+		const FKawaiiPhysicsModifyBone& Bone = ModifyBones[i];
+		if ((Bone.BoneRef.BoneIndex < 0 && !Bone.bDummy) || Bone.PhysicsSettings.Radius <= 0.0f)
+		{
+			continue;
+		}
+
+		for (int32 Neighbor = 0; Neighbor < 27 && PairsTested < SelfCollisionMaxPairs; ++Neighbor)
+		{
+			const FIntVector Cell = SelfCollisionCells[i] + FIntVector(Neighbor % 3 - 1, (Neighbor / 3) % 3 - 1, Neighbor / 9 - 1);
+			const int32* Head = SelfCollisionCellHeads.Find(Cell);
+			for (int32 j = Head ? *Head : INDEX_NONE; j != INDEX_NONE && PairsTested < SelfCollisionMaxPairs; j = SelfCollisionNextIndices[j])
+			{
+				// Test each pair once, and ignore bones near in the hierarchy which are always close to each other
+				const FKawaiiPhysicsModifyBone& OtherBone = ModifyBones[j];
+				if (j <= i || IsWithinSelfCollisionIgnoreHops(i, j))
+				{
+					continue;
+				}
+				++PairsTested;
+
+				const FVector Delta = SelfCollisionLocations[j] - SelfCollisionLocations[i];
+				const float LimitDistance = Bone.PhysicsSettings.Radius + OtherBone.PhysicsSettings.Radius;
+				const float DistSquared = Delta.SizeSquared();
+				if (DistSquared >= LimitDistance * LimitDistance || DistSquared <= SMALL_NUMBER)
+				{
+					continue;
+				}
+
+				// Root bones follow the pose, so the other bone takes all of the push out
+				const float Weight = Bone.ParentIndex < 0 ? 0.0f : (OtherBone.ParentIndex < 0 ? 1.0f : 0.5f);
+				const float Dist = FMath::Sqrt(DistSquared);
+				const FVector PushOutVector = Delta * ((LimitDistance - Dist) / Dist);
+				SelfCollisionLocations[i] -= PushOutVector * Weight;
+				SelfCollisionLocations[j] += PushOutVector * (1.0f - Weight);
+				++PairsResolved;
+			}
+		}
 	}
+
+	SelfCollisionStartIndex = NextStartIndex;
+
+	KAWAIIPHYSICS_INC_COUNTER(SelfCollisionPairsTested, PairsTested);
+	KAWAIIPHYSICS_INC_COUNTER(SelfCollisionPairsResolved, PairsResolved);
+	NumPairsTested += PairsTested;
+	NumPushOuts += PairsResolved;
+
+	if (PairsResolved == 0)
+	{
+		return;
+	}
+
+	// Self collision must not push bones into the limits or over the angle limit.
+	// Re-apply them after the push out. Parents are always before their children in ModifyBones
+	for (int32 i = 0; i < NumBones; ++i)
+	{
+		FKawaiiPhysicsModifyBone& Bone = ModifyBones[i];
+		if (Bone.ParentIndex < 0 || (Bone.BoneRef.BoneIndex < 0 && !Bone.bDummy))
+		{
+			continue;
+		}
+
+		FKawaiiPhysicsModifyBone& ParentBone = ModifyBones[Bone.ParentIndex];
+		Bone.Location = SelfCollisionLocations[i];
+		AdjustByCollisionLimits(ParentBone, Bone);
+		AdjustByConstraints(Bone, ParentBone);
+	}
+}
+
+bool FAnimNode_KawaiiPhysics::IsWithinSelfCollisionIgnoreHops(int32 BoneIndexA, int32 BoneIndexB) const
+{
+	// Walk up to the common ancestor. Parents are always before their children in ModifyBones,
+	// so the bone with the larger index is never the ancestor of the other
+	int32 Hops = 0;
+	while (BoneIndexA != BoneIndexB)
+	{
+		if (++Hops > SelfCollisionIgnoreHops)
+		{
+			return false;
+		}
+
+		int32& Deeper = BoneIndexA > BoneIndexB ? BoneIndexA : BoneIndexB;
+		Deeper = ModifyBones[Deeper].ParentIndex;
+		if (Deeper < 0)
+		{
+			// Different root bones
+			return false;
+		}
+	}
+	return true;
 }
 
 void FAnimNode_KawaiiPhysics::ApplySimuateResult(FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer, TArray<FBoneTransform>& OutBoneTransforms)
 {
+	KAWAIIPHYSICS_SCOPE_PHASE(Apply);
+
 	for (int i = 0; i < ModifyBones.Num(); ++i)
 	{
 		OutBoneTransforms.Add(FBoneTransform(ModifyBones[i].BoneRef.GetCompactPoseIndex(BoneContainer), 
@@ -1770,4 +3297,399 @@ void FAnimNode_KawaiiPhysics::ApplySimuateResult(FComponentSpacePoseContext& Out
 
 	// for check in FCSPose<PoseType>::LocalBlendCSBoneTransforms
 	OutBoneTransforms.Sort(FCompareBoneTransformIndex());
-}
\ No newline at end of file
+}
+
+void FAnimNode_KawaiiPhysics::ApplyExtrapolatedResult(FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer, TArray<FBoneTransform>& OutBoneTransforms, float ExtrapolationTime)
+{
+	// Extrapolate the last simulated step keeping the bone length. Collisions are not checked.
+	// Simulated locations are restored after applying so that the next step continues from them with DeltaTimeOld
+	const float VelocityScale = DeltaTimeOld > 0.0f ? ExtrapolationTime / DeltaTimeOld : 0.0f;
+	SimulatedLocations.SetNumUninitialized(ModifyBones.Num());
+
+	for (int i = 0; i < ModifyBones.Num(); ++i)
+	{
+		FKawaiiPhysicsModifyBone& Bone = ModifyBones[i];
+		SimulatedLocations[i] = Bone.Location;
+
+		if (Bone.ParentIndex < 0)
+		{
+			Bone.Location = Bone.PoseLocation;
+			continue;
+		}
+
+		const FKawaiiPhysicsModifyBone& ParentBone = ModifyBones[Bone.ParentIndex];
+		const FVector ExtrapolatedLocation = Bone.Location + (Bone.Location - Bone.PrevLocation) * VelocityScale;
+		Bone.Location = KawaiiPhysicsSolver::RestoreBoneLength(ExtrapolatedLocation, ParentBone.Location, (Bone.PoseLocation - ParentBone.PoseLocation).Size());
+	}
+
+	ApplySimuateResult(Output, BoneContainer, OutBoneTransforms);
+
+	for (int i = 0; i < ModifyBones.Num(); ++i)
+	{
+		ModifyBones[i].Location = SimulatedLocations[i];
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+void FAnimNode_KawaiiPhysics::CaptureInput(const FTransform& ComponentTransform)
+{
+	const FString CaptureDirectory = CVarCaptureDirectory.GetValueOnAnyThread();
+	if (CaptureDirectory.IsEmpty())
+	{
+		CaptureWriter.Reset();
+		return;
+	}
+
+	if (!CaptureWriter.IsValid())
+	{
+		static FThreadSafeCounter CaptureCounter;
+		const FString Filename = FPaths::Combine(CaptureDirectory, FString::Printf(TEXT("KawaiiPhysics_%s_%s_%d.kpcap"),
+			*FDateTime::Now().ToString(), *RootBone.BoneName.ToString(), CaptureCounter.Increment()));
+
+		// Keep the writer even if it failed to open so that it isn't retried every frame
+		CaptureWriter = MakeShared<FKawaiiPhysicsCaptureWriter>();
+		CaptureWriter->Open(*Filename);
+	}
+	if (!CaptureWriter->IsOpen())
+	{
+		return;
+	}
+
+	// Settings are compared with the last written ones by the writer, because pins may change them in any frame
+	FKawaiiPhysicsCaptureSettings Settings;
+	Settings.TargetFramerate = TargetFramerate;
+	Settings.Gravity = Gravity;
+	Settings.TeleportDistanceThreshold = TeleportDistanceThreshold;
+	Settings.TeleportRotationThreshold = TeleportRotationThreshold;
+	Settings.bOldPhysicsMethodGravity = bOldPhysicsMethodGravity;
+	Settings.bOldPhysicsMethodSphereLimit = bOldPhysicsMethodSphereLimit;
+	Settings.bUseDelayMode = bUseDelayMode;
+	Settings.BoneForwardAxis = (uint8)BoneForwardAxis;
+	Settings.PlanarConstraint = (uint8)PlanarConstraint;
+	Settings.bEnableWind = bEnableWind;
+	Settings.WindScale = WindScale;
+	Settings.bEnableSelfCollision = bEnableSelfCollision;
+	Settings.SelfCollisionMaxPairs = SelfCollisionMaxPairs;
+	Settings.SelfCollisionIgnoreHops = SelfCollisionIgnoreHops;
+	Settings.bUsePhysicsAssetAsShapes = bUsePhysicsAssetAsShapes && PhysicsAssetAsShapes;
+	Settings.PhysicsAssetAsShapes = Settings.bUsePhysicsAssetAsShapes ? PhysicsAssetAsShapes->GetPathName() : FString();
+	Settings.bUsePhysicsAssetAsLimits = bUsePhysicsAssetAsLimits && UsePhysicsAssetAsLimits;
+	Settings.PhysicsAssetAsLimits = Settings.bUsePhysicsAssetAsLimits ? UsePhysicsAssetAsLimits->GetPathName() : FString();
+	for (const FSDFLimit& SDF : SDFLimits)
+	{
+		Settings.SDFDataAssets.Add(SDF.SDFDataAsset ? SDF.SDFDataAsset->GetPathName() : FString());
+	}
+	// Limits of the data asset follow the limits of the node in the frames. Reachable indices are in ascending order
+	auto AddCulledLimits = [](TArrayView<const int32> ReachableIndices, int32 NumLimits, int32 FirstIndex, TArray<int32>& OutCulledIndices)
+	{
+		int32 ReachableIndex = 0;
+		for (int32 i = 0; i < NumLimits; ++i)
+		{
+			if (ReachableIndices.IsValidIndex(ReachableIndex) && ReachableIndices[ReachableIndex] == i)
+			{
+				++ReachableIndex;
+			}
+			else
+			{
+				OutCulledIndices.Add(FirstIndex + i);
+			}
+		}
+	};
+	Settings.Bones.Reserve(ModifyBones.Num());
+	for (const FKawaiiPhysicsModifyBone& Bone : ModifyBones)
+	{
+		FKawaiiPhysicsCaptureBone& CaptureBone = Settings.Bones.AddDefaulted_GetRef();
+		CaptureBone.ParentIndex = Bone.ParentIndex;
+		CaptureBone.CollisionMask = Bone.CollisionMask;
+		CaptureBone.BoneIndex = Bone.BoneRef.BoneIndex;
+		CaptureBone.bDummy = Bone.bDummy;
+		CaptureBone.Damping = Bone.PhysicsSettings.Damping;
+		CaptureBone.WorldDampingLocation = Bone.PhysicsSettings.WorldDampingLocation;
+		CaptureBone.WorldDampingRotation = Bone.PhysicsSettings.WorldDampingRotation;
+		CaptureBone.Stiffness = Bone.PhysicsSettings.Stiffness;
+		CaptureBone.DelayAlpha = Bone.PhysicsSettings.DelayAlpha;
+		CaptureBone.Radius = Bone.PhysicsSettings.Radius;
+		CaptureBone.LimitAngle = Bone.PhysicsSettings.LimitAngle;
+		CaptureBone.LengthFromRoot = Bone.LengthFromRoot;
+		CaptureBone.PhysicsBodyIndex = Bone.PhysicsBodySetup && Settings.bUsePhysicsAssetAsShapes ?
+			PhysicsAssetAsShapes->SkeletalBodySetups.IndexOfByKey(Bone.PhysicsBodySetup) : INDEX_NONE;
+
+		const FKawaiiPhysicsReachableLimits& ReachableLimits = Bone.ReachableLimits;
+		AddCulledLimits(ReachableLimits.Spherical, SphericalLimits.Num(), 0, CaptureBone.CulledSpheres);
+		AddCulledLimits(ReachableLimits.SphericalData, GetSphericalLimitsData().Num(), SphericalLimits.Num(), CaptureBone.CulledSpheres);
+		AddCulledLimits(ReachableLimits.Capsule, CapsuleLimits.Num(), 0, CaptureBone.CulledCapsules);
+		AddCulledLimits(ReachableLimits.CapsuleData, GetCapsuleLimitsData().Num(), CapsuleLimits.Num(), CaptureBone.CulledCapsules);
+		AddCulledLimits(ReachableLimits.Planar, PlanarLimits.Num(), 0, CaptureBone.CulledPlanes);
+		AddCulledLimits(ReachableLimits.PlanarData, GetPlanarLimitsData().Num(), PlanarLimits.Num(), CaptureBone.CulledPlanes);
+		AddCulledLimits(ReachableLimits.SDF, SDFLimits.Num(), 0, CaptureBone.CulledSDFs);
+	}
+	const bool bSettingsWritten = CaptureWriter->WriteSettings(Settings);
+
+	FKawaiiPhysicsCaptureFrame Frame;
+	Frame.DeltaTime = DeltaTime;
+	Frame.ComponentTransform = ComponentTransform;
+	Frame.WindSeed = WindRandomStream.GetCurrentSeed();
+	Frame.PoseLocations.Reserve(ModifyBones.Num());
+	Frame.PoseRotations.Reserve(ModifyBones.Num());
+	for (const FKawaiiPhysicsModifyBone& Bone : ModifyBones)
+	{
+		Frame.PoseLocations.Add(Bone.PoseLocation);
+		Frame.PoseRotations.Add(Bone.PoseRotation);
+	}
+	Frame.WindVelocities = InputSnapshot.WindVelocities;
+	Frame.BoneScales = InputSnapshot.BoneScales;
+	Frame.LimitBodyBoneIndices = InputSnapshot.LimitBodyBoneIndices;
+	Frame.LimitBodyTransforms = InputSnapshot.LimitBodyTransforms;
+
+	// State of the simulation when the replay can't continue from the last frame:
+	// the first frame, new settings, or frames between which were not simulated or not captured
+	if (bSettingsWritten || CaptureLastFrameCounter + 1 != GFrameCounter)
+	{
+		FKawaiiPhysicsCaptureState& State = Frame.State;
+		State.PreComponentTransform = PreSkelCompTransform;
+		State.DeltaTimeOld = DeltaTimeOld;
+		State.SelfCollisionStartIndex = SelfCollisionStartIndex;
+		State.Locations.Reserve(ModifyBones.Num());
+		State.PrevLocations.Reserve(ModifyBones.Num());
+		for (const FKawaiiPhysicsModifyBone& Bone : ModifyBones)
+		{
+			State.Locations.Add(Bone.Location);
+			State.PrevLocations.Add(Bone.PrevLocation);
+		}
+	}
+	CaptureLastFrameCounter = GFrameCounter;
+
+	// Transforms of the limits of the data asset are in the instances
+	auto CaptureSpheres = [&Frame](TArrayView<const FSphericalLimit> Limits, const FKawaiiPhysicsLimitInstance* Instances)
+	{
+		for (int32 i = 0; i < Limits.Num(); ++i)
+		{
+			const FSphericalLimit& Limit = Limits[i];
+			FKawaiiPhysicsCaptureSphere& Sphere = Frame.Spheres.AddDefaulted_GetRef();
+			Sphere.Location = Instances ? Instances[i].Location : Limit.Location;
+			Sphere.Radius = Limit.Radius;
+			Sphere.CollisionGroup = Limit.CollisionGroup;
+			Sphere.bInner = Limit.LimitType == ESphericalLimitType::Inner;
+		}
+	};
+	auto CaptureCapsules = [&Frame](TArrayView<const FCapsuleLimit> Limits, const FKawaiiPhysicsLimitInstance* Instances)
+	{
+		for (int32 i = 0; i < Limits.Num(); ++i)
+		{
+			const FCapsuleLimit& Limit = Limits[i];
+			FKawaiiPhysicsCaptureCapsule& Capsule = Frame.Capsules.AddDefaulted_GetRef();
+			Capsule.Location = Instances ? Instances[i].Location : Limit.Location;
+			Capsule.Rotation = Instances ? Instances[i].Rotation : Limit.Rotation;
+			Capsule.Radius = Limit.Radius;
+			Capsule.Length = Limit.Length;
+			Capsule.CollisionGroup = Limit.CollisionGroup;
+		}
+	};
+	auto CapturePlanes = [&Frame](TArrayView<const FPlanarLimit> Limits, const FKawaiiPhysicsLimitInstance* Instances)
+	{
+		for (int32 i = 0; i < Limits.Num(); ++i)
+		{
+			const FPlanarLimit& Limit = Limits[i];
+			FKawaiiPhysicsCapturePlane& Plane = Frame.Planes.AddDefaulted_GetRef();
+			Plane.Location = Instances ? Instances[i].Location : Limit.Location;
+			Plane.Rotation = Instances ? Instances[i].Rotation : Limit.Rotation;
+			Plane.CollisionGroup = Limit.CollisionGroup;
+		}
+	};
+	CaptureSpheres(SphericalLimits, nullptr);
+	CaptureSpheres(GetSphericalLimitsData(), GetLimitsDataInstances(ECollisionLimitType::Spherical));
+	CaptureCapsules(CapsuleLimits, nullptr);
+	CaptureCapsules(GetCapsuleLimitsData(), GetLimitsDataInstances(ECollisionLimitType::Capsule));
+	CapturePlanes(PlanarLimits, nullptr);
+	CapturePlanes(GetPlanarLimitsData(), GetLimitsDataInstances(ECollisionLimitType::Planar));
+
+	// Data assets of SDF limits are in the settings in the same order
+	for (const FSDFLimit& Limit : SDFLimits)
+	{
+		FKawaiiPhysicsCaptureSDF& SDF = Frame.SDFs.AddDefaulted_GetRef();
+		SDF.Location = Limit.Location;
+		SDF.Rotation = Limit.Rotation;
+		SDF.CollisionGroup = Limit.CollisionGroup;
+	}
+
+	CaptureWriter->WriteFrame(Frame);
+}
+
+void FAnimNode_KawaiiPhysics::AddDebugCostSample(float Microseconds)
+{
+	DebugCostSamples[DebugCostNextSample] = Microseconds;
+	DebugCostNextSample = (DebugCostNextSample + 1) % DebugCostWindowSize;
+	DebugCostNumSamples = FMath::Min(DebugCostNumSamples + 1, DebugCostWindowSize);
+}
+
+void FAnimNode_KawaiiPhysics::GetDebugCost(float& OutAverageMicroseconds, float& OutPeakMicroseconds) const
+{
+	OutAverageMicroseconds = 0.0f;
+	OutPeakMicroseconds = 0.0f;
+	for (int32 i = 0; i < DebugCostNumSamples; ++i)
+	{
+		OutAverageMicroseconds += DebugCostSamples[i];
+		OutPeakMicroseconds = FMath::Max(OutPeakMicroseconds, DebugCostSamples[i]);
+	}
+	if (DebugCostNumSamples > 0)
+	{
+		OutAverageMicroseconds /= DebugCostNumSamples;
+	}
+}
+
+void FAnimNode_KawaiiPhysics::DumpDebugCost(FOutputDevice& Ar) const
+{
+	const USkeletalMeshComponent* SkelMeshComp = DebugSkelMeshComp.Get();
+	const AActor* Owner = SkelMeshComp ? SkelMeshComp->GetOwner() : nullptr;
+	const UObject* AnimInstance = DebugAnimInstance.Get();
+
+	float AverageCost = 0.0f;
+	float PeakCost = 0.0f;
+	GetDebugCost(AverageCost, PeakCost);
+
+	const TCHAR* PhysicsAssetMode = bUsePhysicsAssetAsShapes ? (bUsePhysicsAssetAsLimits ? TEXT("Shapes+Limits") : TEXT("Shapes")) : (bUsePhysicsAssetAsLimits ? TEXT("Limits") : TEXT("None"));
+	const int32 NumPhysicsAssetBodies = bUsePhysicsAssetAsLimits && UsePhysicsAssetAsLimits ? UsePhysicsAssetAsLimits->SkeletalBodySetups.Num() : 0;
+
+	Ar.Logf(TEXT("%s (%s) Root:%s Bones:%d Spherical:%d Capsule:%d Planar:%d SDF:%d PhysicsAssetBodies:%d PhysicsAsset:%s TargetFramerate:%d LOD:%d Tier:%s Significance:%.3f Avg:%.1fus Peak:%.1fus"),
+		Owner ? *Owner->GetName() : TEXT("None"),
+		AnimInstance ? *AnimInstance->GetClass()->GetName() : TEXT("None"),
+		*RootBone.BoneName.ToString(),
+		ModifyBones.Num(),
+		SphericalLimits.Num() + GetSphericalLimitsData().Num(),
+		CapsuleLimits.Num() + GetCapsuleLimitsData().Num(),
+		PlanarLimits.Num() + GetPlanarLimitsData().Num(),
+		SDFLimits.Num(),
+		NumPhysicsAssetBodies,
+		PhysicsAssetMode,
+		TargetFramerate,
+		SkelMeshComp ? SkelMeshComp->PredictedLODLevel : INDEX_NONE,
+		*StaticEnum<EKawaiiPhysicsSimulationTier>()->GetNameStringByValue((int64)BudgetTier),
+		BudgetSignificance,
+		AverageCost,
+		PeakCost);
+}
+
+void FAnimNode_KawaiiPhysics::DumpAllDebugCosts(FOutputDevice& Ar)
+{
+	FScopeLock Lock(&GetDebugNodesCritical());
+
+	Ar.Logf(TEXT("KawaiiPhysics: %d live nodes. Cost is over the last %d evaluations"), GetDebugNodes().Num(), DebugCostWindowSize);
+	for (const FAnimNode_KawaiiPhysics* Node : GetDebugNodes())
+	{
+		Node->DumpDebugCost(Ar);
+	}
+}
+
+void FAnimNode_KawaiiPhysics::GatherDebugCosts(TArray<float>& OutAverageMicroseconds, TArray<float>& OutPeakMicroseconds)
+{
+	FScopeLock Lock(&GetDebugNodesCritical());
+
+	OutAverageMicroseconds.Reset(GetDebugNodes().Num());
+	OutPeakMicroseconds.Reset(GetDebugNodes().Num());
+	for (const FAnimNode_KawaiiPhysics* Node : GetDebugNodes())
+	{
+		float AverageCost = 0.0f;
+		float PeakCost = 0.0f;
+		Node->GetDebugCost(AverageCost, PeakCost);
+		OutAverageMicroseconds.Add(AverageCost);
+		OutPeakMicroseconds.Add(PeakCost);
+	}
+}
+
+void FAnimNode_KawaiiPhysics::PublishDebugSnapshot()
+{
+	if (!DebugSnapshotBuffer.HasConsumers())
+	{
+		return;
+	}
+
+	FKawaiiPhysicsDebugSnapshot* Snapshot = DebugSnapshotBuffer.BeginWrite();
+	if (!Snapshot)
+	{
+		return;
+	}
+
+	Snapshot->Bones.Reset(ModifyBones.Num());
+	for (const FKawaiiPhysicsModifyBone& Bone : ModifyBones)
+	{
+		FKawaiiPhysicsDebugSnapshot::FBone& DebugBone = Snapshot->Bones.AddDefaulted_GetRef();
+		DebugBone.Location = Bone.Location;
+		DebugBone.PoseLocation = Bone.PoseLocation;
+		DebugBone.Radius = Bone.PhysicsSettings.Radius;
+		DebugBone.LimitAngle = Bone.PhysicsSettings.LimitAngle;
+		DebugBone.LengthRate = TotalBoneLength > 0.0f ? Bone.LengthFromRoot / TotalBoneLength : 0.0f;
+		DebugBone.ParentIndex = Bone.ParentIndex;
+		DebugBone.bDummy = Bone.bDummy;
+	}
+
+	Snapshot->SphericalLimits = SphericalLimits;
+	Snapshot->CapsuleLimits = CapsuleLimits;
+	Snapshot->PlanarLimits = PlanarLimits;
+	Snapshot->SDFLimits = SDFLimits;
+	CopyLimitsData(GetSphericalLimitsData(), GetLimitsDataInstances(ECollisionLimitType::Spherical), Snapshot->SphericalLimitsData);
+	CopyLimitsData(GetCapsuleLimitsData(), GetLimitsDataInstances(ECollisionLimitType::Capsule), Snapshot->CapsuleLimitsData);
+	const FKawaiiPhysicsLimitInstance* PlanarInstances = GetLimitsDataInstances(ECollisionLimitType::Planar);
+	CopyLimitsData(GetPlanarLimitsData(), PlanarInstances, Snapshot->PlanarLimitsData);
+	for (int32 i = 0; i < Snapshot->PlanarLimitsData.Num(); ++i)
+	{
+		Snapshot->PlanarLimitsData[i].Plane = PlanarInstances[i].Plane;
+	}
+
+	DebugSnapshotBuffer.Publish();
+}
+
+namespace
+{
+	// Nodes keep publishing debug snapshots for this number of frames after the last read
+	const uint64 DebugSnapshotLeaseFrames = 10;
+}
+
+bool FKawaiiPhysicsDebugSnapshotBuffer::HasConsumers() const
+{
+	return GFrameCounter - (uint64)LastReadFrame.GetValue() <= DebugSnapshotLeaseFrames;
+}
+
+FKawaiiPhysicsDebugSnapshot* FKawaiiPhysicsDebugSnapshotBuffer::BeginWrite()
+{
+	// Only the evaluation of the node writes, so the back buffer doesn't change under it
+	WriteIndex = PublishedIndex.GetValue() == 0 ? 1 : 0;
+	if (NumReaders[WriteIndex].GetValue() > 0)
+	{
+		WriteIndex = INDEX_NONE;
+		return nullptr;
+	}
+	return &Snapshots[WriteIndex];
+}
+
+void FKawaiiPhysicsDebugSnapshotBuffer::Publish()
+{
+	check(WriteIndex != INDEX_NONE);
+	PublishedIndex.Set(WriteIndex);
+	WriteIndex = INDEX_NONE;
+}
+
+bool FKawaiiPhysicsDebugSnapshotBuffer::Read(TFunctionRef<void(const FKawaiiPhysicsDebugSnapshot&)> Visitor) const
+{
+	LastReadFrame.Set((int64)GFrameCounter);
+
+	for (;;)
+	{
+		const int32 Index = PublishedIndex.GetValue();
+		if (Index == INDEX_NONE)
+		{
+			return false;
+		}
+
+		// The writer checks the readers before it takes the back buffer. If it took this one in the meantime,
+		// the other one has been published and the loop retries with it
+		NumReaders[Index].Increment();
+		if (PublishedIndex.GetValue() == Index)
+		{
+			Visitor(Snapshots[Index]);
+			NumReaders[Index].Decrement();
+			return true;
+		}
+		NumReaders[Index].Decrement();
+	}
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+// Copyright (c) 2019-2020 pafuhana1213. Licensed under the MIT License.
+
+#include "KawaiiPhysicsBodyBoneIndexCache.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "PhysicsEngine/SkeletalBodySetup.h"
+
+bool FKawaiiPhysicsBodyBoneIndexCache::Update(const UPhysicsAsset* PhysicsAsset, const USkeletalMeshComponent* SkeletalMeshComp)
+{
+	const USkeletalMesh* SkeletalMesh = SkeletalMeshComp ? SkeletalMeshComp->SkeletalMesh : nullptr;
+
+	// Bodies can be added or removed while the physics asset is edited
+	if (CachedPhysicsAsset.Get() == PhysicsAsset && CachedSkeletalMesh.Get() == SkeletalMesh &&
+		(!PhysicsAsset || BoneIndices.Num() == PhysicsAsset->SkeletalBodySetups.Num()))
+	{
+		return false;
+	}
+
+	CachedPhysicsAsset = PhysicsAsset;
+	CachedSkeletalMesh = SkeletalMesh;
+	BoneIndices.Reset();
+
+	if (PhysicsAsset && SkeletalMeshComp)
+	{
+		BoneIndices.Reserve(PhysicsAsset->SkeletalBodySetups.Num());
+		for (const USkeletalBodySetup* BodySetup : PhysicsAsset->SkeletalBodySetups)
+		{
+			BoneIndices.Add(BodySetup ? SkeletalMeshComp->GetBoneIndex(BodySetup->BoneName) : INDEX_NONE);
+		}
+	}
+
+	return true;
+}
+
+void FKawaiiPhysicsBodyBoneIndexCache::Reset()
+{
+	CachedPhysicsAsset.Reset();
+	CachedSkeletalMesh.Reset();
+	BoneIndices.Reset();
+}
@@ -0,0 +1,206 @@
+// Copyright (c) 2019-2020 pafuhana1213. Licensed under the MIT License.
+
+
+#include "KawaiiPhysicsBudget.h"
+#include "KawaiiPhysics.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+TAutoConsoleVariable<float> CVarBudgetMicroseconds(TEXT("p.KawaiiPhysics.BudgetMicroseconds"), 0.0f,
+	TEXT("Total cost of KawaiiPhysics nodes in a frame in microseconds. Less significant nodes are degraded to reduced rate or frozen to keep it. 0 disables the budget."));
+TAutoConsoleVariable<int32> CVarBudgetReducedRateInterval(TEXT("p.KawaiiPhysics.BudgetReducedRateInterval"), 2,
+	TEXT("Reduced rate nodes simulate once in this number of frames."));
+TAutoConsoleVariable<int32> CVarBudgetHysteresisFrames(TEXT("p.KawaiiPhysics.BudgetHysteresisFrames"), 30,
+	TEXT("Number of frames a node has to fit in the budget before it is promoted to a better tier. Degradation is immediate."));
+
+DECLARE_CYCLE_STAT(TEXT("Budget Rebalance"), STAT_KawaiiPhysics_BudgetRebalance, STATGROUP_KawaiiPhysics);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Budget Planned Cost (us)"), STAT_KawaiiPhysics_BudgetPlannedCost, STATGROUP_KawaiiPhysics);
+
+CSV_DECLARE_CATEGORY_EXTERN(KawaiiPhysics);
+
+namespace
+{
+	// Nodes not evaluated in this number of frames are forgotten. e.g. hidden meshes or inactive branches of the graph
+	const uint64 StaleFrames = 10;
+
+	// Promoted nodes need this ratio of extra budget so that they don't fall back in the next frame
+	const float PromotionHeadroom = 0.1f;
+
+	// Weight of the latest sample in the smoothed cost
+	const float CostSmoothing = 0.1f;
+}
+
+FKawaiiPhysicsBudget& FKawaiiPhysicsBudget::Get()
+{
+	// Never freed so that nodes destroyed at exit don't touch a destroyed instance
+	static FKawaiiPhysicsBudget* Budget = new FKawaiiPhysicsBudget();
+	return *Budget;
+}
+
+bool FKawaiiPhysicsBudget::IsEnabled()
+{
+	// Tiers depend on measured time, so the budget would break determinism
+	return CVarBudgetMicroseconds.GetValueOnAnyThread() > 0.0f && !FAnimNode_KawaiiPhysics::IsDeterministic();
+}
+
+int32 FKawaiiPhysicsBudget::GetReducedRateInterval()
+{
+	return FMath::Max(CVarBudgetReducedRateInterval.GetValueOnAnyThread(), 2);
+}
+
+bool FKawaiiPhysicsBudget::IsPhaseSlotFrame(int32 PhaseSlot)
+{
+	return PhaseSlot == INDEX_NONE || (GFrameCounter % GetReducedRateInterval()) == (uint64)PhaseSlot;
+}
+
+EKawaiiPhysicsSimulationTier FKawaiiPhysicsBudget::Report(const FAnimNode_KawaiiPhysics* Node, float Significance, float CostMicroseconds, bool bSimulated, int32& OutPhaseSlot)
+{
+	OutPhaseSlot = INDEX_NONE;
+	if (!IsEnabled())
+	{
+		return EKawaiiPhysicsSimulationTier::Full;
+	}
+
+	FScopeLock Lock(&CriticalSection);
+
+	// The first report of a frame decides the tiers with the reports of the previous frame
+	if (LastRebalanceFrame != GFrameCounter)
+	{
+		LastRebalanceFrame = GFrameCounter;
+		Rebalance();
+	}
+
+	FNodeEntry& Entry = Entries.FindOrAdd(Node);
+	Entry.Significance = Significance;
+	Entry.LastReportFrame = GFrameCounter;
+	if (bSimulated)
+	{
+		Entry.SimulateCost = Entry.SimulateCost > 0.0f ? FMath::Lerp(Entry.SimulateCost, CostMicroseconds, CostSmoothing) : CostMicroseconds;
+	}
+
+	OutPhaseSlot = Entry.PhaseSlot;
+	return Entry.Tier;
+}
+
+void FKawaiiPhysicsBudget::Unregister(const FAnimNode_KawaiiPhysics* Node)
+{
+	FScopeLock Lock(&CriticalSection);
+	Entries.Remove(Node);
+}
+
+void FKawaiiPhysicsBudget::Rebalance()
+{
+	SCOPE_CYCLE_COUNTER(STAT_KawaiiPhysics_BudgetRebalance);
+
+	TArray<FNodeEntry*> SortedEntries;
+	SortedEntries.Reserve(Entries.Num());
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if (GFrameCounter - It.Value().LastReportFrame > StaleFrames)
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+		SortedEntries.Add(&It.Value());
+	}
+	SortedEntries.Sort([](const FNodeEntry& A, const FNodeEntry& B)
+	{
+		return A.Significance > B.Significance;
+	});
+
+	const int32 ReducedRateInterval = GetReducedRateInterval();
+	const int32 HysteresisFrames = CVarBudgetHysteresisFrames.GetValueOnAnyThread();
+	float RemainingBudget = CVarBudgetMicroseconds.GetValueOnAnyThread();
+	float PlannedCost = 0.0f;
+
+	for (FNodeEntry* Entry : SortedEntries)
+	{
+		const float FullCost = Entry->SimulateCost;
+		const float ReducedCost = Entry->SimulateCost / ReducedRateInterval;
+		auto Fits = [Entry, RemainingBudget](EKawaiiPhysicsSimulationTier Tier, float Cost)
+		{
+			return (Tier < Entry->Tier ? Cost * (1.0f + PromotionHeadroom) : Cost) <= RemainingBudget;
+		};
+
+		EKawaiiPhysicsSimulationTier DesiredTier = EKawaiiPhysicsSimulationTier::Frozen;
+		if (Fits(EKawaiiPhysicsSimulationTier::Full, FullCost))
+		{
+			DesiredTier = EKawaiiPhysicsSimulationTier::Full;
+		}
+		else if (Fits(EKawaiiPhysicsSimulationTier::Reduced, ReducedCost))
+		{
+			DesiredTier = EKawaiiPhysicsSimulationTier::Reduced;
+		}
+
+		if (DesiredTier > Entry->Tier)
+		{
+			// Degrade immediately to keep the budget
+			Entry->Tier = DesiredTier;
+			Entry->PendingFrames = 0;
+		}
+		else if (DesiredTier < Entry->Tier)
+		{
+			if (Entry->PendingTier != DesiredTier)
+			{
+				Entry->PendingTier = DesiredTier;
+				Entry->PendingFrames = 0;
+			}
+			if (++Entry->PendingFrames >= HysteresisFrames)
+			{
+				Entry->Tier = Entry->PendingTier;
+				Entry->PendingFrames = 0;
+			}
+		}
+		else
+		{
+			Entry->PendingFrames = 0;
+		}
+
+		const float Cost = Entry->Tier == EKawaiiPhysicsSimulationTier::Full ? FullCost :
+			(Entry->Tier == EKawaiiPhysicsSimulationTier::Reduced ? ReducedCost : 0.0f);
+		RemainingBudget -= Cost;
+		PlannedCost += Cost;
+	}
+
+	AssignPhaseSlots(SortedEntries, ReducedRateInterval);
+
+	INC_FLOAT_STAT_BY(STAT_KawaiiPhysics_BudgetPlannedCost, PlannedCost);
+	CSV_CUSTOM_STAT(KawaiiPhysics, BudgetPlannedCost, PlannedCost, ECsvCustomStatOp::Set);
+}
+
+void FKawaiiPhysicsBudget::AssignPhaseSlots(const TArray<FNodeEntry*>& SortedEntries, int32 ReducedRateInterval)
+{
+	// Nodes keep their slot while they stay reduced rate. New ones go to the slot with the least cost
+	TArray<float, TInlineAllocator<8>> SlotCosts;
+	SlotCosts.SetNumZeroed(ReducedRateInterval);
+
+	for (FNodeEntry* Entry : SortedEntries)
+	{
+		if (Entry->Tier != EKawaiiPhysicsSimulationTier::Reduced || Entry->PhaseSlot >= ReducedRateInterval)
+		{
+			Entry->PhaseSlot = INDEX_NONE;
+		}
+		if (Entry->PhaseSlot != INDEX_NONE)
+		{
+			SlotCosts[Entry->PhaseSlot] += Entry->SimulateCost;
+		}
+	}
+
+	for (FNodeEntry* Entry : SortedEntries)
+	{
+		if (Entry->Tier != EKawaiiPhysicsSimulationTier::Reduced || Entry->PhaseSlot != INDEX_NONE)
+		{
+			continue;
+		}
+
+		int32 CheapestSlot = 0;
+		for (int32 Slot = 1; Slot < ReducedRateInterval; ++Slot)
+		{
+			if (SlotCosts[Slot] < SlotCosts[CheapestSlot])
+			{
+				CheapestSlot = Slot;
+			}
+		}
+		Entry->PhaseSlot = CheapestSlot;
+		SlotCosts[CheapestSlot] += Entry->SimulateCost;
+	}
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2019-2020 pafuhana1213. Licensed under the MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AnimNode_KawaiiPhysics.h"
+
+/**
+ * Keeps the total cost of KawaiiPhysics in a frame under p.KawaiiPhysics.BudgetMicroseconds.
+ * Nodes report their significance and cost after each evaluation. Once per frame the nodes are ranked by significance
+ * and the most significant ones get full rate until the budget runs out. The rest run at reduced rate or are frozen.
+ * Promotion to a better tier waits for p.KawaiiPhysics.BudgetHysteresisFrames to avoid popping.
+ * Reduced rate nodes get a phase slot so that their simulations are spread evenly across frames.
+ */
+class FKawaiiPhysicsBudget
+{
+public:
+	static FKawaiiPhysicsBudget& Get();
+
+	static bool IsEnabled();
+
+	/** A reduced rate node simulates once in this number of frames */
+	static int32 GetReducedRateInterval();
+
+	/** Whether a reduced rate node in the phase slot simulates in this frame */
+	static bool IsPhaseSlotFrame(int32 PhaseSlot);
+
+	/**
+	 * Report the result of an evaluation and get the tier and the phase slot for the next one. Thread safe.
+	 * CostMicroseconds is only used to estimate the cost at full rate when bSimulated is true
+	 */
+	EKawaiiPhysicsSimulationTier Report(const FAnimNode_KawaiiPhysics* Node, float Significance, float CostMicroseconds, bool bSimulated, int32& OutPhaseSlot);
+
+	void Unregister(const FAnimNode_KawaiiPhysics* Node);
+
+private:
+	struct FNodeEntry
+	{
+		float Significance = 0.0f;
+
+		/** Smoothed cost of a simulated evaluation */
+		float SimulateCost = 0.0f;
+
+		EKawaiiPhysicsSimulationTier Tier = EKawaiiPhysicsSimulationTier::Full;
+		EKawaiiPhysicsSimulationTier PendingTier = EKawaiiPhysicsSimulationTier::Full;
+		int32 PendingFrames = 0;
+		uint64 LastReportFrame = 0;
+
+		/** Frame in the reduced rate interval to simulate. INDEX_NONE if not reduced rate */
+		int32 PhaseSlot = INDEX_NONE;
+	};
+
+	void Rebalance();
+	void AssignPhaseSlots(const TArray<FNodeEntry*>& SortedEntries, int32 ReducedRateInterval);
+
+	FCriticalSection CriticalSection;
+	TMap<const FAnimNode_KawaiiPhysics*, FNodeEntry> Entries;
+	uint64 LastRebalanceFrame = 0;
+};
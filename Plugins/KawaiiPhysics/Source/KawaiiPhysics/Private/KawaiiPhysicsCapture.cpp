@@ -0,0 +1,541 @@
+// Copyright (c) 2019-2020 pafuhana1213. Licensed under the MIT License.
+
+
+#include "KawaiiPhysicsCapture.h"
+#include "AnimNode_KawaiiPhysics.h"
+#include "KawaiiPhysicsSDFDataAsset.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "PhysicsEngine/SkeletalBodySetup.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+#include "Serialization/BufferReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogKawaiiPhysicsCapture, Log, All);
+
+namespace
+{
+	const uint32 CaptureMagic = 0x5043504B; // "KPCP"
+	const uint32 CaptureVersion = 3;
+
+	enum class ECaptureRecord : uint8
+	{
+		Settings,
+		Frame,
+	};
+
+	/** Assets are replayed by the paths in the capture. Missing ones are replayed as disabled */
+	template<typename AssetType>
+	AssetType* LoadCaptureAsset(const FString& Path)
+	{
+		if (Path.IsEmpty())
+		{
+			return nullptr;
+		}
+
+		AssetType* Asset = LoadObject<AssetType>(nullptr, *Path);
+		if (Asset == nullptr)
+		{
+			UE_LOG(LogKawaiiPhysicsCapture, Warning, TEXT("Failed to load %s for the replay"), *Path);
+		}
+		return Asset;
+	}
+}
+
+FArchive& operator<<(FArchive& Ar, FKawaiiPhysicsCaptureBone& Bone)
+{
+	Ar << Bone.ParentIndex << Bone.CollisionMask << Bone.BoneIndex << Bone.bDummy;
+	Ar << Bone.Damping << Bone.WorldDampingLocation << Bone.WorldDampingRotation << Bone.Stiffness << Bone.DelayAlpha << Bone.Radius << Bone.LimitAngle;
+	Ar << Bone.LengthFromRoot << Bone.PhysicsBodyIndex;
+	Ar << Bone.CulledSpheres << Bone.CulledCapsules << Bone.CulledPlanes << Bone.CulledSDFs;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FKawaiiPhysicsCaptureSettings& Settings)
+{
+	Ar << Settings.TargetFramerate << Settings.Gravity << Settings.TeleportDistanceThreshold << Settings.TeleportRotationThreshold;
+	Ar << Settings.bOldPhysicsMethodGravity << Settings.bOldPhysicsMethodSphereLimit;
+	Ar << Settings.bUseDelayMode << Settings.BoneForwardAxis << Settings.PlanarConstraint;
+	Ar << Settings.bEnableWind << Settings.WindScale;
+	Ar << Settings.bEnableSelfCollision << Settings.SelfCollisionMaxPairs << Settings.SelfCollisionIgnoreHops;
+	Ar << Settings.bUsePhysicsAssetAsShapes << Settings.PhysicsAssetAsShapes << Settings.bUsePhysicsAssetAsLimits << Settings.PhysicsAssetAsLimits;
+	Ar << Settings.SDFDataAssets;
+	Ar << Settings.Bones;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FKawaiiPhysicsCaptureSphere& Sphere)
+{
+	Ar << Sphere.Location << Sphere.Radius << Sphere.CollisionGroup << Sphere.bInner;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FKawaiiPhysicsCaptureCapsule& Capsule)
+{
+	Ar << Capsule.Location << Capsule.Rotation << Capsule.Radius << Capsule.Length << Capsule.CollisionGroup;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FKawaiiPhysicsCapturePlane& Plane)
+{
+	Ar << Plane.Location << Plane.Rotation << Plane.CollisionGroup;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FKawaiiPhysicsCaptureSDF& SDF)
+{
+	Ar << SDF.Location << SDF.Rotation << SDF.CollisionGroup;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FKawaiiPhysicsCaptureState& State)
+{
+	Ar << State.PreComponentTransform << State.DeltaTimeOld << State.SelfCollisionStartIndex;
+	Ar << State.Locations << State.PrevLocations;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FKawaiiPhysicsCaptureFrame& Frame)
+{
+	Ar << Frame.DeltaTime << Frame.ComponentTransform << Frame.WindSeed;
+	Ar << Frame.PoseLocations << Frame.PoseRotations;
+	Ar << Frame.Spheres << Frame.Capsules << Frame.Planes << Frame.SDFs;
+	Ar << Frame.WindVelocities << Frame.BoneScales << Frame.LimitBodyBoneIndices << Frame.LimitBodyTransforms;
+	Ar << Frame.State;
+	return Ar;
+}
+
+bool FKawaiiPhysicsCaptureWriter::Open(const TCHAR* Filename)
+{
+	Archive.Reset(IFileManager::Get().CreateFileWriter(Filename));
+	if (!Archive.IsValid())
+	{
+		return false;
+	}
+
+	uint32 Magic = CaptureMagic;
+	uint32 Version = CaptureVersion;
+	*Archive << Magic << Version;
+	LastSettingsBytes.Reset();
+	return true;
+}
+
+void FKawaiiPhysicsCaptureWriter::Close()
+{
+	if (Archive.IsValid())
+	{
+		Archive->Close();
+		Archive.Reset();
+	}
+}
+
+bool FKawaiiPhysicsCaptureWriter::WriteSettings(FKawaiiPhysicsCaptureSettings& Settings)
+{
+	check(Archive.IsValid());
+
+	TArray<uint8> SettingsBytes;
+	FMemoryWriter SettingsWriter(SettingsBytes);
+	SettingsWriter << Settings;
+	if (SettingsBytes == LastSettingsBytes)
+	{
+		return false;
+	}
+
+	uint8 Record = (uint8)ECaptureRecord::Settings;
+	*Archive << Record;
+	Archive->Serialize(SettingsBytes.GetData(), SettingsBytes.Num());
+	LastSettingsBytes = MoveTemp(SettingsBytes);
+	return true;
+}
+
+void FKawaiiPhysicsCaptureWriter::WriteFrame(FKawaiiPhysicsCaptureFrame& Frame)
+{
+	check(Archive.IsValid());
+	uint8 Record = (uint8)ECaptureRecord::Frame;
+	*Archive << Record << Frame;
+}
+
+FKawaiiPhysicsCaptureReader::FKawaiiPhysicsCaptureReader()
+{
+}
+
+FKawaiiPhysicsCaptureReader::~FKawaiiPhysicsCaptureReader()
+{
+}
+
+bool FKawaiiPhysicsCaptureReader::Open(const TCHAR* Filename)
+{
+	Archive.Reset();
+	MappedFileRegion.Reset();
+	MappedFileHandle.Reset();
+
+	// Frames are read through the whole file, so map it and let the OS page it in. Fall back to a file reader
+	// on platforms without mapped files
+	MappedFileHandle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(Filename));
+	if (MappedFileHandle.IsValid())
+	{
+		MappedFileRegion.Reset(MappedFileHandle->MapRegion());
+	}
+	if (MappedFileRegion.IsValid())
+	{
+		Archive = MakeUnique<FBufferReader>(const_cast<uint8*>(MappedFileRegion->GetMappedPtr()), MappedFileRegion->GetMappedSize(), false);
+	}
+	else
+	{
+		Archive.Reset(IFileManager::Get().CreateFileReader(Filename));
+	}
+	if (!Archive.IsValid())
+	{
+		return false;
+	}
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	*Archive << Magic << Version;
+	if (Magic != CaptureMagic || Version != CaptureVersion)
+	{
+		Archive.Reset();
+		return false;
+	}
+	return true;
+}
+
+bool FKawaiiPhysicsCaptureReader::ReadFrame(FKawaiiPhysicsCaptureFrame& OutFrame)
+{
+	while (Archive.IsValid() && !Archive->AtEnd())
+	{
+		uint8 Record = 0;
+		*Archive << Record;
+		if (Record == (uint8)ECaptureRecord::Settings)
+		{
+			*Archive << Settings;
+		}
+		else if (Record == (uint8)ECaptureRecord::Frame)
+		{
+			*Archive << OutFrame;
+			return !Archive->IsError();
+		}
+		else
+		{
+			// Broken file
+			break;
+		}
+	}
+	return false;
+}
+
+FKawaiiPhysicsCaptureReplay::FKawaiiPhysicsCaptureReplay()
+	: Node(MakeUnique<FAnimNode_KawaiiPhysics>())
+{
+}
+
+FKawaiiPhysicsCaptureReplay::~FKawaiiPhysicsCaptureReplay()
+{
+}
+
+void FKawaiiPhysicsCaptureReplay::Step(const FKawaiiPhysicsCaptureSettings& Settings, const FKawaiiPhysicsCaptureFrame& Frame)
+{
+	const int32 NumBones = Settings.Bones.Num();
+	if (Frame.PoseLocations.Num() != NumBones || Frame.PoseRotations.Num() != NumBones)
+	{
+		return;
+	}
+
+	if (!Frame.State.IsEmpty())
+	{
+		ApplySettings(Settings);
+		ApplyState(Frame.State);
+	}
+	else if (Node->ModifyBones.Num() != NumBones)
+	{
+		// Captures without a state in the first frame. Same as InitModifyBones and Initialize_AnyThread of the node
+		ApplySettings(Settings);
+		for (int32 i = 0; i < NumBones; ++i)
+		{
+			Node->ModifyBones[i].Location = Frame.PoseLocations[i];
+			Node->ModifyBones[i].PrevLocation = Frame.PoseLocations[i];
+		}
+		Node->PreSkelCompTransform = Frame.ComponentTransform;
+		Node->DeltaTimeOld = 1.0f / Settings.TargetFramerate;
+	}
+
+	ApplyFrame(Frame);
+	if (bReachableLimitsDirty)
+	{
+		ApplyReachableLimits(Settings);
+		bReachableLimitsDirty = false;
+	}
+
+	// Same order as EvaluateSkeletalControl_AnyThread of the node
+	Node->UpdateSkelCompMove(Frame.ComponentTransform);
+
+	Node->SimulateModifyBones(Frame.ComponentTransform);
+
+	Locations.SetNumUninitialized(NumBones);
+	for (int32 i = 0; i < NumBones; ++i)
+	{
+		Locations[i] = Node->ModifyBones[i].Location;
+	}
+}
+
+void FKawaiiPhysicsCaptureReplay::ApplySettings(const FKawaiiPhysicsCaptureSettings& Settings)
+{
+	FAnimNode_KawaiiPhysics& KawaiiPhysics = *Node;
+	bReachableLimitsDirty = true;
+	KawaiiPhysics.TargetFramerate = Settings.TargetFramerate;
+	KawaiiPhysics.Gravity = Settings.Gravity;
+	KawaiiPhysics.TeleportDistanceThreshold = Settings.TeleportDistanceThreshold;
+	KawaiiPhysics.TeleportRotationThreshold = Settings.TeleportRotationThreshold;
+	KawaiiPhysics.bOldPhysicsMethodGravity = Settings.bOldPhysicsMethodGravity;
+	KawaiiPhysics.bOldPhysicsMethodSphereLimit = Settings.bOldPhysicsMethodSphereLimit;
+	KawaiiPhysics.bUseDelayMode = Settings.bUseDelayMode;
+	KawaiiPhysics.BoneForwardAxis = (EBoneForwardAxis)Settings.BoneForwardAxis;
+	KawaiiPhysics.PlanarConstraint = (EPlanarConstraint)Settings.PlanarConstraint;
+	KawaiiPhysics.bEnableWind = Settings.bEnableWind;
+	KawaiiPhysics.WindScale = Settings.WindScale;
+	KawaiiPhysics.bEnableSelfCollision = Settings.bEnableSelfCollision;
+	KawaiiPhysics.SelfCollisionMaxPairs = Settings.SelfCollisionMaxPairs;
+	KawaiiPhysics.SelfCollisionIgnoreHops = Settings.SelfCollisionIgnoreHops;
+
+	KawaiiPhysics.PhysicsAssetAsShapes = LoadCaptureAsset<UPhysicsAsset>(Settings.PhysicsAssetAsShapes);
+	KawaiiPhysics.bUsePhysicsAssetAsShapes = Settings.bUsePhysicsAssetAsShapes && KawaiiPhysics.PhysicsAssetAsShapes != nullptr;
+	KawaiiPhysics.UsePhysicsAssetAsLimits = LoadCaptureAsset<UPhysicsAsset>(Settings.PhysicsAssetAsLimits);
+	KawaiiPhysics.bUsePhysicsAssetAsLimits = Settings.bUsePhysicsAssetAsLimits && KawaiiPhysics.UsePhysicsAssetAsLimits != nullptr;
+
+	// Limits of the data asset are captured with the limits of the node
+	KawaiiPhysics.LimitsDataAsset = nullptr;
+	KawaiiPhysics.NumSphericalLimitsData = 0;
+	KawaiiPhysics.NumCapsuleLimitsData = 0;
+	KawaiiPhysics.NumPlanarLimitsData = 0;
+
+	KawaiiPhysics.SDFLimits.SetNum(Settings.SDFDataAssets.Num());
+	for (int32 i = 0; i < Settings.SDFDataAssets.Num(); ++i)
+	{
+		KawaiiPhysics.SDFLimits[i].SDFDataAsset = LoadCaptureAsset<UKawaiiPhysicsSDFDataAsset>(Settings.SDFDataAssets[i]);
+	}
+
+	KawaiiPhysics.ModifyBones.SetNum(Settings.Bones.Num());
+	for (int32 i = 0; i < Settings.Bones.Num(); ++i)
+	{
+		const FKawaiiPhysicsCaptureBone& CaptureBone = Settings.Bones[i];
+		FKawaiiPhysicsModifyBone& Bone = KawaiiPhysics.ModifyBones[i];
+		Bone.BoneRef.BoneIndex = CaptureBone.BoneIndex;
+		Bone.ParentIndex = CaptureBone.ParentIndex;
+		Bone.ChildIndexs.Reset();
+		Bone.bDummy = CaptureBone.bDummy;
+		Bone.CollisionMask = CaptureBone.CollisionMask;
+		Bone.PhysicsSettings.Damping = CaptureBone.Damping;
+		Bone.PhysicsSettings.WorldDampingLocation = CaptureBone.WorldDampingLocation;
+		Bone.PhysicsSettings.WorldDampingRotation = CaptureBone.WorldDampingRotation;
+		Bone.PhysicsSettings.Stiffness = CaptureBone.Stiffness;
+		Bone.PhysicsSettings.DelayAlpha = CaptureBone.DelayAlpha;
+		Bone.PhysicsSettings.Radius = CaptureBone.Radius;
+		Bone.PhysicsSettings.LimitAngle = CaptureBone.LimitAngle;
+		Bone.LengthFromRoot = CaptureBone.LengthFromRoot;
+
+		const UPhysicsAsset* PhysicsAsset = KawaiiPhysics.bUsePhysicsAssetAsShapes ? KawaiiPhysics.PhysicsAssetAsShapes : nullptr;
+		Bone.PhysicsBodySetup = PhysicsAsset && PhysicsAsset->SkeletalBodySetups.IsValidIndex(CaptureBone.PhysicsBodyIndex) ?
+			PhysicsAsset->SkeletalBodySetups[CaptureBone.PhysicsBodyIndex] : nullptr;
+	}
+	for (int32 i = 0; i < KawaiiPhysics.ModifyBones.Num(); ++i)
+	{
+		const int32 ParentIndex = KawaiiPhysics.ModifyBones[i].ParentIndex;
+		if (KawaiiPhysics.ModifyBones.IsValidIndex(ParentIndex))
+		{
+			KawaiiPhysics.ModifyBones[ParentIndex].ChildIndexs.Add(i);
+		}
+	}
+}
+
+void FKawaiiPhysicsCaptureReplay::ApplyState(const FKawaiiPhysicsCaptureState& State)
+{
+	FAnimNode_KawaiiPhysics& KawaiiPhysics = *Node;
+	KawaiiPhysics.PreSkelCompTransform = State.PreComponentTransform;
+	KawaiiPhysics.DeltaTimeOld = State.DeltaTimeOld;
+	KawaiiPhysics.SelfCollisionStartIndex = State.SelfCollisionStartIndex;
+	for (int32 i = 0; i < KawaiiPhysics.ModifyBones.Num(); ++i)
+	{
+		FKawaiiPhysicsModifyBone& Bone = KawaiiPhysics.ModifyBones[i];
+		Bone.Location = State.Locations.IsValidIndex(i) ? State.Locations[i] : FVector::ZeroVector;
+		Bone.PrevLocation = State.PrevLocations.IsValidIndex(i) ? State.PrevLocations[i] : Bone.Location;
+	}
+}
+
+void FKawaiiPhysicsCaptureReplay::ApplyFrame(const FKawaiiPhysicsCaptureFrame& Frame)
+{
+	FAnimNode_KawaiiPhysics& KawaiiPhysics = *Node;
+	KawaiiPhysics.DeltaTime = Frame.DeltaTime;
+	KawaiiPhysics.WindRandomStream.Initialize(Frame.WindSeed);
+
+	for (int32 i = 0; i < KawaiiPhysics.ModifyBones.Num(); ++i)
+	{
+		FKawaiiPhysicsModifyBone& Bone = KawaiiPhysics.ModifyBones[i];
+		Bone.PoseLocation = Frame.PoseLocations[i];
+		Bone.PoseRotation = Frame.PoseRotations[i];
+	}
+
+	bReachableLimitsDirty |= KawaiiPhysics.SphericalLimits.Num() != Frame.Spheres.Num() ||
+		KawaiiPhysics.CapsuleLimits.Num() != Frame.Capsules.Num() || KawaiiPhysics.PlanarLimits.Num() != Frame.Planes.Num();
+
+	// Same as UpdateLimitTransforms of the node
+	KawaiiPhysics.SphericalLimits.SetNum(Frame.Spheres.Num());
+	for (int32 i = 0; i < Frame.Spheres.Num(); ++i)
+	{
+		const FKawaiiPhysicsCaptureSphere& Sphere = Frame.Spheres[i];
+		FSphericalLimit& Limit = KawaiiPhysics.SphericalLimits[i];
+		Limit.Location = Sphere.Location;
+		Limit.Radius = Sphere.Radius;
+		Limit.CollisionGroup = Sphere.CollisionGroup;
+		Limit.LimitType = Sphere.bInner ? ESphericalLimitType::Inner : ESphericalLimitType::Outer;
+	}
+	KawaiiPhysics.CapsuleLimits.SetNum(Frame.Capsules.Num());
+	for (int32 i = 0; i < Frame.Capsules.Num(); ++i)
+	{
+		const FKawaiiPhysicsCaptureCapsule& Capsule = Frame.Capsules[i];
+		FCapsuleLimit& Limit = KawaiiPhysics.CapsuleLimits[i];
+		Limit.Location = Capsule.Location;
+		Limit.Rotation = Capsule.Rotation;
+		Limit.Radius = Capsule.Radius;
+		Limit.Length = Capsule.Length;
+		Limit.CollisionGroup = Capsule.CollisionGroup;
+	}
+	KawaiiPhysics.PlanarLimits.SetNum(Frame.Planes.Num());
+	for (int32 i = 0; i < Frame.Planes.Num(); ++i)
+	{
+		const FKawaiiPhysicsCapturePlane& Plane = Frame.Planes[i];
+		FPlanarLimit& Limit = KawaiiPhysics.PlanarLimits[i];
+		Limit.Location = Plane.Location;
+		Limit.Rotation = Plane.Rotation;
+		Limit.CollisionGroup = Plane.CollisionGroup;
+		Limit.Plane = FPlane(Plane.Location, Plane.Rotation.GetUpVector());
+	}
+	for (int32 i = 0; i < KawaiiPhysics.SDFLimits.Num() && i < Frame.SDFs.Num(); ++i)
+	{
+		const FKawaiiPhysicsCaptureSDF& SDF = Frame.SDFs[i];
+		FSDFLimit& Limit = KawaiiPhysics.SDFLimits[i];
+		Limit.Location = SDF.Location;
+		Limit.Rotation = SDF.Rotation;
+		Limit.CollisionGroup = SDF.CollisionGroup;
+	}
+
+	FKawaiiPhysicsInputSnapshot& InputSnapshot = KawaiiPhysics.InputSnapshot;
+	InputSnapshot.WindVelocities = Frame.WindVelocities;
+	InputSnapshot.BoneScales = Frame.BoneScales;
+	InputSnapshot.LimitBodyBoneIndices = Frame.LimitBodyBoneIndices;
+	InputSnapshot.LimitBodyTransforms = Frame.LimitBodyTransforms;
+}
+
+void FKawaiiPhysicsCaptureReplay::ApplyReachableLimits(const FKawaiiPhysicsCaptureSettings& Settings)
+{
+	// Same as UpdateLimitsReachability of the node. Limits of the data asset are replayed as limits of the node
+	auto BuildReachableLimits = [](int32 NumLimits, const TArray<int32>& CulledIndices, TArray<int32>& OutReachableIndices)
+	{
+		OutReachableIndices.Reset(NumLimits);
+		for (int32 i = 0; i < NumLimits; ++i)
+		{
+			if (!CulledIndices.Contains(i))
+			{
+				OutReachableIndices.Add(i);
+			}
+		}
+	};
+
+	FAnimNode_KawaiiPhysics& KawaiiPhysics = *Node;
+	for (int32 i = 0; i < KawaiiPhysics.ModifyBones.Num() && i < Settings.Bones.Num(); ++i)
+	{
+		const FKawaiiPhysicsCaptureBone& CaptureBone = Settings.Bones[i];
+		FKawaiiPhysicsReachableLimits& ReachableLimits = KawaiiPhysics.ModifyBones[i].ReachableLimits;
+		BuildReachableLimits(KawaiiPhysics.SphericalLimits.Num(), CaptureBone.CulledSpheres, ReachableLimits.Spherical);
+		BuildReachableLimits(KawaiiPhysics.CapsuleLimits.Num(), CaptureBone.CulledCapsules, ReachableLimits.Capsule);
+		BuildReachableLimits(KawaiiPhysics.PlanarLimits.Num(), CaptureBone.CulledPlanes, ReachableLimits.Planar);
+		BuildReachableLimits(KawaiiPhysics.SDFLimits.Num(), CaptureBone.CulledSDFs, ReachableLimits.SDF);
+		ReachableLimits.SphericalData.Reset();
+		ReachableLimits.CapsuleData.Reset();
+		ReachableLimits.PlanarData.Reset();
+	}
+}
+
+void FKawaiiPhysicsCaptureReplay::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	Collector.AddReferencedObject(Node->PhysicsAssetAsShapes);
+	Collector.AddReferencedObject(Node->UsePhysicsAssetAsLimits);
+	for (FSDFLimit& Limit : Node->SDFLimits)
+	{
+		Collector.AddReferencedObject(Limit.SDFDataAsset);
+	}
+}
+
+void FKawaiiPhysicsReplayResult::AddFrame(const TArray<FVector>& BoneLocations)
+{
+	for (int32 i = 0; i < BoneLocations.Num(); ++i)
+	{
+		Locations.Add(BoneLocations[i]);
+		FrameBones.Add(FIntPoint(NumFrames, i));
+	}
+	++NumFrames;
+}
+
+bool FKawaiiPhysicsReplayResult::SaveToFile(const TCHAR* Filename) const
+{
+	FString Output = TEXT("Frame,Bone,X,Y,Z\n");
+	for (int32 i = 0; i < Locations.Num(); ++i)
+	{
+		Output += FString::Printf(TEXT("%d,%d,%.6f,%.6f,%.6f\n"), FrameBones[i].X, FrameBones[i].Y, Locations[i].X, Locations[i].Y, Locations[i].Z);
+	}
+	return FFileHelper::SaveStringToFile(Output, Filename);
+}
+
+bool FKawaiiPhysicsReplayResult::LoadFromFile(const TCHAR* Filename)
+{
+	Locations.Reset();
+	FrameBones.Reset();
+	NumFrames = 0;
+
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, Filename) || Lines.Num() == 0)
+	{
+		UE_LOG(LogKawaiiPhysicsCapture, Error, TEXT("Failed to read %s"), Filename);
+		return false;
+	}
+
+	// Skip the header line
+	for (int32 i = 1; i < Lines.Num(); ++i)
+	{
+		TArray<FString> Values;
+		Lines[i].ParseIntoArray(Values, TEXT(","));
+		if (Values.Num() != 5)
+		{
+			UE_LOG(LogKawaiiPhysicsCapture, Error, TEXT("%s line %d is broken"), Filename, i + 1);
+			return false;
+		}
+
+		const FIntPoint FrameBone(FCString::Atoi(*Values[0]), FCString::Atoi(*Values[1]));
+		FrameBones.Add(FrameBone);
+		Locations.Add(FVector(FCString::Atof(*Values[2]), FCString::Atof(*Values[3]), FCString::Atof(*Values[4])));
+		NumFrames = FMath::Max(NumFrames, FrameBone.X + 1);
+	}
+	return true;
+}
+
+bool FKawaiiPhysicsReplayResult::Compare(const FKawaiiPhysicsReplayResult& Golden, float& OutMaxDeviation, FIntPoint& OutMaxDeviationFrameBone) const
+{
+	OutMaxDeviation = 0.0f;
+	OutMaxDeviationFrameBone = FIntPoint(0, 0);
+	if (FrameBones != Golden.FrameBones)
+	{
+		return false;
+	}
+
+	for (int32 i = 0; i < Locations.Num(); ++i)
+	{
+		const float Deviation = (Locations[i] - Golden.Locations[i]).Size();
+		if (Deviation > OutMaxDeviation)
+		{
+			OutMaxDeviation = Deviation;
+			OutMaxDeviationFrameBone = FrameBones[i];
+		}
+	}
+	return true;
+}
@@ -3,67 +3,126 @@
 
 #include "KawaiiPhysicsLimitsDataAsset.h"
 #include "AnimNode_KawaiiPhysics.h"
+#include "Animation/Skeleton.h"
+
+namespace
+{
+	FKawaiiPhysicsCookedLimit MakeCookedLimit(const FCollisionLimitBase& Limit)
+	{
+		FKawaiiPhysicsCookedLimit Cooked;
+		Cooked.OffsetRotation = Limit.OffsetRotation.Quaternion();
+		Cooked.OffsetLocation = Limit.OffsetLocation;
+		return Cooked;
+	}
+
+	template<typename LimitType>
+	void AddCookedLimits(const TArray<LimitType>& Limits, TArray<FKawaiiPhysicsCookedLimit>& OutCookedLimits)
+	{
+		for (const LimitType& Limit : Limits)
+		{
+			OutCookedLimits.Add(MakeCookedLimit(Limit));
+		}
+	}
+
+	template<typename LimitType>
+	void AddCookedBoneIndices(const TArray<LimitType>& Limits, const FReferenceSkeleton& RefSkeleton, TArray<int32>& OutSkeletonBoneIndices)
+	{
+		for (const LimitType& Limit : Limits)
+		{
+			OutSkeletonBoneIndices.Add(RefSkeleton.FindBoneIndex(Limit.DrivingBone.BoneName));
+		}
+	}
+}
 
 #if WITH_EDITOR
 
-void UKawaiiPhysicsLimitsDataAsset::UpdateLimit(FCollisionLimitBase* Limit)
+namespace
 {
-	switch (Limit->Type)
+	template<typename LimitDataType>
+	int32 FindLimitDataIndex(const TArray<LimitDataType>& LimitsData, TMap<FGuid, int32>& Indices, const FGuid& Guid)
 	{
-		case ECollisionLimitType::Spherical:
+		const int32* Index = Indices.Find(Guid);
+		if (Index && LimitsData.IsValidIndex(*Index) && LimitsData[*Index].Guid == Guid)
+		{
+			return *Index;
+		}
 
-			for (FSphericalLimitData& LimitData : SphericalLimitsData)
-			{
-				if (LimitData.Guid == Limit->Guid)
-				{
-					LimitData.Update((FSphericalLimit*)Limit);
-					break;
-				}
-			}
+		// Stale after the array was edited in the details panel
+		Indices.Reset();
+		for (int32 i = 0; i < LimitsData.Num(); ++i)
+		{
+			Indices.Add(LimitsData[i].Guid, i);
+		}
 
-			SphericalLimits.Empty();
-			for (FSphericalLimitData& Data : SphericalLimitsData)
-			{
-				SphericalLimits.Add(Data.Convert());
-			}
+		Index = Indices.Find(Guid);
+		return Index ? *Index : INDEX_NONE;
+	}
 
-		break;
-		case ECollisionLimitType::Capsule:
+	template<typename LimitDataType, typename LimitType>
+	void ConvertLimitsData(TArray<LimitDataType>& LimitsData, TArray<LimitType>& Limits)
+	{
+		Limits.Reset(LimitsData.Num());
+		for (LimitDataType& Data : LimitsData)
+		{
+			Limits.Add(Data.Convert());
+		}
+	}
 
-			for (FCapsuleLimitData& LimitData : CapsuleLimitsData)
-			{
-				if (LimitData.Guid == Limit->Guid)
-				{
-					LimitData.Update((FCapsuleLimit*)Limit);
-					break;
-				}
-			}
+	// Convert one limit in place. The whole array is converted if it is out of sync
+	template<typename LimitDataType, typename LimitType>
+	bool ConvertLimitData(TArray<LimitDataType>& LimitsData, TArray<LimitType>& Limits, int32 Index)
+	{
+		if (Limits.Num() != LimitsData.Num() || !LimitsData.IsValidIndex(Index))
+		{
+			ConvertLimitsData(LimitsData, Limits);
+			return false;
+		}
 
-			CapsuleLimits.Empty();
-			for (FCapsuleLimitData& Data : CapsuleLimitsData)
-			{
-				CapsuleLimits.Add(Data.Convert());
-			}
+		Limits[Index] = LimitsData[Index].Convert();
+		return true;
+	}
+}
 
-		break;
-		case ECollisionLimitType::Planar:
+void UKawaiiPhysicsLimitsDataAsset::PreSave(const class ITargetPlatform* TargetPlatform)
+{
+	Super::PreSave(TargetPlatform);
 
-			for (FPlanarLimitData& LimitData : PlanarLimitsData)
-			{
-				if (LimitData.Guid == Limit->Guid)
-				{
-					LimitData.Update((FPlanarLimit*)Limit);
-					break;
-				}
-			}
+	// Baked on every save so that the cooked data matches the current skeletons
+	CookLimits();
+}
 
-			PlanarLimits.Empty();
-			for (FPlanarLimitData& Data : PlanarLimitsData)
-			{
-				PlanarLimits.Add(Data.Convert());
-			}
+void UKawaiiPhysicsLimitsDataAsset::UpdateLimit(FCollisionLimitBase* Limit)
+{
+	const int32 Index = FindLimitIndex(Limit->Type, Limit->Guid);
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	bool bInPlace = false;
+	switch (Limit->Type)
+	{
+		case ECollisionLimitType::Spherical:
+			SphericalLimitsData[Index].Update((FSphericalLimit*)Limit);
+			bInPlace = ConvertLimitData(SphericalLimitsData, SphericalLimits, Index);
+		break;
+		case ECollisionLimitType::Capsule:
+			CapsuleLimitsData[Index].Update((FCapsuleLimit*)Limit);
+			bInPlace = ConvertLimitData(CapsuleLimitsData, CapsuleLimits, Index);
+		break;
+		case ECollisionLimitType::Planar:
+			PlanarLimitsData[Index].Update((FPlanarLimit*)Limit);
+			bInPlace = ConvertLimitData(PlanarLimitsData, PlanarLimits, Index);
+		break;
+	}
 
-		break;;
+	if (bInPlace)
+	{
+		OnLimitUpdated(Limit->Type, Index);
+	}
+	else
+	{
+		OnLimitsRebuilt();
 	}
 
 	MarkPackageDirty();
@@ -72,47 +131,267 @@ void UKawaiiPhysicsLimitsDataAsset::UpdateLimit(FCollisionLimitBase* Limit)
 void UKawaiiPhysicsLimitsDataAsset::PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent)
 {
 	const FName PropertyName = PropertyChangedEvent.MemberProperty ? PropertyChangedEvent.MemberProperty->GetFName() : NAME_None;
+	const int32 ArrayIndex = PropertyName != NAME_None ? PropertyChangedEvent.GetArrayIndex(PropertyName.ToString()) : INDEX_NONE;
 
+	// A value of an existing element is updated in place. Anything else changes the layout of the array
+	const bool bValueChange = ArrayIndex != INDEX_NONE &&
+		(PropertyChangedEvent.ChangeType == EPropertyChangeType::ValueSet || PropertyChangedEvent.ChangeType == EPropertyChangeType::Interactive);
+
+	ECollisionLimitType Type = ECollisionLimitType::None;
+	bool bInPlace = false;
 	if (PropertyName == FName(TEXT("SphericalLimitsData")))
 	{
 		if (PropertyChangedEvent.ChangeType == EPropertyChangeType::Duplicate)
 		{
-			SphericalLimitsData[PropertyChangedEvent.GetArrayIndex(PropertyName.ToString())].Guid = FGuid::NewGuid();
+			SphericalLimitsData[ArrayIndex].Guid = FGuid::NewGuid();
 		}
 
-		SphericalLimits.Empty();
-		for (FSphericalLimitData& Data : SphericalLimitsData)
+		Type = ECollisionLimitType::Spherical;
+		if (bValueChange)
+		{
+			bInPlace = ConvertLimitData(SphericalLimitsData, SphericalLimits, ArrayIndex);
+		}
+		else
 		{
-			SphericalLimits.Add(Data.Convert());
+			ConvertLimitsData(SphericalLimitsData, SphericalLimits);
 		}
 	}
 	else if (PropertyName == FName(TEXT("CapsuleLimitsData")))
 	{
 		if (PropertyChangedEvent.ChangeType == EPropertyChangeType::Duplicate)
 		{
-			CapsuleLimitsData[PropertyChangedEvent.GetArrayIndex(PropertyName.ToString())].Guid = FGuid::NewGuid();
+			CapsuleLimitsData[ArrayIndex].Guid = FGuid::NewGuid();
 		}
 
-		CapsuleLimits.Empty();
-		for (FCapsuleLimitData& Data : CapsuleLimitsData)
+		Type = ECollisionLimitType::Capsule;
+		if (bValueChange)
 		{
-			CapsuleLimits.Add(Data.Convert());
+			bInPlace = ConvertLimitData(CapsuleLimitsData, CapsuleLimits, ArrayIndex);
+		}
+		else
+		{
+			ConvertLimitsData(CapsuleLimitsData, CapsuleLimits);
 		}
 	}
 	else if (PropertyName == FName(TEXT("PlanarLimitsData")))
 	{
 		if (PropertyChangedEvent.ChangeType == EPropertyChangeType::Duplicate)
 		{
-			PlanarLimitsData[PropertyChangedEvent.GetArrayIndex(PropertyName.ToString())].Guid = FGuid::NewGuid();
+			PlanarLimitsData[ArrayIndex].Guid = FGuid::NewGuid();
 		}
 
-		PlanarLimits.Empty();
-		for (FPlanarLimitData& Data : PlanarLimitsData)
+		Type = ECollisionLimitType::Planar;
+		if (bValueChange)
 		{
-			PlanarLimits.Add(Data.Convert());
+			bInPlace = ConvertLimitData(PlanarLimitsData, PlanarLimits, ArrayIndex);
+		}
+		else
+		{
+			ConvertLimitsData(PlanarLimitsData, PlanarLimits);
 		}
 	}
+	else if (PropertyName == FName(TEXT("TargetSkeletons")))
+	{
+		// Only the driving bones change but the nodes must resolve them again
+		OnLimitsRebuilt();
+		return;
+	}
+
+	if (bInPlace)
+	{
+		OnLimitUpdated(Type, ArrayIndex);
+	}
+	else if (Type != ECollisionLimitType::None)
+	{
+		OnLimitsRebuilt();
+	}
+}
+
+bool UKawaiiPhysicsLimitsDataAsset::GetUpdatedLimit(int32 InRevision, ECollisionLimitType& OutType, int32& OutIndex) const
+{
+	if (InRevision != UpdatedLimitRevision)
+	{
+		return false;
+	}
+
+	OutType = UpdatedLimitType;
+	OutIndex = UpdatedLimitIndex;
+	return true;
+}
+
+int32 UKawaiiPhysicsLimitsDataAsset::FindLimitIndex(ECollisionLimitType Type, const FGuid& Guid)
+{
+	switch (Type)
+	{
+		case ECollisionLimitType::Spherical:
+			return FindLimitDataIndex(SphericalLimitsData, SphericalLimitIndices, Guid);
+		case ECollisionLimitType::Capsule:
+			return FindLimitDataIndex(CapsuleLimitsData, CapsuleLimitIndices, Guid);
+		case ECollisionLimitType::Planar:
+			return FindLimitDataIndex(PlanarLimitsData, PlanarLimitIndices, Guid);
+	}
+	return INDEX_NONE;
+}
+
+void UKawaiiPhysicsLimitsDataAsset::CookLimit(ECollisionLimitType Type, int32 Index)
+{
+	int32 Offset = 0;
+	int32 Num = 0;
+	if (!GetCookedLimitsRange(Type, Offset, Num) || Index < 0 || Index >= Num)
+	{
+		CookLimits();
+		return;
+	}
+
+	const FCollisionLimitBase* Limit = nullptr;
+	switch (Type)
+	{
+		case ECollisionLimitType::Spherical:
+			CookedLimits[Offset + Index] = MakeCookedLimit(SphericalLimits[Index]);
+			Limit = &SphericalLimits[Index];
+		break;
+		case ECollisionLimitType::Capsule:
+			CookedLimits[Offset + Index] = MakeCookedLimit(CapsuleLimits[Index]);
+			Limit = &CapsuleLimits[Index];
+		break;
+		case ECollisionLimitType::Planar:
+			CookedLimits[Offset + Index] = MakeCookedLimit(PlanarLimits[Index]);
+			Limit = &PlanarLimits[Index];
+		break;
+	}
+
+	for (const USkeleton* Skeleton : TargetSkeletons)
+	{
+		if (!Skeleton)
+		{
+			continue;
+		}
+
+		for (FKawaiiPhysicsCookedLimitBones& Bones : CookedLimitBones)
+		{
+			if (Bones.SkeletonGuid == Skeleton->GetGuid() && Bones.SkeletonBoneIndices.Num() == CookedLimits.Num())
+			{
+				Bones.SkeletonBoneIndices[Offset + Index] = Skeleton->GetReferenceSkeleton().FindBoneIndex(Limit->DrivingBone.BoneName);
+			}
+		}
+	}
+}
+
+void UKawaiiPhysicsLimitsDataAsset::OnLimitUpdated(ECollisionLimitType Type, int32 Index)
+{
+	CookLimit(Type, Index);
+
+	++Revision;
+	UpdatedLimitRevision = Revision;
+	UpdatedLimitType = Type;
+	UpdatedLimitIndex = Index;
+}
+
+void UKawaiiPhysicsLimitsDataAsset::OnLimitsRebuilt()
+{
+	CookLimits();
+
+	++Revision;
+	UpdatedLimitRevision = INDEX_NONE;
 }
 
 
 #endif
+
+void UKawaiiPhysicsLimitsDataAsset::PostLoad()
+{
+	Super::PostLoad();
+
+	// Saved before the limits were cooked
+	int32 Offset = 0;
+	int32 Num = 0;
+	if (!GetCookedLimitsRange(ECollisionLimitType::Spherical, Offset, Num))
+	{
+		CookLimits();
+	}
+}
+
+TArrayView<const FKawaiiPhysicsCookedLimit> UKawaiiPhysicsLimitsDataAsset::GetCookedLimits(ECollisionLimitType Type) const
+{
+	int32 Offset = 0;
+	int32 Num = 0;
+	if (!GetCookedLimitsRange(Type, Offset, Num))
+	{
+		return TArrayView<const FKawaiiPhysicsCookedLimit>();
+	}
+	return MakeArrayView(CookedLimits.GetData() + Offset, Num);
+}
+
+TArrayView<const int32> UKawaiiPhysicsLimitsDataAsset::FindCookedBoneIndices(const USkeleton* Skeleton, ECollisionLimitType Type) const
+{
+	int32 Offset = 0;
+	int32 Num = 0;
+	if (!Skeleton || !GetCookedLimitsRange(Type, Offset, Num))
+	{
+		return TArrayView<const int32>();
+	}
+
+	const FGuid SkeletonGuid = Skeleton->GetGuid();
+	for (const FKawaiiPhysicsCookedLimitBones& Bones : CookedLimitBones)
+	{
+		if (Bones.SkeletonGuid == SkeletonGuid && Bones.SkeletonBoneIndices.Num() == CookedLimits.Num())
+		{
+			return MakeArrayView(Bones.SkeletonBoneIndices.GetData() + Offset, Num);
+		}
+	}
+	return TArrayView<const int32>();
+}
+
+bool UKawaiiPhysicsLimitsDataAsset::GetCookedLimitsRange(ECollisionLimitType Type, int32& OutOffset, int32& OutNum) const
+{
+	if (CookedLimits.Num() != SphericalLimits.Num() + CapsuleLimits.Num() + PlanarLimits.Num())
+	{
+		return false;
+	}
+
+	switch (Type)
+	{
+		case ECollisionLimitType::Spherical:
+			OutOffset = 0;
+			OutNum = SphericalLimits.Num();
+			return true;
+		case ECollisionLimitType::Capsule:
+			OutOffset = SphericalLimits.Num();
+			OutNum = CapsuleLimits.Num();
+			return true;
+		case ECollisionLimitType::Planar:
+			OutOffset = SphericalLimits.Num() + CapsuleLimits.Num();
+			OutNum = PlanarLimits.Num();
+			return true;
+	}
+	return false;
+}
+
+void UKawaiiPhysicsLimitsDataAsset::CookLimits()
+{
+	CookedLimits.Reset(SphericalLimits.Num() + CapsuleLimits.Num() + PlanarLimits.Num());
+	AddCookedLimits(SphericalLimits, CookedLimits);
+	AddCookedLimits(CapsuleLimits, CookedLimits);
+	AddCookedLimits(PlanarLimits, CookedLimits);
+
+#if WITH_EDITORONLY_DATA
+	CookedLimitBones.Reset(TargetSkeletons.Num());
+	for (const USkeleton* Skeleton : TargetSkeletons)
+	{
+		if (!Skeleton)
+		{
+			continue;
+		}
+
+		FKawaiiPhysicsCookedLimitBones& Bones = CookedLimitBones.AddDefaulted_GetRef();
+		Bones.SkeletonGuid = Skeleton->GetGuid();
+		Bones.SkeletonBoneIndices.Reserve(CookedLimits.Num());
+		AddCookedBoneIndices(SphericalLimits, Skeleton->GetReferenceSkeleton(), Bones.SkeletonBoneIndices);
+		AddCookedBoneIndices(CapsuleLimits, Skeleton->GetReferenceSkeleton(), Bones.SkeletonBoneIndices);
+		AddCookedBoneIndices(PlanarLimits, Skeleton->GetReferenceSkeleton(), Bones.SkeletonBoneIndices);
+	}
+#else
+	// Driving bones are resolved by name until the asset is saved in editor again
+	CookedLimitBones.Reset();
+#endif
+}
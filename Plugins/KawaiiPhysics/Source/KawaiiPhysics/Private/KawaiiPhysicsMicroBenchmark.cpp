@@ -0,0 +1,458 @@
+// Copyright (c) 2019-2020 pafuhana1213. Licensed under the MIT License.
+
+
+#include "KawaiiPhysicsMicroBenchmark.h"
+#include "AnimNode_KawaiiPhysics.h"
+#include "KawaiiPhysicsSolver.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "PhysicsEngine/SkeletalBodySetup.h"
+#include "UObject/Package.h"
+#include "UObject/StrongObjectPtr.h"
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice GKawaiiPhysicsMicroBenchmarkCommand(
+	TEXT("KawaiiPhysics.MicroBenchmark"),
+	TEXT("Measures cycles per pair of each collision primitive and solver phase. Args: Bones=32 Colliders=1,4,16,64 Iterations=100 Runs=5 Baseline=<csv> Threshold=10 SaveBaseline"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		FKawaiiPhysicsMicroBenchmark::Run(Ar, Args);
+	}));
+#endif
+
+namespace
+{
+	// Bones and colliders are scattered in this box so that a part of the pairs overlap
+	const float SceneExtent = 50.0f;
+
+	FVector RandPointInScene(FRandomStream& Random)
+	{
+		return FVector(Random.FRandRange(-SceneExtent, SceneExtent), Random.FRandRange(-SceneExtent, SceneExtent), Random.FRandRange(-SceneExtent, SceneExtent));
+	}
+
+	FRotator RandRotator(FRandomStream& Random)
+	{
+		return FRotator(Random.FRandRange(-180.0f, 180.0f), Random.FRandRange(-180.0f, 180.0f), Random.FRandRange(-180.0f, 180.0f));
+	}
+
+	FQuat RandRotation(FRandomStream& Random)
+	{
+		return RandRotator(Random).Quaternion();
+	}
+
+	enum class EPhysicsAssetElem : uint8
+	{
+		Sphere,
+		Box,
+		Sphyl,
+		TaperedCapsule,
+	};
+
+	/** Add a body with one element of the type. The element is offset from the body so that its transform is not identity */
+	USkeletalBodySetup* AddBody(UPhysicsAsset* PhysicsAsset, EPhysicsAssetElem ElemType, FRandomStream& Random)
+	{
+		USkeletalBodySetup* BodySetup = NewObject<USkeletalBodySetup>(PhysicsAsset);
+		FKAggregateGeom& AggGeom = BodySetup->AggGeom;
+		const FVector Center = Random.VRand() * 5.0f;
+		switch (ElemType)
+		{
+		case EPhysicsAssetElem::Sphere:
+			AggGeom.SphereElems.Add_GetRef(FKSphereElem(Random.FRandRange(5.0f, 15.0f))).Center = Center;
+			break;
+		case EPhysicsAssetElem::Box:
+		{
+			FKBoxElem& Box = AggGeom.BoxElems.Add_GetRef(FKBoxElem(Random.FRandRange(10.0f, 30.0f), Random.FRandRange(10.0f, 30.0f), Random.FRandRange(10.0f, 30.0f)));
+			Box.Center = Center;
+			Box.Rotation = RandRotator(Random);
+			break;
+		}
+		case EPhysicsAssetElem::Sphyl:
+		{
+			FKSphylElem& Sphyl = AggGeom.SphylElems.Add_GetRef(FKSphylElem(Random.FRandRange(5.0f, 15.0f), Random.FRandRange(10.0f, 40.0f)));
+			Sphyl.Center = Center;
+			Sphyl.Rotation = RandRotator(Random);
+			break;
+		}
+		case EPhysicsAssetElem::TaperedCapsule:
+		{
+			FKTaperedCapsuleElem& Capsule = AggGeom.TaperedCapsuleElems.Add_GetRef(FKTaperedCapsuleElem(Random.FRandRange(5.0f, 15.0f), Random.FRandRange(5.0f, 15.0f), Random.FRandRange(10.0f, 40.0f)));
+			Capsule.Center = Center;
+			Capsule.Rotation = RandRotator(Random);
+			break;
+		}
+		}
+		PhysicsAsset->SkeletalBodySetups.Add(BodySetup);
+		return BodySetup;
+	}
+
+	struct FBenchmarkResult
+	{
+		FString Name;
+		int32 NumColliders = 0;
+		double CyclesPerPair = 0.0;
+	};
+
+	FString MakeResultKey(const FString& Name, int32 NumColliders)
+	{
+		return FString::Printf(TEXT("%s,%d"), *Name, NumColliders);
+	}
+
+	bool SaveBaseline(const FString& Filename, const TArray<FBenchmarkResult>& Results)
+	{
+		FString Output = TEXT("Phase,Colliders,CyclesPerPair\n");
+		for (const FBenchmarkResult& Result : Results)
+		{
+			Output += FString::Printf(TEXT("%s,%.4f\n"), *MakeResultKey(Result.Name, Result.NumColliders), Result.CyclesPerPair);
+		}
+		return FFileHelper::SaveStringToFile(Output, *Filename);
+	}
+
+	bool LoadBaseline(const FString& Filename, TMap<FString, double>& OutBaseline)
+	{
+		TArray<FString> Lines;
+		if (!FFileHelper::LoadFileToStringArray(Lines, *Filename))
+		{
+			return false;
+		}
+
+		// Skip the header line
+		for (int32 i = 1; i < Lines.Num(); ++i)
+		{
+			TArray<FString> Values;
+			Lines[i].ParseIntoArray(Values, TEXT(","));
+			if (Values.Num() == 3)
+			{
+				OutBaseline.Add(MakeResultKey(Values[0], FCString::Atoi(*Values[1])), FCString::Atod(*Values[2]));
+			}
+		}
+		return true;
+	}
+}
+
+bool FKawaiiPhysicsMicroBenchmark::Run(FOutputDevice& Ar, const TArray<FString>& Args)
+{
+	int32 NumBones = 32;
+	TArray<int32> ColliderCounts = { 1, 4, 16, 64 };
+	int32 NumIterations = 100;
+	int32 NumRuns = 5;
+	FString BaselineFilename = FPaths::ProjectSavedDir() / TEXT("KawaiiPhysics/MicroBenchmarkBaseline.csv");
+	float Threshold = 10.0f;
+	bool bSaveBaseline = false;
+
+	for (const FString& Arg : Args)
+	{
+		FParse::Value(*Arg, TEXT("Bones="), NumBones);
+		FParse::Value(*Arg, TEXT("Iterations="), NumIterations);
+		FParse::Value(*Arg, TEXT("Runs="), NumRuns);
+		FParse::Value(*Arg, TEXT("Baseline="), BaselineFilename);
+		FParse::Value(*Arg, TEXT("Threshold="), Threshold);
+		bSaveBaseline |= Arg == TEXT("SaveBaseline");
+
+		FString CountsValue;
+		if (FParse::Value(*Arg, TEXT("Colliders="), CountsValue, false))
+		{
+			TArray<FString> CountStrings;
+			CountsValue.ParseIntoArray(CountStrings, TEXT(","));
+			ColliderCounts.Reset();
+			for (const FString& CountString : CountStrings)
+			{
+				ColliderCounts.Add(FMath::Max(FCString::Atoi(*CountString), 1));
+			}
+		}
+	}
+	NumBones = FMath::Max(NumBones, 2);
+	NumIterations = FMath::Max(NumIterations, 1);
+	NumRuns = FMath::Max(NumRuns, 1);
+
+	// Fixed seed so that every build measures the same layout
+	FRandomStream Random(0);
+
+	FAnimNode_KawaiiPhysics Node;
+	Node.ModifyBones.SetNum(NumBones);
+	TArray<FVector> InitialLocations;
+	for (int32 i = 0; i < NumBones; ++i)
+	{
+		FKawaiiPhysicsModifyBone& Bone = Node.ModifyBones[i];
+		Bone.ParentIndex = i - 1;
+		Bone.Location = RandPointInScene(Random);
+		Bone.PrevLocation = Bone.Location + Random.VRand();
+		Bone.PoseLocation = RandPointInScene(Random);
+		Bone.Rotation = FQuat::Identity;
+		Bone.PoseRotation = FQuat::Identity;
+		Bone.LengthFromRoot = 0.0f;
+		Bone.PhysicsSettings.Radius = 5.0f;
+		Bone.PhysicsSettings.LimitAngle = 30.0f;
+		InitialLocations.Add(Bone.Location);
+	}
+
+	// Collisions move the bones. Restore them before each iteration to measure the same amount of push outs
+	auto RestoreBones = [&Node, &InitialLocations]()
+	{
+		for (int32 i = 0; i < InitialLocations.Num(); ++i)
+		{
+			Node.ModifyBones[i].Location = InitialLocations[i];
+		}
+	};
+
+	TArray<FBenchmarkResult> Results;
+	auto Measure = [&](const TCHAR* Name, int32 NumColliders, int32 NumPairsPerPass, TFunctionRef<void()> Pass)
+	{
+		uint64 MinCycles = MAX_uint64;
+		for (int32 RunIndex = 0; RunIndex < NumRuns; ++RunIndex)
+		{
+			uint64 Cycles = 0;
+			for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+			{
+				RestoreBones();
+				const uint64 StartCycles = FPlatformTime::Cycles64();
+				Pass();
+				Cycles += FPlatformTime::Cycles64() - StartCycles;
+			}
+			MinCycles = FMath::Min(MinCycles, Cycles);
+		}
+
+		const double CyclesPerPair = (double)MinCycles / ((double)NumIterations * NumPairsPerPass);
+		Results.Add({ Name, NumColliders, CyclesPerPair });
+		Ar.Logf(TEXT("%-24s %9d %12.2f %10.2f"), Name, NumColliders, CyclesPerPair, CyclesPerPair * FPlatformTime::GetSecondsPerCycle64() * 1000000000.0);
+	};
+
+	Ar.Logf(TEXT("KawaiiPhysics micro benchmark: %d bones, %d iterations, min of %d runs"), NumBones, NumIterations, NumRuns);
+	Ar.Logf(TEXT("%-24s %9s %12s %10s"), TEXT("Phase"), TEXT("Colliders"), TEXT("Cycles/Pair"), TEXT("ns/Pair"));
+
+	const int32 NumSimulatedBones = NumBones - 1;
+
+	// Per bone phases
+	{
+		KawaiiPhysicsSolver::FStepParams StepParams;
+		StepParams.DeltaTime = 1.0f / 60.0f;
+		StepParams.DeltaTimeOld = 1.0f / 60.0f;
+		StepParams.GravityStep = KawaiiPhysicsSolver::CalcGravityStep(FVector(0.0f, 0.0f, -980.0f), StepParams.DeltaTime, false);
+		StepParams.MoveVector = FVector(1.0f, 0.0f, 0.0f);
+		StepParams.MoveRotation = FQuat(FVector::UpVector, 0.01f);
+
+		KawaiiPhysicsSolver::FBoneParams BoneParams;
+		BoneParams.Damping = 0.1f;
+		BoneParams.WorldDampingLocation = 0.8f;
+		BoneParams.WorldDampingRotation = 0.8f;
+		BoneParams.Stiffness = 0.05f;
+
+		Measure(TEXT("Integrate"), 0, NumSimulatedBones, [&]()
+		{
+			for (int32 i = 1; i < NumBones; ++i)
+			{
+				FKawaiiPhysicsModifyBone& Bone = Node.ModifyBones[i];
+				const FKawaiiPhysicsModifyBone& ParentBone = Node.ModifyBones[i - 1];
+				const FVector BaseLocation = ParentBone.Location + (Bone.PoseLocation - ParentBone.PoseLocation);
+				Bone.Location = KawaiiPhysicsSolver::Integrate(Bone.Location, Bone.PrevLocation, BaseLocation, FVector::ZeroVector, BoneParams, StepParams);
+			}
+		});
+
+		Measure(TEXT("AngleLimit"), 0, NumSimulatedBones, [&]()
+		{
+			for (int32 i = 1; i < NumBones; ++i)
+			{
+				FKawaiiPhysicsModifyBone& Bone = Node.ModifyBones[i];
+				const FKawaiiPhysicsModifyBone& ParentBone = Node.ModifyBones[i - 1];
+				KawaiiPhysicsSolver::ApplyAngleLimit(Bone.Location, ParentBone.Location, Bone.PoseLocation, ParentBone.PoseLocation, Bone.PhysicsSettings.LimitAngle);
+			}
+		});
+	}
+
+	// Per bone and collider phases
+	for (const int32 NumColliders : ColliderCounts)
+	{
+		const int32 NumPairs = NumSimulatedBones * NumColliders;
+
+		// Every bone reaches every collider
+		TArray<int32> LimitIndices;
+		for (int32 i = 0; i < NumColliders; ++i)
+		{
+			LimitIndices.Add(i);
+		}
+
+		TArray<FSphericalLimit> Spheres;
+		Spheres.SetNum(NumColliders);
+		for (FSphericalLimit& Sphere : Spheres)
+		{
+			Sphere.Location = RandPointInScene(Random);
+			Sphere.Radius = Random.FRandRange(5.0f, 15.0f);
+		}
+		Measure(TEXT("Sphere Outer"), NumColliders, NumPairs, [&]()
+		{
+			for (int32 i = 1; i < NumBones; ++i)
+			{
+				Node.AdjustBySphereCollision(Node.ModifyBones[i - 1], Node.ModifyBones[i], Spheres, LimitIndices);
+			}
+		});
+
+		for (FSphericalLimit& Sphere : Spheres)
+		{
+			Sphere.LimitType = ESphericalLimitType::Inner;
+			Sphere.Radius = Random.FRandRange(SceneExtent, SceneExtent * 2.0f);
+		}
+		Measure(TEXT("Sphere Inner"), NumColliders, NumPairs, [&]()
+		{
+			for (int32 i = 1; i < NumBones; ++i)
+			{
+				Node.AdjustBySphereCollision(Node.ModifyBones[i - 1], Node.ModifyBones[i], Spheres, LimitIndices);
+			}
+		});
+
+		TArray<FCapsuleLimit> Capsules;
+		Capsules.SetNum(NumColliders);
+		for (FCapsuleLimit& Capsule : Capsules)
+		{
+			Capsule.Location = RandPointInScene(Random);
+			Capsule.Rotation = RandRotation(Random);
+			Capsule.Radius = Random.FRandRange(5.0f, 15.0f);
+			Capsule.Length = Random.FRandRange(10.0f, 40.0f);
+		}
+		Measure(TEXT("Capsule"), NumColliders, NumPairs, [&]()
+		{
+			for (int32 i = 1; i < NumBones; ++i)
+			{
+				Node.AdjustByCapsuleCollision(Node.ModifyBones[i - 1], Node.ModifyBones[i], Capsules, LimitIndices);
+			}
+		});
+
+		TArray<FPlanarLimit> Planes;
+		Planes.SetNum(NumColliders);
+		for (FPlanarLimit& Plane : Planes)
+		{
+			Plane.Location = RandPointInScene(Random);
+			Plane.Rotation = RandRotation(Random);
+			Plane.Plane = FPlane(Plane.Location, Plane.Rotation.GetUpVector());
+		}
+		Measure(TEXT("Planar"), NumColliders, NumPairs, [&]()
+		{
+			for (int32 i = 1; i < NumBones; ++i)
+			{
+				Node.AdjustByPlanerCollision(Node.ModifyBones[i - 1], Node.ModifyBones[i], Planes, LimitIndices);
+			}
+		});
+
+		// Physics asset as limits. One body per collider, each with one element of the type
+		const struct
+		{
+			const TCHAR* Name;
+			EPhysicsAssetElem ElemType;
+		} PhysicsAssetCases[] =
+		{
+			{ TEXT("PhysicsAsset Sphere"), EPhysicsAssetElem::Sphere },
+			{ TEXT("PhysicsAsset Box"), EPhysicsAssetElem::Box },
+			{ TEXT("PhysicsAsset Sphyl"), EPhysicsAssetElem::Sphyl },
+			{ TEXT("PhysicsAsset Tapered"), EPhysicsAssetElem::TaperedCapsule },
+		};
+		TArray<FTransform> BodyTransforms;
+		TArray<int32> BodyBoneIndices;
+		for (int32 i = 0; i < NumColliders; ++i)
+		{
+			BodyTransforms.Add(FTransform(RandRotation(Random), RandPointInScene(Random)));
+			BodyBoneIndices.Add(i);
+		}
+		Node.bUsePhysicsAssetAsLimits = true;
+		Node.InputSnapshot.LimitBodyTransforms = BodyTransforms;
+		Node.InputSnapshot.LimitBodyBoneIndices = BodyBoneIndices;
+
+		for (const auto& Case : PhysicsAssetCases)
+		{
+			TStrongObjectPtr<UPhysicsAsset> PhysicsAsset(NewObject<UPhysicsAsset>(GetTransientPackage()));
+			for (int32 i = 0; i < NumColliders; ++i)
+			{
+				AddBody(PhysicsAsset.Get(), Case.ElemType, Random);
+			}
+			Node.UsePhysicsAssetAsLimits = PhysicsAsset.Get();
+			Measure(Case.Name, NumColliders, NumPairs, [&]()
+			{
+				for (int32 i = 1; i < NumBones; ++i)
+				{
+					Node.AdjustByPhysicsAssetCollision(Node.ModifyBones[i - 1], Node.ModifyBones[i]);
+				}
+			});
+		}
+
+		// Physics asset as shapes. Each bone has a sphere and a sphyl, and the limit bodies cycle through the element types.
+		// The sphere of the bone and the sphyl of the parent are each tested with every limit element
+		{
+			TStrongObjectPtr<UPhysicsAsset> LimitsPhysicsAsset(NewObject<UPhysicsAsset>(GetTransientPackage()));
+			for (int32 i = 0; i < NumColliders; ++i)
+			{
+				AddBody(LimitsPhysicsAsset.Get(), PhysicsAssetCases[i % UE_ARRAY_COUNT(PhysicsAssetCases)].ElemType, Random);
+			}
+			TStrongObjectPtr<UPhysicsAsset> ShapesPhysicsAsset(NewObject<UPhysicsAsset>(GetTransientPackage()));
+			for (int32 i = 0; i < NumBones; ++i)
+			{
+				USkeletalBodySetup* BodySetup = AddBody(ShapesPhysicsAsset.Get(), EPhysicsAssetElem::Sphere, Random);
+				BodySetup->AggGeom.SphylElems.Add(FKSphylElem(Random.FRandRange(3.0f, 6.0f), Random.FRandRange(5.0f, 10.0f)));
+				Node.ModifyBones[i].BoneRef.BoneIndex = i;
+				Node.ModifyBones[i].PhysicsBodySetup = BodySetup;
+			}
+			Node.UsePhysicsAssetAsLimits = LimitsPhysicsAsset.Get();
+			Node.bUsePhysicsAssetAsShapes = true;
+			Measure(TEXT("PhysicsAsset Shapes"), NumColliders, NumPairs * 2, [&]()
+			{
+				for (int32 i = 1; i < NumBones; ++i)
+				{
+					Node.AdjustByPhysicsAssetCollision(Node.ModifyBones[i - 1], Node.ModifyBones[i]);
+				}
+			});
+
+			for (FKawaiiPhysicsModifyBone& Bone : Node.ModifyBones)
+			{
+				Bone.BoneRef.BoneIndex = INDEX_NONE;
+				Bone.PhysicsBodySetup = nullptr;
+			}
+		}
+
+		// The other primitives are measured without physics assets
+		Node.bUsePhysicsAssetAsShapes = false;
+		Node.bUsePhysicsAssetAsLimits = false;
+		Node.UsePhysicsAssetAsLimits = nullptr;
+		Node.InputSnapshot.LimitBodyTransforms.Reset();
+		Node.InputSnapshot.LimitBodyBoneIndices.Reset();
+	}
+
+	if (bSaveBaseline)
+	{
+		if (!SaveBaseline(BaselineFilename, Results))
+		{
+			Ar.Logf(ELogVerbosity::Error, TEXT("Failed to write the baseline %s"), *BaselineFilename);
+			return false;
+		}
+		Ar.Logf(TEXT("Saved the baseline %s"), *BaselineFilename);
+		return true;
+	}
+
+	// Compare with the baseline of this machine. Cycles are not comparable between machines
+	TMap<FString, double> Baseline;
+	if (!LoadBaseline(BaselineFilename, Baseline))
+	{
+		Ar.Logf(TEXT("No baseline %s. Run with SaveBaseline to store one"), *BaselineFilename);
+		return true;
+	}
+
+	int32 NumRegressions = 0;
+	Ar.Logf(TEXT("Baseline %s, threshold %.1f%%"), *BaselineFilename, Threshold);
+	for (const FBenchmarkResult& Result : Results)
+	{
+		const double* BaselineCyclesPerPair = Baseline.Find(MakeResultKey(Result.Name, Result.NumColliders));
+		if (BaselineCyclesPerPair == nullptr || *BaselineCyclesPerPair <= 0.0)
+		{
+			continue;
+		}
+
+		const double Change = (Result.CyclesPerPair / *BaselineCyclesPerPair - 1.0) * 100.0;
+		if (Change > Threshold)
+		{
+			++NumRegressions;
+			Ar.Logf(ELogVerbosity::Error, TEXT("%-24s %9d %12.2f %+9.1f%% Regressed"), *Result.Name, Result.NumColliders, *BaselineCyclesPerPair, Change);
+		}
+		else
+		{
+			Ar.Logf(TEXT("%-24s %9d %12.2f %+9.1f%%"), *Result.Name, Result.NumColliders, *BaselineCyclesPerPair, Change);
+		}
+	}
+	return NumRegressions == 0;
+}
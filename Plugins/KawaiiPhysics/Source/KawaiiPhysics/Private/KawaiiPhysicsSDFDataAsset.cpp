@@ -0,0 +1,406 @@
+// Copyright (c) 2019-2020 pafuhana1213. Licensed under the MIT License.
+
+
+#include "KawaiiPhysicsSDFDataAsset.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "PhysicsEngine/SkeletalBodySetup.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/SkeletalMesh.h"
+#include "StaticMeshResources.h"
+#include "AnimationRuntime.h"
+#include "Async/ParallelFor.h"
+
+float UKawaiiPhysicsSDFDataAsset::SampleDistance(const FVector& LocalLocation, FVector& OutGradient) const
+{
+	OutGradient = FVector::ZeroVector;
+
+	if (!IsValidField())
+	{
+		return MAX_flt;
+	}
+
+	const FVector GridLocation = (LocalLocation - BoundsMin) / CellSize;
+	if (GridLocation.X < 0 || GridLocation.Y < 0 || GridLocation.Z < 0 ||
+		GridLocation.X > Dimensions.X - 1 || GridLocation.Y > Dimensions.Y - 1 || GridLocation.Z > Dimensions.Z - 1)
+	{
+		return MAX_flt;
+	}
+
+	const int32 X = FMath::Min(FMath::FloorToInt(GridLocation.X), Dimensions.X - 2);
+	const int32 Y = FMath::Min(FMath::FloorToInt(GridLocation.Y), Dimensions.Y - 2);
+	const int32 Z = FMath::Min(FMath::FloorToInt(GridLocation.Z), Dimensions.Z - 2);
+	const float TX = GridLocation.X - X;
+	const float TY = GridLocation.Y - Y;
+	const float TZ = GridLocation.Z - Z;
+
+	const int32 StrideY = Dimensions.X;
+	const int32 StrideZ = Dimensions.X * Dimensions.Y;
+	const float* Cell = &Distances[X + Y * StrideY + Z * StrideZ];
+	const float D000 = Cell[0];
+	const float D100 = Cell[1];
+	const float D010 = Cell[StrideY];
+	const float D110 = Cell[StrideY + 1];
+	const float D001 = Cell[StrideZ];
+	const float D101 = Cell[StrideZ + 1];
+	const float D011 = Cell[StrideZ + StrideY];
+	const float D111 = Cell[StrideZ + StrideY + 1];
+
+	const float D00 = FMath::Lerp(D000, D100, TX);
+	const float D10 = FMath::Lerp(D010, D110, TX);
+	const float D01 = FMath::Lerp(D001, D101, TX);
+	const float D11 = FMath::Lerp(D011, D111, TX);
+	const float D0 = FMath::Lerp(D00, D10, TY);
+	const float D1 = FMath::Lerp(D01, D11, TY);
+
+	// Partial derivatives of trilinear interpolation
+	OutGradient.X = FMath::Lerp(FMath::Lerp(D100 - D000, D110 - D010, TY), FMath::Lerp(D101 - D001, D111 - D011, TY), TZ);
+	OutGradient.Y = FMath::Lerp(FMath::Lerp(D010 - D000, D110 - D100, TX), FMath::Lerp(D011 - D001, D111 - D101, TX), TZ);
+	OutGradient.Z = D1 - D0;
+	OutGradient /= CellSize;
+
+	// Deep inside a volume the distances from both sides cancel out. Push toward the nearest face of the bounds,
+	// which is always outside of the volume because of the padding
+	if (OutGradient.IsNearlyZero())
+	{
+		const FVector ToMax = FVector(Dimensions.X - 1, Dimensions.Y - 1, Dimensions.Z - 1) - GridLocation;
+		float MinDistance = MAX_flt;
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			if (GridLocation[Axis] < MinDistance)
+			{
+				MinDistance = GridLocation[Axis];
+				OutGradient = FVector::ZeroVector;
+				OutGradient[Axis] = -1.0f;
+			}
+			if (ToMax[Axis] < MinDistance)
+			{
+				MinDistance = ToMax[Axis];
+				OutGradient = FVector::ZeroVector;
+				OutGradient[Axis] = 1.0f;
+			}
+		}
+	}
+
+	return FMath::Lerp(D0, D1, TZ);
+}
+
+#if WITH_EDITOR
+
+namespace
+{
+	// Signed distance from each shape. Location is in the space of AggGeom
+	float GetSignedDistance(const FKSphereElem& Sphere, const FVector& Location)
+	{
+		return (Location - Sphere.Center).Size() - Sphere.Radius;
+	}
+
+	float GetSignedDistance(const FKBoxElem& Box, const FVector& Location)
+	{
+		const FVector LocalLocation = Box.GetTransform().InverseTransformPosition(Location);
+		const FVector Q = LocalLocation.GetAbs() - FVector(Box.X, Box.Y, Box.Z) * 0.5f;
+		const float OutsideDistance = FVector(FMath::Max(Q.X, 0.0f), FMath::Max(Q.Y, 0.0f), FMath::Max(Q.Z, 0.0f)).Size();
+		const float InsideDistance = FMath::Min(Q.GetMax(), 0.0f);
+		return OutsideDistance + InsideDistance;
+	}
+
+	float GetSignedDistance(const FKSphylElem& Capsule, const FVector& Location)
+	{
+		const FVector LocalLocation = Capsule.GetTransform().InverseTransformPosition(Location);
+		const FVector HalfSegment = FVector(0.0f, 0.0f, Capsule.Length * 0.5f);
+		return FMath::PointDistToSegment(LocalLocation, HalfSegment, -HalfSegment) - Capsule.Radius;
+	}
+
+	// Approximation. Radius is interpolated by the closest point on the segment
+	float GetSignedDistance(const FKTaperedCapsuleElem& Capsule, const FVector& Location)
+	{
+		const FVector LocalLocation = Capsule.GetTransform().InverseTransformPosition(Location);
+		const float HalfLength = Capsule.Length * 0.5f;
+		const float ClampedZ = FMath::Clamp(LocalLocation.Z, -HalfLength, HalfLength);
+		const float Alpha = Capsule.Length > 0.0f ? (ClampedZ + HalfLength) / Capsule.Length : 0.5f;
+		return (LocalLocation - FVector(0.0f, 0.0f, ClampedZ)).Size() - FMath::Lerp(Capsule.Radius1, Capsule.Radius0, Alpha);
+	}
+
+	// Exact inside and on the face regions, underestimated near edges and corners
+	float GetSignedDistance(const FKConvexElem& Convex, const TArray<FPlane>& Planes, const FVector& Location)
+	{
+		const FVector LocalLocation = Convex.GetTransform().InverseTransformPosition(Location);
+		float Distance = -MAX_flt;
+		for (const FPlane& Plane : Planes)
+		{
+			Distance = FMath::Max(Distance, Plane.PlaneDot(LocalLocation));
+		}
+		return Distance;
+	}
+
+	struct FSDFBakeSource
+	{
+		const FKAggregateGeom* AggGeom;
+		FTransform Transform;
+		TArray<TArray<FPlane>> ConvexPlanes;
+	};
+
+	/** Triangles of a mesh surface. Bounding sphere of each triangle skips most of the closest point tests */
+	struct FSDFBakeMesh
+	{
+		TArray<FVector> Vertices;
+		TArray<uint32> Indices;
+		TArray<FVector> TriangleCenters;
+		TArray<float> TriangleRadii;
+	};
+
+	bool GetStaticMeshSurface(const UStaticMesh* StaticMesh, FSDFBakeMesh& OutMesh)
+	{
+		if (!StaticMesh->RenderData || StaticMesh->RenderData->LODResources.Num() == 0)
+		{
+			return false;
+		}
+
+		const FStaticMeshLODResources& LOD = StaticMesh->RenderData->LODResources[0];
+		const FPositionVertexBuffer& PositionVertexBuffer = LOD.VertexBuffers.PositionVertexBuffer;
+		OutMesh.Vertices.SetNumUninitialized(PositionVertexBuffer.GetNumVertices());
+		for (int32 i = 0; i < OutMesh.Vertices.Num(); ++i)
+		{
+			OutMesh.Vertices[i] = PositionVertexBuffer.VertexPosition(i);
+		}
+		LOD.IndexBuffer.GetCopy(OutMesh.Indices);
+
+		const int32 NumTriangles = OutMesh.Indices.Num() / 3;
+		OutMesh.TriangleCenters.SetNumUninitialized(NumTriangles);
+		OutMesh.TriangleRadii.SetNumUninitialized(NumTriangles);
+		for (int32 i = 0; i < NumTriangles; ++i)
+		{
+			const FVector& A = OutMesh.Vertices[OutMesh.Indices[i * 3]];
+			const FVector& B = OutMesh.Vertices[OutMesh.Indices[i * 3 + 1]];
+			const FVector& C = OutMesh.Vertices[OutMesh.Indices[i * 3 + 2]];
+			const FVector Center = (A + B + C) / 3.0f;
+			OutMesh.TriangleCenters[i] = Center;
+			OutMesh.TriangleRadii[i] = FMath::Sqrt(FMath::Max3((A - Center).SizeSquared(), (B - Center).SizeSquared(), (C - Center).SizeSquared()));
+		}
+		return NumTriangles > 0;
+	}
+
+	float GetUnsignedDistance(const FSDFBakeMesh& Mesh, const FVector& Location)
+	{
+		float DistanceSquared = MAX_flt;
+		float Distance = MAX_flt;
+		for (int32 i = 0; i < Mesh.TriangleCenters.Num(); ++i)
+		{
+			// Every point of the triangle is farther than the closest one found
+			if ((Location - Mesh.TriangleCenters[i]).Size() - Mesh.TriangleRadii[i] >= Distance)
+			{
+				continue;
+			}
+
+			const FVector ClosestPoint = FMath::ClosestPointOnTriangleToPoint(Location,
+				Mesh.Vertices[Mesh.Indices[i * 3]], Mesh.Vertices[Mesh.Indices[i * 3 + 1]], Mesh.Vertices[Mesh.Indices[i * 3 + 2]]);
+			const float NewDistanceSquared = (Location - ClosestPoint).SizeSquared();
+			if (NewDistanceSquared < DistanceSquared)
+			{
+				DistanceSquared = NewDistanceSquared;
+				Distance = FMath::Sqrt(DistanceSquared);
+			}
+		}
+		return Distance;
+	}
+
+	// X of the intersections of the mesh and a ray along X axis, sorted. Inside of a closed mesh has odd number of them before
+	void GetRayIntersectionsX(const FSDFBakeMesh& Mesh, float Y, float Z, TArray<float>& OutIntersections)
+	{
+		OutIntersections.Reset();
+		for (int32 i = 0; i + 2 < Mesh.Indices.Num(); i += 3)
+		{
+			const FVector& A = Mesh.Vertices[Mesh.Indices[i]];
+			const FVector& B = Mesh.Vertices[Mesh.Indices[i + 1]];
+			const FVector& C = Mesh.Vertices[Mesh.Indices[i + 2]];
+
+			// Barycentric coordinates of the triangle projected onto YZ plane
+			const float Area = (B.Y - A.Y) * (C.Z - A.Z) - (C.Y - A.Y) * (B.Z - A.Z);
+			if (FMath::Abs(Area) <= SMALL_NUMBER)
+			{
+				continue;
+			}
+			const float U = ((B.Y - Y) * (C.Z - Z) - (C.Y - Y) * (B.Z - Z)) / Area;
+			const float V = ((Y - A.Y) * (C.Z - A.Z) - (C.Y - A.Y) * (Z - A.Z)) / Area;
+			const float W = 1.0f - U - V;
+			if (U >= 0.0f && V >= 0.0f && W >= 0.0f)
+			{
+				OutIntersections.Add(U * A.X + V * B.X + W * C.X);
+			}
+		}
+		OutIntersections.Sort();
+	}
+
+	float GetSignedDistance(const FSDFBakeSource& Source, const FVector& Location)
+	{
+		const FVector SourceLocation = Source.Transform.InverseTransformPosition(Location);
+		const FKAggregateGeom* AggGeom = Source.AggGeom;
+
+		float Distance = MAX_flt;
+		for (const FKSphereElem& Elem : AggGeom->SphereElems)
+		{
+			Distance = FMath::Min(Distance, GetSignedDistance(Elem, SourceLocation));
+		}
+		for (const FKBoxElem& Elem : AggGeom->BoxElems)
+		{
+			Distance = FMath::Min(Distance, GetSignedDistance(Elem, SourceLocation));
+		}
+		for (const FKSphylElem& Elem : AggGeom->SphylElems)
+		{
+			Distance = FMath::Min(Distance, GetSignedDistance(Elem, SourceLocation));
+		}
+		for (const FKTaperedCapsuleElem& Elem : AggGeom->TaperedCapsuleElems)
+		{
+			Distance = FMath::Min(Distance, GetSignedDistance(Elem, SourceLocation));
+		}
+		for (int32 i = 0; i < AggGeom->ConvexElems.Num(); ++i)
+		{
+			if (Source.ConvexPlanes[i].Num() > 0)
+			{
+				Distance = FMath::Min(Distance, GetSignedDistance(AggGeom->ConvexElems[i], Source.ConvexPlanes[i], SourceLocation));
+			}
+		}
+		return Distance;
+	}
+}
+
+void UKawaiiPhysicsSDFDataAsset::Bake()
+{
+	TArray<FSDFBakeSource> Sources;
+	FSDFBakeMesh Mesh;
+
+	// The surface of the static mesh. Simple collision is only used if the mesh has no render data
+	const bool bBakeMesh = SourceStaticMesh && GetStaticMeshSurface(SourceStaticMesh, Mesh);
+	if (SourceStaticMesh && !bBakeMesh && SourceStaticMesh->BodySetup)
+	{
+		FSDFBakeSource& Source = Sources.AddDefaulted_GetRef();
+		Source.AggGeom = &SourceStaticMesh->BodySetup->AggGeom;
+		Source.Transform = FTransform::Identity;
+	}
+
+	if (SourcePhysicsAsset)
+	{
+		const USkeletalMesh* PreviewMesh = SourcePhysicsAsset->GetPreviewMesh();
+		const FReferenceSkeleton* RefSkeleton = PreviewMesh ? &PreviewMesh->RefSkeleton : nullptr;
+
+		FTransform SourceBoneTransform = FTransform::Identity;
+		if (RefSkeleton && SourceBoneName != NAME_None)
+		{
+			const int32 SourceBoneIndex = RefSkeleton->FindBoneIndex(SourceBoneName);
+			if (SourceBoneIndex != INDEX_NONE)
+			{
+				SourceBoneTransform = FAnimationRuntime::GetComponentSpaceTransformRefPose(*RefSkeleton, SourceBoneIndex);
+			}
+		}
+
+		for (const USkeletalBodySetup* BodySetup : SourcePhysicsAsset->SkeletalBodySetups)
+		{
+			if (!BodySetup || (SourceBodyNames.Num() > 0 && !SourceBodyNames.Contains(BodySetup->BoneName)))
+			{
+				continue;
+			}
+
+			const int32 BoneIndex = RefSkeleton ? RefSkeleton->FindBoneIndex(BodySetup->BoneName) : INDEX_NONE;
+			if (BoneIndex == INDEX_NONE)
+			{
+				continue;
+			}
+
+			FSDFBakeSource& Source = Sources.AddDefaulted_GetRef();
+			Source.AggGeom = &BodySetup->AggGeom;
+			Source.Transform = FAnimationRuntime::GetComponentSpaceTransformRefPose(*RefSkeleton, BoneIndex).GetRelativeTransform(SourceBoneTransform);
+			Source.Transform.RemoveScaling();
+		}
+	}
+
+	FBox Bounds(ForceInit);
+	if (bBakeMesh)
+	{
+		Bounds += FBox(Mesh.Vertices);
+	}
+	for (FSDFBakeSource& Source : Sources)
+	{
+		Bounds += Source.AggGeom->CalcAABB(Source.Transform);
+
+		Source.ConvexPlanes.SetNum(Source.AggGeom->ConvexElems.Num());
+		for (int32 i = 0; i < Source.AggGeom->ConvexElems.Num(); ++i)
+		{
+			Source.AggGeom->ConvexElems[i].GetPlanes(Source.ConvexPlanes[i]);
+		}
+	}
+
+	Distances.Empty();
+	Dimensions = FIntVector::ZeroValue;
+
+	if (Bounds.IsValid)
+	{
+		Bounds = Bounds.ExpandBy(Padding);
+		const FVector Extent = Bounds.GetSize();
+		CellSize = FMath::Max(Extent.GetMax() / (Resolution - 1), KINDA_SMALL_NUMBER);
+		BoundsMin = Bounds.Min;
+		Dimensions = FIntVector(
+			FMath::Max(FMath::CeilToInt(Extent.X / CellSize) + 1, 2),
+			FMath::Max(FMath::CeilToInt(Extent.Y / CellSize) + 1, 2),
+			FMath::Max(FMath::CeilToInt(Extent.Z / CellSize) + 1, 2));
+
+		Distances.SetNumUninitialized(Dimensions.X * Dimensions.Y * Dimensions.Z);
+		ParallelFor(Dimensions.Z, [this, &Sources, &Mesh, bBakeMesh](int32 Z)
+		{
+			TArray<float> Intersections;
+			for (int32 Y = 0; Y < Dimensions.Y; ++Y)
+			{
+				// The ray is slightly off the grid so that it doesn't hit the edges of axis aligned faces
+				if (bBakeMesh)
+				{
+					const FVector RowLocation = BoundsMin + FVector(0.0f, Y + 0.0137f, Z + 0.0071f) * CellSize;
+					GetRayIntersectionsX(Mesh, RowLocation.Y, RowLocation.Z, Intersections);
+				}
+
+				int32 NumIntersectionsBefore = 0;
+				for (int32 X = 0; X < Dimensions.X; ++X)
+				{
+					const FVector Location = BoundsMin + FVector(X, Y, Z) * CellSize;
+
+					float Distance = MAX_flt;
+					for (const FSDFBakeSource& Source : Sources)
+					{
+						Distance = FMath::Min(Distance, GetSignedDistance(Source, Location));
+					}
+
+					if (bBakeMesh)
+					{
+						while (NumIntersectionsBefore < Intersections.Num() && Intersections[NumIntersectionsBefore] < Location.X)
+						{
+							++NumIntersectionsBefore;
+						}
+						const float MeshDistance = GetUnsignedDistance(Mesh, Location);
+						Distance = FMath::Min(Distance, NumIntersectionsBefore % 2 == 1 ? -MeshDistance : MeshDistance);
+					}
+
+					Distances[X + Y * Dimensions.X + Z * Dimensions.X * Dimensions.Y] = Distance;
+				}
+			}
+		});
+	}
+
+	MarkPackageDirty();
+}
+
+void UKawaiiPhysicsSDFDataAsset::PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	const FName PropertyName = PropertyChangedEvent.MemberProperty ? PropertyChangedEvent.MemberProperty->GetFName() : NAME_None;
+
+	if (PropertyName == GET_MEMBER_NAME_CHECKED(UKawaiiPhysicsSDFDataAsset, SourceStaticMesh) ||
+		PropertyName == GET_MEMBER_NAME_CHECKED(UKawaiiPhysicsSDFDataAsset, SourcePhysicsAsset) ||
+		PropertyName == GET_MEMBER_NAME_CHECKED(UKawaiiPhysicsSDFDataAsset, SourceBodyNames) ||
+		PropertyName == GET_MEMBER_NAME_CHECKED(UKawaiiPhysicsSDFDataAsset, SourceBoneName) ||
+		PropertyName == GET_MEMBER_NAME_CHECKED(UKawaiiPhysicsSDFDataAsset, Resolution) ||
+		PropertyName == GET_MEMBER_NAME_CHECKED(UKawaiiPhysicsSDFDataAsset, Padding))
+	{
+		Bake();
+	}
+}
+
+#endif
@@ -0,0 +1,243 @@
+// Copyright (c) 2019-2020 pafuhana1213. Licensed under the MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Integration, collision and constraint math of KawaiiPhysics.
+ * Depends only on math types of Core, not on UObject, skeletal mesh components or pose contexts.
+ * It still needs Core, so it is built as part of the module and not as a standalone library.
+ * FAnimNode_KawaiiPhysics gathers inputs from the pose and the limits and calls into these functions.
+ * Collision against physics asset bodies iterates FKAggregateGeom in the node and uses the shape functions here.
+ */
+namespace KawaiiPhysicsSolver
+{
+	/** Per frame parameters of integration */
+	struct FStepParams
+	{
+		float DeltaTime = 0.0f;
+		float DeltaTimeOld = 0.0f;
+		/** TargetFramerate * DeltaTime. Makes stiffness independent of the frame rate */
+		float StiffnessExponent = 1.0f;
+		/** Movement by gravity in this frame */
+		FVector GravityStep = FVector::ZeroVector;
+		FVector MoveVector = FVector::ZeroVector;
+		FQuat MoveRotation = FQuat::Identity;
+	};
+
+	/** Per bone parameters of integration */
+	struct FBoneParams
+	{
+		float Damping = 0.0f;
+		float WorldDampingLocation = 0.0f;
+		float WorldDampingRotation = 0.0f;
+		float Stiffness = 0.0f;
+	};
+
+	inline FVector CalcGravityStep(const FVector& Gravity, float DeltaTime, bool bOldPhysicsMethod)
+	{
+		// TODO:Migrate if there are more good method (Currently copying AnimDynamics implementation)
+		return bOldPhysicsMethod ? Gravity * DeltaTime : 0.5f * Gravity * DeltaTime * DeltaTime;
+	}
+
+	/**
+	 * Verlet step of one bone. Returns the new location.
+	 * BaseLocation is the location that keeps the pose relative to the parent. ExternalVelocity is added after damping (e.g. wind)
+	 */
+	inline FVector Integrate(const FVector& Location, const FVector& PrevLocation, const FVector& BaseLocation, const FVector& ExternalVelocity,
+		const FBoneParams& Bone, const FStepParams& Step)
+	{
+		// Move using Velocity( = movement amount in pre frame ) and Damping
+		const FVector Velocity = (Location - PrevLocation) / Step.DeltaTimeOld * (1.0f - Bone.Damping) + ExternalVelocity;
+		FVector NewLocation = Location + Velocity * Step.DeltaTime;
+
+		// Follow Translation
+		NewLocation += Step.MoveVector * (1.0f - Bone.WorldDampingLocation);
+
+		// Follow Rotation
+		NewLocation += (Step.MoveRotation.RotateVector(Location) - Location) * (1.0f - Bone.WorldDampingRotation);
+
+		// Gravity
+		NewLocation += Step.GravityStep;
+
+		// Pull to Pose Location
+		NewLocation += (BaseLocation - NewLocation) * (1.0f - FMath::Pow(1.0f - Bone.Stiffness, Step.StiffnessExponent));
+
+		return NewLocation;
+	}
+
+	/** Keep the distance from the parent */
+	inline FVector RestoreBoneLength(const FVector& Location, const FVector& ParentLocation, float BoneLength)
+	{
+		return (Location - ParentLocation).GetSafeNormal() * BoneLength + ParentLocation;
+	}
+
+	/** Rotate a bone around the parent so that the angle from the pose direction is under LimitAngle(degrees). Return true if limited */
+	inline bool ApplyAngleLimit(FVector& Location, const FVector& ParentLocation, const FVector& PoseLocation, const FVector& ParentPoseLocation, float LimitAngle)
+	{
+		FVector BoneDir = (Location - ParentLocation).GetSafeNormal();
+		const FVector PoseDir = (PoseLocation - ParentPoseLocation).GetSafeNormal();
+		const FVector Axis = FVector::CrossProduct(PoseDir, BoneDir);
+		const float Angle = FMath::Atan2(Axis.Size(), FVector::DotProduct(PoseDir, BoneDir));
+		const float AngleOverLimit = FMath::RadiansToDegrees(Angle) - LimitAngle;
+		if (AngleOverLimit <= 0.0f)
+		{
+			return false;
+		}
+
+		BoneDir = BoneDir.RotateAngleAxis(-AngleOverLimit, Axis);
+		Location = BoneDir * (Location - ParentLocation).Size() + ParentLocation;
+		return true;
+	}
+
+	/** Project a bone onto the plane through the parent */
+	inline FVector ApplyPlanarConstraint(const FVector& Location, const FVector& ParentLocation, const FVector& PlaneNormal)
+	{
+		return FVector::PointPlaneProject(Location, FPlane(ParentLocation, PlaneNormal));
+	}
+
+	/** Push a sphere out of a sphere. Return true if pushed */
+	inline bool PushOutFromSphere(FVector& Location, float Radius, const FVector& SphereLocation, float SphereRadius)
+	{
+		const float LimitDistance = Radius + SphereRadius;
+		if ((Location - SphereLocation).SizeSquared() > LimitDistance * LimitDistance)
+		{
+			return false;
+		}
+
+		Location += (LimitDistance - (Location - SphereLocation).Size()) * (Location - SphereLocation).GetSafeNormal();
+		return true;
+	}
+
+	/** Keep a sphere inside of a sphere. Return true if pushed */
+	inline bool PushInToSphere(FVector& Location, float Radius, const FVector& SphereLocation, float SphereRadius, bool bOldPhysicsMethod)
+	{
+		const float LimitDistance = Radius + SphereRadius;
+		if ((Location - SphereLocation).SizeSquared() < LimitDistance * LimitDistance)
+		{
+			return false;
+		}
+
+		const float InnerRadius = bOldPhysicsMethod ? SphereRadius : SphereRadius - Radius;
+		Location = SphereLocation + InnerRadius * (Location - SphereLocation).GetSafeNormal();
+		return true;
+	}
+
+	/** Push a sphere out of a capsule. Return true if pushed */
+	inline bool PushOutFromCapsule(FVector& Location, float Radius, const FVector& StartPoint, const FVector& EndPoint, float CapsuleRadius)
+	{
+		const float LimitDistance = Radius + CapsuleRadius;
+		if (FMath::PointDistToSegmentSquared(Location, StartPoint, EndPoint) >= LimitDistance * LimitDistance)
+		{
+			return false;
+		}
+
+		const FVector ClosestPoint = FMath::ClosestPointOnSegment(Location, StartPoint, EndPoint);
+		Location = ClosestPoint + (Location - ClosestPoint).GetSafeNormal() * LimitDistance;
+		return true;
+	}
+
+	/** Push a sphere to the front side of a plane. Also catches tunneling since PrevLocation. Return true if pushed */
+	inline bool PushOutFromPlane(FVector& Location, const FVector& PrevLocation, float Radius, const FPlane& Plane, const FVector& Normal)
+	{
+		const FVector PointOnPlane = FVector::PointPlaneProject(Location, Plane);
+		const float DistSquared = (Location - PointOnPlane).SizeSquared();
+
+		FVector IntersectionPoint;
+		if (DistSquared >= Radius * Radius && !FMath::SegmentPlaneIntersection(Location, PrevLocation, Plane, IntersectionPoint))
+		{
+			return false;
+		}
+
+		Location = PointOnPlane + Normal * Radius;
+		return true;
+	}
+
+	/** Vector to push a sphere out of an oriented box. Return false if they don't overlap */
+	inline bool CalcSpherePushOutFromBox(const FVector& SphereLocation, float SphereRadius, const FTransform& BoxTM, const FVector& BoxHalfExtent, FVector& OutPushOutVector)
+	{
+		const FVector LocalLocation = BoxTM.InverseTransformPositionNoScale(SphereLocation);
+		const FVector Delta = LocalLocation - LocalLocation.BoundToBox(-BoxHalfExtent, BoxHalfExtent);
+		const float DistSquared = Delta.SizeSquared();
+		if (DistSquared >= SphereRadius * SphereRadius)
+		{
+			return false;
+		}
+
+		FVector LocalPushOutVector = FVector::ZeroVector;
+		if (DistSquared > SMALL_NUMBER)
+		{
+			const float Dist = FMath::Sqrt(DistSquared);
+			LocalPushOutVector = Delta * ((SphereRadius - Dist) / Dist);
+		}
+		else
+		{
+			// Center of the sphere is inside of the box. Push out through the nearest face
+			const FVector Depth = BoxHalfExtent - LocalLocation.GetAbs();
+			const int32 Axis = (Depth.X <= Depth.Y && Depth.X <= Depth.Z) ? 0 : (Depth.Y <= Depth.Z ? 1 : 2);
+			LocalPushOutVector[Axis] = (LocalLocation[Axis] >= 0.0f ? 1.0f : -1.0f) * (Depth[Axis] + SphereRadius);
+		}
+
+		OutPushOutVector = BoxTM.TransformVectorNoScale(LocalPushOutVector);
+		return true;
+	}
+
+	/** Vector to keep an oriented box inside of a sphere. Only the farthest corner from the center is checked */
+	inline FVector CalcBoxPushInToSphere(const FTransform& BoxTM, const FVector& BoxHalfExtent, const FVector& SphereLocation, float SphereRadius)
+	{
+		const FVector LocalLocation = BoxTM.InverseTransformPositionNoScale(SphereLocation);
+		const FVector LocalCorner(
+			LocalLocation.X >= 0.0f ? -BoxHalfExtent.X : BoxHalfExtent.X,
+			LocalLocation.Y >= 0.0f ? -BoxHalfExtent.Y : BoxHalfExtent.Y,
+			LocalLocation.Z >= 0.0f ? -BoxHalfExtent.Z : BoxHalfExtent.Z);
+		const FVector Corner = BoxTM.TransformPositionNoScale(LocalCorner);
+
+		const float Dist = (Corner - SphereLocation).Size();
+		if (Dist <= SphereRadius)
+		{
+			return FVector::ZeroVector;
+		}
+		return (SphereLocation - Corner).GetSafeNormal() * (Dist - SphereRadius);
+	}
+
+	/** Depth of an oriented box into the back side of a plane. Negative if it doesn't penetrate */
+	inline float CalcBoxPlanePenetration(const FTransform& BoxTM, const FVector& BoxHalfExtent, const FPlane& Plane)
+	{
+		const FVector Normal = Plane;
+		const float ProjectedExtent =
+			BoxHalfExtent.X * FMath::Abs(FVector::DotProduct(BoxTM.GetUnitAxis(EAxis::X), Normal)) +
+			BoxHalfExtent.Y * FMath::Abs(FVector::DotProduct(BoxTM.GetUnitAxis(EAxis::Y), Normal)) +
+			BoxHalfExtent.Z * FMath::Abs(FVector::DotProduct(BoxTM.GetUnitAxis(EAxis::Z), Normal));
+		return ProjectedExtent - Plane.PlaneDot(BoxTM.GetLocation());
+	}
+
+	/** Closest point on a segment to an oriented box. Approximated by projecting alternately onto the box and the segment */
+	inline FVector ClosestPointOnSegmentToBox(const FVector& StartPoint, const FVector& EndPoint, const FTransform& BoxTM, const FVector& BoxHalfExtent)
+	{
+		FVector ClosestPoint = FMath::ClosestPointOnSegment(BoxTM.GetLocation(), StartPoint, EndPoint);
+		for (int32 i = 0; i < 2; ++i)
+		{
+			const FVector LocalPointOnBox = BoxTM.InverseTransformPositionNoScale(ClosestPoint).BoundToBox(-BoxHalfExtent, BoxHalfExtent);
+			ClosestPoint = FMath::ClosestPointOnSegment(BoxTM.TransformPositionNoScale(LocalPointOnBox), StartPoint, EndPoint);
+		}
+		return ClosestPoint;
+	}
+
+	/** Vector to push a sphere out of a tapered capsule. Radius is interpolated by the closest point on the segment */
+	inline bool CalcSpherePushOutFromTaperedCapsule(const FVector& SphereLocation, float SphereRadius, const FVector& StartPoint, const FVector& EndPoint, float StartRadius, float EndRadius, FVector& OutPushOutVector)
+	{
+		const FVector Segment = EndPoint - StartPoint;
+		const float SegmentSizeSquared = Segment.SizeSquared();
+		const float Alpha = SegmentSizeSquared > SMALL_NUMBER ? FMath::Clamp(FVector::DotProduct(SphereLocation - StartPoint, Segment) / SegmentSizeSquared, 0.0f, 1.0f) : 0.0f;
+		const FVector Delta = SphereLocation - (StartPoint + Segment * Alpha);
+		const float LimitDistance = SphereRadius + FMath::Lerp(StartRadius, EndRadius, Alpha);
+		if (Delta.SizeSquared() >= LimitDistance * LimitDistance)
+		{
+			return false;
+		}
+
+		OutPushOutVector = Delta.GetSafeNormal() * LimitDistance - Delta;
+		return true;
+	}
+}
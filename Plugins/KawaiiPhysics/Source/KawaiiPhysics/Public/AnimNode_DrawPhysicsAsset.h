@@ -24,12 +24,24 @@ protected:
 	// FAnimNode_SkeletalControlBase interface
 	virtual void OnInitializeAnimInstance(const struct FAnimInstanceProxy* InProxy, const class UAnimInstance* InAnimInstance) override;
 	virtual bool NeedsOnInitializeAnimInstance() const override { return true; }
+	virtual bool HasPreUpdate() const override { return true; }
+	virtual void PreUpdate(const UAnimInstance* InAnimInstance) override;
 	virtual bool IsValidToEvaluate(const class USkeleton* Skeleton, const struct FBoneContainer& RequiredBones) override;
 	virtual void EvaluateSkeletalControl_AnyThread(struct FComponentSpacePoseContext& Output, TArray<struct FBoneTransform>& OutBoneTransforms) override;
+	virtual void InitializeBoneReferences(const struct FBoneContainer& RequiredBones) override;
 	// End of FAnimNode_SkeletalControlBase interface
 
 private:
 	UPROPERTY(Transient)
 	UPhysicsAsset* UsePhysicsAsset = nullptr;
+
+	void UpdatePhysicsAsset(const UAnimInstance* InAnimInstance);
+	void InitializeBodyBoneIndices(const struct FBoneContainer& RequiredBones);
+
+	// Compact pose bone index of each body of BodyBoneIndicesPhysicsAsset
+	TArray<FCompactPoseBoneIndex> BodyBoneIndices;
+	const UPhysicsAsset* BodyBoneIndicesPhysicsAsset = nullptr;
+
+	TWeakObjectPtr<UWorld> DrawWorld;
 };
 
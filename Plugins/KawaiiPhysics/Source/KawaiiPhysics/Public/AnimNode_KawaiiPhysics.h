@@ -13,11 +13,40 @@
 //#include "KawaiiPhysicsLimitsDataAsset.h"
 
 #include "PhysicsEngine/PhysicsAsset.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Templates/Function.h"
+#include "KawaiiPhysicsBodyBoneIndexCache.h"
 
 class UKawaiiPhysicsLimitsDataAsset;
+class UKawaiiPhysicsSDFDataAsset;
+class FKawaiiPhysicsCaptureWriter;
+struct FKawaiiPhysicsCookedLimit;
 
 #include "AnimNode_KawaiiPhysics.generated.h"
 
+/**
+ * Inputs of a node owned by the game thread. Copied in PreUpdate so that the evaluation on a worker thread
+ * touches no component, world or scene. Values are from the end of the previous frame as before
+ */
+struct FKawaiiPhysicsInputSnapshot
+{
+	/** Component space scale of bones by mesh bone index. Only the bones of ModifyBones are filled */
+	TArray<float> BoneScales;
+
+	/** Wind velocity in component space at each of ModifyBones without WindScale and gusts. Empty if wind is disabled */
+	TArray<FVector> WindVelocities;
+
+	/** Mesh bone index and component space transform of each body of UsePhysicsAssetAsLimits */
+	TArray<int32> LimitBodyBoneIndices;
+	TArray<FTransform> LimitBodyTransforms;
+
+	/** Resolves LimitBodyBoneIndices by bone name when the physics asset, the mesh or the number of bodies changes */
+	FKawaiiPhysicsBodyBoneIndexCache LimitBodyBoneIndexCache;
+
+	float Significance = 0.0f;
+};
+
 
 UENUM()
 enum class EPlanarConstraint : uint8
@@ -40,6 +69,17 @@ enum class EBoneForwardAxis : uint8
 };
 
 
+/** Simulation rate chosen by the frame budget (p.KawaiiPhysics.BudgetMicroseconds) */
+UENUM()
+enum class EKawaiiPhysicsSimulationTier : uint8
+{
+	Full,
+	/** Simulate once in p.KawaiiPhysics.BudgetReducedRateInterval frames. Skipped frames are extrapolated */
+	Reduced,
+	/** Don't simulate. Bones follow the root keeping the last result */
+	Frozen,
+};
+
 UENUM()
 enum class ECollisionLimitType : uint8
 {
@@ -47,6 +87,7 @@ enum class ECollisionLimitType : uint8
 	Spherical,
 	Capsule,
 	Planar,
+	SDF,
 };
 
 USTRUCT()
@@ -64,6 +105,10 @@ struct FCollisionLimitBase
 	UPROPERTY(EditAnywhere, Category = CollisionLimitBase, meta = (ClampMin = "-360", ClampMax = "360"))
 	FRotator OffsetRotation = FRotator::ZeroRotator;
 
+	/** Collision groups this limit belongs to. Only bones whose CollisionMask shares a group are tested */
+	UPROPERTY(EditAnywhere, Category = CollisionLimitBase, meta = (Bitmask))
+	int32 CollisionGroup = 1;
+
 	UPROPERTY()
 	FVector Location = FVector::ZeroVector;
 
@@ -142,6 +187,51 @@ struct FPlanarLimit : public FCollisionLimitBase
 	FPlane Plane = FPlane(0, 0, 0, 0);
 };
 
+USTRUCT()
+struct FSDFLimit : public FCollisionLimitBase
+{
+	GENERATED_BODY();
+
+	FSDFLimit()
+	{
+#if WITH_EDITORONLY_DATA
+		Type = ECollisionLimitType::SDF;
+#endif
+	}
+
+	/** Baked signed distance field. Bones are pushed out of the surface */
+	UPROPERTY(EditAnywhere, Category = SDFLimit)
+	UKawaiiPhysicsSDFDataAsset* SDFDataAsset = nullptr;
+};
+
+/**
+ * State of a limit of a data asset in a node. The definition of the limit is shared by every node using the data asset,
+ * and only this is owned by each node. Transforms are in component space
+ */
+struct FKawaiiPhysicsLimitInstance
+{
+	FQuat Rotation = FQuat::Identity;
+	FVector Location = FVector::ZeroVector;
+	FCompactPoseBoneIndex DrivingBoneIndex = FCompactPoseBoneIndex(INDEX_NONE);
+
+	/** Planar limits only */
+	FPlane Plane = FPlane(0, 0, 0, 0);
+};
+
+/**
+ * Limit whose transform follows a driving bone. Limits of the node and of the data asset are sorted by the driving bone
+ * so that each bone is fetched from the pose once per frame
+ */
+struct FKawaiiPhysicsDrivenLimit
+{
+	/** Offset from the driving bone. Precomposed so that the limit is a single transform multiply */
+	FTransform Offset = FTransform::Identity;
+	FCompactPoseBoneIndex DrivingBoneIndex = FCompactPoseBoneIndex(INDEX_NONE);
+	ECollisionLimitType Type = ECollisionLimitType::None;
+	int32 Index = INDEX_NONE;
+	bool bFromDataAsset = false;
+};
+
 USTRUCT(BlueprintType)
 struct KAWAIIPHYSICS_API FKawaiiPhysicsSettings
 {
@@ -163,6 +253,41 @@ struct KAWAIIPHYSICS_API FKawaiiPhysicsSettings
 	float LimitAngle = 0.0f;
 };
 
+USTRUCT()
+struct KAWAIIPHYSICS_API FKawaiiPhysicsBoneCollisionMask
+{
+	GENERATED_BODY()
+
+	/** Bones to apply the mask. The mask is also applied to the child bones of each bone(sub-chain) */
+	UPROPERTY(EditAnywhere, Category = "KawaiiPhysics")
+	TArray<FBoneReference> Bones;
+
+	/** If Bones is empty, the mask is applied to the bones in this range. Use rate of bone length from Root */
+	UPROPERTY(EditAnywhere, Category = "KawaiiPhysics", meta = (ClampMin = "0.0", ClampMax = "1.0", UIMin = "0.0", UIMax = "1.0"))
+	float MinLengthRate = 0.0f;
+	UPROPERTY(EditAnywhere, Category = "KawaiiPhysics", meta = (ClampMin = "0.0", ClampMax = "1.0", UIMin = "0.0", UIMax = "1.0"))
+	float MaxLengthRate = 1.0f;
+
+	/** Collision groups of limits that the bones collide with */
+	UPROPERTY(EditAnywhere, Category = "KawaiiPhysics", meta = (Bitmask))
+	int32 CollisionMask = -1;
+};
+
+/**
+ * Limits that a bone can reach, built by the reachability analysis of the node. Indices of the limits of the node
+ * and of the limits data asset of each type
+ */
+struct FKawaiiPhysicsReachableLimits
+{
+	TArray<int32> Spherical;
+	TArray<int32> SphericalData;
+	TArray<int32> Capsule;
+	TArray<int32> CapsuleData;
+	TArray<int32> Planar;
+	TArray<int32> PlanarData;
+	TArray<int32> SDF;
+};
+
 USTRUCT()
 struct KAWAIIPHYSICS_API FKawaiiPhysicsModifyBone
 {
@@ -197,8 +322,12 @@ public:
 	float LengthFromRoot;
 	UPROPERTY()
 	bool bDummy = false;
+	UPROPERTY()
+	int32 CollisionMask = -1;
 	UPROPERTY(Transient)
 	USkeletalBodySetup* PhysicsBodySetup = nullptr;
+	/** Only these limits are tested for collision with the bone */
+	FKawaiiPhysicsReachableLimits ReachableLimits;
 
 public:
 
@@ -220,11 +349,71 @@ public:
 	}
 };
 
+#if !UE_BUILD_SHIPPING
+/** State of a node for debug drawing. Immutable once published. Locations are in component space */
+struct FKawaiiPhysicsDebugSnapshot
+{
+	struct FBone
+	{
+		FVector Location;
+		FVector PoseLocation;
+		float Radius;
+		float LimitAngle;
+		float LengthRate;
+		int32 ParentIndex;
+		bool bDummy;
+	};
+	TArray<FBone> Bones;
+
+	TArray<FSphericalLimit> SphericalLimits;
+	TArray<FSphericalLimit> SphericalLimitsData;
+	TArray<FCapsuleLimit> CapsuleLimits;
+	TArray<FCapsuleLimit> CapsuleLimitsData;
+	TArray<FPlanarLimit> PlanarLimits;
+	TArray<FPlanarLimit> PlanarLimitsData;
+	TArray<FSDFLimit> SDFLimits;
+};
+
+/**
+ * Double buffer of FKawaiiPhysicsDebugSnapshot. The evaluation writes the back buffer and publishes it, and the game thread
+ * reads the published one. Neither side waits. The writer drops a frame if a reader still holds the back buffer.
+ * Nothing is written unless someone has read in the last few frames
+ */
+class KAWAIIPHYSICS_API FKawaiiPhysicsDebugSnapshotBuffer
+{
+public:
+	FKawaiiPhysicsDebugSnapshotBuffer() = default;
+
+	// Copies of a node start without debug state
+	FKawaiiPhysicsDebugSnapshotBuffer(const FKawaiiPhysicsDebugSnapshotBuffer&) {}
+	FKawaiiPhysicsDebugSnapshotBuffer& operator=(const FKawaiiPhysicsDebugSnapshotBuffer&) { return *this; }
+
+	bool HasConsumers() const;
+
+	/** Back buffer to fill or nullptr if it is still read. Call Publish after filling it */
+	FKawaiiPhysicsDebugSnapshot* BeginWrite();
+	void Publish();
+
+	/** Call Visitor with the latest published snapshot. False if nothing is published yet */
+	bool Read(TFunctionRef<void(const FKawaiiPhysicsDebugSnapshot&)> Visitor) const;
+
+private:
+	FKawaiiPhysicsDebugSnapshot Snapshots[2];
+	FThreadSafeCounter PublishedIndex = FThreadSafeCounter(INDEX_NONE);
+	mutable FThreadSafeCounter NumReaders[2];
+	mutable FThreadSafeCounter64 LastReadFrame;
+	int32 WriteIndex = INDEX_NONE;
+};
+#endif
+
 USTRUCT(BlueprintType)
 struct KAWAIIPHYSICS_API FAnimNode_KawaiiPhysics : public FAnimNode_SkeletalControlBase
 {
 	GENERATED_USTRUCT_BODY()
 
+	friend class FKawaiiPhysicsMicroBenchmark;
+	friend class FKawaiiPhysicsCaptureReplay;
+
 public:
 	UPROPERTY(EditAnywhere, Category = Mode)
 	bool bUseDelayMode = false;
@@ -290,15 +479,58 @@ public:
 	TArray< FCapsuleLimit> CapsuleLimits;
 	UPROPERTY(EditAnywhere, Category = "Planar Limits")
 	TArray< FPlanarLimit> PlanarLimits;
-
+	UPROPERTY(EditAnywhere, Category = "SDF Limits")
+	TArray< FSDFLimit> SDFLimits;
+
+	/** Collision groups of limits that the bones collide with. Bones not matched by BoneCollisionMasks use this */
+	UPROPERTY(EditAnywhere, Category = "Collision Groups", meta = (Bitmask))
+	int32 DefaultCollisionMask = -1;
+
+	/** Override CollisionMask for each bone by bone list or range of bone length rate */
+	UPROPERTY(EditAnywhere, Category = "Collision Groups")
+	TArray<FKawaiiPhysicsBoneCollisionMask> BoneCollisionMasks;
+
+	/**
+	 * Skip limits that can never be reached by each bone. Analyzed at initialization from the bone lengths and angle limits,
+	 * and the bones between Root and the driving bones of the limits in reference pose. Assumes the animation only rotates these bones
+	 */
+	UPROPERTY(EditAnywhere, Category = "Collision Groups")
+	bool bCullUnreachableLimits = true;
+
+	/** Max distance that a bone moves off its chain within a frame by velocity, wind and push outs before the constraints restore it */
+	UPROPERTY(EditAnywhere, Category = "Collision Groups", meta = (EditCondition = "bCullUnreachableLimits", ClampMin = "0"))
+	float ReachabilityMargin = 20.0f;
+
+	/** Collide bones of different sub-chains with each other. e.g. strands of hair, parts of skirt. Bones near in the hierarchy are ignored */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Self Collision", meta = (PinHiddenByDefault))
+	bool bEnableSelfCollision = false;
+
+	/** Max number of bone pairs tested in one frame. Keeps the cost predictable on nodes with many bones */
+	UPROPERTY(EditAnywhere, Category = "Self Collision", meta = (EditCondition = "bEnableSelfCollision", ClampMin = "0"))
+	int32 SelfCollisionMaxPairs = 256;
+
+	/** Bone pairs within this number of hops in the hierarchy are not tested. 1 ignores parents, 2 also ignores siblings and grandparents */
+	UPROPERTY(EditAnywhere, Category = "Self Collision", meta = (EditCondition = "bEnableSelfCollision", ClampMin = "0"))
+	int32 SelfCollisionIgnoreHops = 2;
+
+	/** Scale of significance in the frame budget. Nodes with higher significance keep full rate when the budget runs short */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Budget", meta = (ClampMin = "0", PinHiddenByDefault))
+	float BudgetPriority = 1.0f;
+
+	/**
+	 * Simulate in a task with one frame latency. The result of the previous frame is applied so that the evaluation doesn't wait for the simulation.
+	 * For secondary motion of non hero characters. Ignored in the editor preview
+	 */
+	UPROPERTY(EditAnywhere, Category = "Async", meta = (PinHiddenByDefault))
+	bool bAsyncSimulation = false;
+
+	/** Extrapolate the result of the previous frame by the delta time of this frame to hide the latency of async simulation */
+	UPROPERTY(EditAnywhere, Category = "Async", meta = (EditCondition = "bAsyncSimulation", PinHiddenByDefault))
+	bool bAsyncExtrapolation = true;
+
+	/** Limits shared by the nodes using the data asset. Nodes don't copy them */
 	UPROPERTY(EditAnywhere, Category = "Limits Data(Experimental)")
 	UKawaiiPhysicsLimitsDataAsset* LimitsDataAsset = nullptr;
-	UPROPERTY(VisibleAnywhere, AdvancedDisplay, Category = "Limits Data(Experimental)")
-	TArray< FSphericalLimit> SphericalLimitsData;
-	UPROPERTY(VisibleAnywhere, AdvancedDisplay, Category = "Limits Data(Experimental)")
-	TArray< FCapsuleLimit> CapsuleLimitsData;
-	UPROPERTY(VisibleAnywhere, AdvancedDisplay, Category = "Limits Data(Experimental)")
-	TArray< FPlanarLimit> PlanarLimitsData;
 
 	/** Use physics asset as bone shapes or sphere defined by Radius. */
 	UPROPERTY(EditAnywhere, Category = PhysicsAsset, meta = (PinHiddenByDefault))
@@ -335,6 +567,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Wind, meta = (DisplayAfter = "bEnableWind"), meta = (PinHiddenByDefault))
 	float WindScale = 1.0f;
 
+	/** Seed of the random wind gusts in determinism mode(p.KawaiiPhysics.Deterministic). Combined with the name of RootBone */
+	UPROPERTY(EditAnywhere, Category = Wind, meta = (DisplayAfter = "bEnableWind"))
+	int32 WindRandomSeed = 0;
+
 	UPROPERTY()
 	TArray< FKawaiiPhysicsModifyBone > ModifyBones;
 
@@ -348,24 +584,104 @@ private:
 	FTransform PreSkelCompTransform;
 	UPROPERTY()
 	bool bInitPhysicsSettings = false;
+	UPROPERTY()
+	bool bInitLimitsReachability = false;
 
 #if WITH_EDITORONLY_DATA
 	UPROPERTY()
 	bool bEditing = false;
+
+	// Revisions of editor changes pushed by the editor and the ones applied by the evaluation
+	FThreadSafeCounter EditorPhysicsSettingsRevision;
+	FThreadSafeCounter EditorLimitsRevision;
+	FThreadSafeCounter EditorLimitsDataAssetRevision;
+	int32 AppliedEditorPhysicsSettingsRevision = 0;
+	int32 AppliedEditorLimitsRevision = 0;
+	int32 AppliedEditorLimitsDataAssetRevision = 0;
+
+	// Limits data asset and its revision the limit instances were made for. Never dereferenced
+	const UKawaiiPhysicsLimitsDataAsset* AppliedLimitsDataAsset = nullptr;
+	int32 AppliedLimitsDataAssetRevision = 0;
 #endif
 
+	// Packed state of the limits of the data asset in this node. Spherical, capsule and planar limits in this order
+	TArray<FKawaiiPhysicsLimitInstance> LimitsDataInstances;
+	int32 NumSphericalLimitsData = 0;
+	int32 NumCapsuleLimitsData = 0;
+	int32 NumPlanarLimitsData = 0;
+
+	// Limits of the node and the data asset sorted by driving bone
+	TArray<FKawaiiPhysicsDrivenLimit> DrivenLimits;
+
 	FVector SkelCompMoveVector;
 	FQuat SkelCompMoveRotation;
 	float DeltaTime;
 	float DeltaTimeOld;
 
+	// Random stream of this node for wind gusts. Not shared with gameplay or other nodes
+	FRandomStream WindRandomStream;
+
+	// Inputs owned by the game thread. The evaluation reads only this instead of the component, world and scene
+	FKawaiiPhysicsInputSnapshot InputSnapshot;
+
+	// Simulation of the last frame in async mode. Waited before anything of the node is touched in the next frame
+	FGraphEventRef AsyncSimulationTask;
+	float AsyncSimulationMicroseconds = 0.0f;
+
+	// Frame budget. Time of skipped frames is accumulated and simulated in the next simulated frame
+	EKawaiiPhysicsSimulationTier BudgetTier = EKawaiiPhysicsSimulationTier::Full;
+	float BudgetSignificance = 0.0f;
+	float BudgetAccumulatedDeltaTime = 0.0f;
+	int32 BudgetSkippedFrames = 0;
+	int32 BudgetPhaseSlot = INDEX_NONE;
+	TArray<FVector> SimulatedLocations;
+
+	// p.KawaiiPhysics.EnableOldPhysicsMethodGravity and SphereLimit of this evaluation. Set from the captured settings in a replay
+	bool bOldPhysicsMethodGravity = false;
+	bool bOldPhysicsMethodSphereLimit = false;
+
+	// Counters for stats. Accumulated in SimulateModifyBones and reported at the end of it
+	int32 NumPairsTested = 0;
+	int32 NumPushOuts = 0;
+
+	// Uniform spatial hash for self collision. Rebuilt every frame
+	TMap<FIntVector, int32> SelfCollisionCellHeads;
+	TArray<int32> SelfCollisionNextIndices;
+	TArray<FIntVector> SelfCollisionCells;
+	TArray<FVector> SelfCollisionLocations;
+	// First bone tested in the next frame. Rotates so that SelfCollisionMaxPairs doesn't always cut off the same bones
+	int32 SelfCollisionStartIndex = 0;
+
+#if !UE_BUILD_SHIPPING
+	// Per node cost for KawaiiPhysics.Dump. Sliding window of evaluation time in microseconds
+	static const int32 DebugCostWindowSize = 60;
+	float DebugCostSamples[DebugCostWindowSize] = {};
+	int32 DebugCostNumSamples = 0;
+	int32 DebugCostNextSample = 0;
+
+	TWeakObjectPtr<const USkeletalMeshComponent> DebugSkelMeshComp;
+	TWeakObjectPtr<const UObject> DebugAnimInstance;
+
+	// Capture of the inputs for offline replay. Opened while p.KawaiiPhysics.CaptureDirectory is set
+	TSharedPtr<FKawaiiPhysicsCaptureWriter> CaptureWriter;
+	uint64 CaptureLastFrameCounter = 0;
+
+	// State for debug drawing on the game thread. Published at the end of each evaluation while it is read
+	FKawaiiPhysicsDebugSnapshotBuffer DebugSnapshotBuffer;
+#endif
+
 public:
 	FAnimNode_KawaiiPhysics();
+	~FAnimNode_KawaiiPhysics();
 
 	// FAnimNode_Base interface
 	//virtual void GatherDebugData(FNodeDebugData& DebugData) override;
 	virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
 	virtual void CacheBones_AnyThread(const FAnimationCacheBonesContext& Context) override;
+	virtual bool NeedsOnInitializeAnimInstance() const override { return true; }
+	virtual void OnInitializeAnimInstance(const FAnimInstanceProxy* InProxy, const UAnimInstance* InAnimInstance) override;
+	virtual bool HasPreUpdate() const override { return true; }
+	virtual void PreUpdate(const UAnimInstance* InAnimInstance) override;
 	// End of FAnimNode_Base interface
 
 	// FAnimNode_SkeletalControlBase interface
@@ -381,6 +697,54 @@ public:
 	{
 		return TotalBoneLength;
 	}
+
+	/** Whether p.KawaiiPhysics.Deterministic is set. Identical inputs give bit-identical outputs */
+	static bool IsDeterministic();
+
+#if WITH_EDITOR
+	/**
+	 * Change notifications from the editor. Nodes in editor worlds refresh only the affected state in the next evaluation
+	 * instead of every frame. Safe to call on the game thread while the node is evaluated
+	 */
+	void NotifyPhysicsSettingsChanged();
+	void NotifyLimitsChanged();
+	void NotifyLimitsDataAssetChanged();
+
+	/** Notify the change of a member property of this struct. Everything is refreshed if it is unknown */
+	void NotifyPropertyChanged(const FProperty* MemberProperty);
+
+	/** Notify every live node that uses the curve. Edits of limits data assets are detected by their revision */
+	static void NotifyObjectChanged(const UObject* Object);
+#endif
+
+	/** Limits of LimitsDataAsset used by this node. Shared with other nodes, so never modify them through this */
+	TArrayView<const FSphericalLimit> GetSphericalLimitsData() const;
+	TArrayView<const FCapsuleLimit> GetCapsuleLimitsData() const;
+	TArrayView<const FPlanarLimit> GetPlanarLimitsData() const;
+
+	/** State of a limit of LimitsDataAsset in this node. Null if the index is out of range */
+	const FKawaiiPhysicsLimitInstance* GetLimitsDataInstance(ECollisionLimitType Type, int32 Index) const;
+
+#if !UE_BUILD_SHIPPING
+	void AddDebugCostSample(float Microseconds);
+	void GetDebugCost(float& OutAverageMicroseconds, float& OutPeakMicroseconds) const;
+	void DumpDebugCost(FOutputDevice& Ar) const;
+
+	/** Print the cost of all live nodes. Used by KawaiiPhysics.Dump */
+	static void DumpAllDebugCosts(FOutputDevice& Ar);
+
+	/** Average and peak cost of all live nodes in microseconds. Used by benchmarks */
+	static void GatherDebugCosts(TArray<float>& OutAverageMicroseconds, TArray<float>& OutPeakMicroseconds);
+
+	/**
+	 * Call Visitor with the latest debug snapshot. Safe on the game thread while the node is evaluated on a worker.
+	 * Reading starts the publishing, so the first call after a while returns false
+	 */
+	bool ReadDebugSnapshot(TFunctionRef<void(const FKawaiiPhysicsDebugSnapshot&)> Visitor) const
+	{
+		return DebugSnapshotBuffer.Read(Visitor);
+	}
+#endif
 	
 
 private:
@@ -407,27 +771,74 @@ private:
 	// End of FAnimNode_SkeletalControlBase interface
 
 	void ApplyLimitsDataAsset(const FBoneContainer& RequiredBones);
+	void InitializeLimitsDataBoneReferences(const FBoneContainer& RequiredBones);
+	TArrayView<const int32> FindCookedLimitsDataBoneIndices(ECollisionLimitType Type, const FBoneContainer& RequiredBones) const;
+	TArrayView<const FKawaiiPhysicsCookedLimit> GetCookedLimitsData(ECollisionLimitType Type) const;
+	const FKawaiiPhysicsLimitInstance* GetLimitsDataInstances(ECollisionLimitType Type) const;
+	FKawaiiPhysicsLimitInstance* GetLimitsDataInstances(ECollisionLimitType Type)
+	{
+		return const_cast<FKawaiiPhysicsLimitInstance*>(AsConst(*this).GetLimitsDataInstances(Type));
+	}
+#if WITH_EDITOR
+	bool ApplyLimitsDataAssetLimit(ECollisionLimitType Type, int32 Index, const FBoneContainer& BoneContainer);
+	void ApplyEditorChanges(const FBoneContainer& BoneContainer);
+#endif
 
 	int AddModifyBone(FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer, const FReferenceSkeleton& RefSkeleton, int BoneIndex);
 	
 	// clone from FReferenceSkeleton::GetDirectChildBones
 	int32 CollectChildBones(const FReferenceSkeleton& RefSkeleton, int32 ParentBoneIndex, TArray<int32> & Children) const;
 	void CalcBoneLength(FKawaiiPhysicsModifyBone& Bone, const TArray<FTransform>& RefBonePose);
+	void InitModifyBonesCollisionMask();
+	void SetCollisionMaskOfSubChain(FKawaiiPhysicsModifyBone& Bone, int32 CollisionMask);
 
 	void UpdatePhysicsSettingsOfModifyBones();
-	void UpdateSphericalLimits(TArray<FSphericalLimit>& Limits, FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer, FTransform& ComponentTransform);
-	void UpdateCapsuleLimits(TArray<FCapsuleLimit>& Limits, FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer, FTransform& ComponentTransform);
-	void UpdatePlanerLimits(TArray<FPlanarLimit>& Limits, FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer, FTransform& ComponentTransform);
-
-	void SimulateModifyBones(FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer, FTransform& ComponentTransform);
-	void AdjustBySphereCollision(const USkeletalMeshComponent* SkelMeshComp, FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone, TArray<FSphericalLimit>& Limits);
-	void AdjustByCapsuleCollision(const USkeletalMeshComponent* SkelMeshComp, FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone, TArray<FCapsuleLimit>& Limits);
-	void AdjustByPlanerCollision(const USkeletalMeshComponent* SkelMeshComp, FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone, TArray<FPlanarLimit>& Limits);
-	void AdjustByPhysicsAssetCollision(const USkeletalMeshComponent* SkelMeshComp, FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone);
-	void AdjustByAngleLimit(FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer, FTransform& ComponentTransform, FKawaiiPhysicsModifyBone& Bone, FKawaiiPhysicsModifyBone& ParentBone);
+	void UpdateLimitsReachability(const FBoneContainer& BoneContainer);
+	int32 GetNumDrivenLimits() const;
+	void InitializeDrivenLimits(const FBoneContainer& BoneContainer);
+	void UpdateLimitTransforms(FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer);
+
+	/** Copy the inputs owned by the game thread. Called in OnInitializeAnimInstance and PreUpdate */
+	void UpdateInputSnapshot(const USkeletalMeshComponent* SkelMeshComp);
+	float GetSnapshotBoneScale(int32 BoneIndex) const
+	{
+		return InputSnapshot.BoneScales.IsValidIndex(BoneIndex) ? InputSnapshot.BoneScales[BoneIndex] : 1.0f;
+	}
+
+	float CalcBudgetSignificance(const USkeletalMeshComponent* SkelMeshComp) const;
+	bool ShouldSimulateInBudget();
+	void FollowPoseWithoutSimulation();
+
+	/** Movement of the component since the last simulated frame. Dropped if it is over the teleport thresholds */
+	void UpdateSkelCompMove(const FTransform& ComponentTransform);
+	void SimulateModifyBones(const FTransform& ComponentTransform);
+	bool ShouldSimulateAsync() const;
+	void LaunchAsyncSimulation(const FTransform& ComponentTransform);
+	void WaitForAsyncSimulation();
+	// Only the limits of LimitIndices are tested. Transforms are read from Instances if given. Otherwise from the limits themselves
+	void AdjustBySphereCollision(FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone, TArrayView<const FSphericalLimit> Limits,
+		TArrayView<const int32> LimitIndices, const FKawaiiPhysicsLimitInstance* Instances = nullptr);
+	void AdjustByCapsuleCollision(FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone, TArrayView<const FCapsuleLimit> Limits,
+		TArrayView<const int32> LimitIndices, const FKawaiiPhysicsLimitInstance* Instances = nullptr);
+	void AdjustByPlanerCollision(FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone, TArrayView<const FPlanarLimit> Limits,
+		TArrayView<const int32> LimitIndices, const FKawaiiPhysicsLimitInstance* Instances = nullptr);
+	void AdjustBySDFCollision(FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone, TArray<FSDFLimit>& Limits, TArrayView<const int32> LimitIndices);
+	void AdjustByPhysicsAssetCollision(FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone);
+	void AdjustByAngleLimit(FKawaiiPhysicsModifyBone& Bone, FKawaiiPhysicsModifyBone& ParentBone);
 	void AdjustByPlanarConstraint(FKawaiiPhysicsModifyBone& Bone, FKawaiiPhysicsModifyBone& ParentBone);
+	// Collision limits and constraints applied after the integration. Also re-applied after self collision
+	void AdjustByCollisionLimits(FKawaiiPhysicsModifyBone& ParentBone, FKawaiiPhysicsModifyBone& Bone);
+	void AdjustByConstraints(FKawaiiPhysicsModifyBone& Bone, FKawaiiPhysicsModifyBone& ParentBone);
+	void AdjustBySelfCollision();
+	bool IsWithinSelfCollisionIgnoreHops(int32 BoneIndexA, int32 BoneIndexB) const;
 	
 
 	void ApplySimuateResult(FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer, TArray<FBoneTransform>& OutBoneTransforms);
+	void ApplyExtrapolatedResult(FComponentSpacePoseContext& Output, const FBoneContainer& BoneContainer, TArray<FBoneTransform>& OutBoneTransforms, float ExtrapolationTime);
+
+#if !UE_BUILD_SHIPPING
+	void CaptureInput(const FTransform& ComponentTransform);
+	void PublishDebugSnapshot();
+#endif
 	
 };
\ No newline at end of file
@@ -4,6 +4,9 @@
 
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("KawaiiPhysics"), STATGROUP_KawaiiPhysics, STATCAT_Advanced);
 
 class FKawaiiPhysicsModule : public IModuleInterface
 {
@@ -0,0 +1,32 @@
+// Copyright (c) 2019-2020 pafuhana1213. Licensed under the MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UPhysicsAsset;
+class USkeletalMesh;
+class USkeletalMeshComponent;
+
+/** Mesh bone index of each body of a physics asset. Bone names are looked up only when the asset, the mesh or the number of bodies changes */
+class KAWAIIPHYSICS_API FKawaiiPhysicsBodyBoneIndexCache
+{
+public:
+	/** Re-resolve the bone indices if they are out of date. Returns true if they were */
+	bool Update(const UPhysicsAsset* PhysicsAsset, const USkeletalMeshComponent* SkeletalMeshComp);
+
+	const TArray<int32>& Get(const UPhysicsAsset* PhysicsAsset, const USkeletalMeshComponent* SkeletalMeshComp)
+	{
+		Update(PhysicsAsset, SkeletalMeshComp);
+		return BoneIndices;
+	}
+
+	const TArray<int32>& GetBoneIndices() const { return BoneIndices; }
+
+	void Reset();
+
+private:
+	TWeakObjectPtr<const UPhysicsAsset> CachedPhysicsAsset;
+	TWeakObjectPtr<const USkeletalMesh> CachedSkeletalMesh;
+	TArray<int32> BoneIndices;
+};
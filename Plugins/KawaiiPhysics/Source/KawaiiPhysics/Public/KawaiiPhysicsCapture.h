@@ -0,0 +1,261 @@
+// Copyright (c) 2019-2020 pafuhana1213. Licensed under the MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/UniquePtr.h"
+#include "UObject/GCObject.h"
+
+struct FAnimNode_KawaiiPhysics;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Capture of node inputs for offline replay.
+ * A capture file is a header followed by settings and frame records. Settings records are written when the settings change
+ * and apply to the following frames. Everything is in component space except ComponentTransform
+ */
+
+struct KAWAIIPHYSICS_API FKawaiiPhysicsCaptureBone
+{
+	int32 ParentIndex = INDEX_NONE;
+	int32 CollisionMask = -1;
+	/** Mesh bone index. Bones not in the required bones are INDEX_NONE and not simulated unless they are dummy */
+	int32 BoneIndex = INDEX_NONE;
+	bool bDummy = false;
+	float Damping = 0.0f;
+	float WorldDampingLocation = 0.0f;
+	float WorldDampingRotation = 0.0f;
+	float Stiffness = 0.0f;
+	float DelayAlpha = 0.0f;
+	float Radius = 0.0f;
+	float LimitAngle = 0.0f;
+	float LengthFromRoot = 0.0f;
+	/** Body of PhysicsAssetAsShapes of the settings. INDEX_NONE if the bone has no body */
+	int32 PhysicsBodyIndex = INDEX_NONE;
+	/** Limits of the frames that the bone can't reach by the reachability analysis of the node. The others are tested */
+	TArray<int32> CulledSpheres;
+	TArray<int32> CulledCapsules;
+	TArray<int32> CulledPlanes;
+	TArray<int32> CulledSDFs;
+
+	friend FArchive& operator<<(FArchive& Ar, FKawaiiPhysicsCaptureBone& Bone);
+};
+
+struct KAWAIIPHYSICS_API FKawaiiPhysicsCaptureSettings
+{
+	int32 TargetFramerate = 60;
+	FVector Gravity = FVector::ZeroVector;
+	float TeleportDistanceThreshold = 0.0f;
+	float TeleportRotationThreshold = 0.0f;
+	bool bOldPhysicsMethodGravity = false;
+	bool bOldPhysicsMethodSphereLimit = false;
+	bool bUseDelayMode = false;
+	uint8 BoneForwardAxis = 0;
+	uint8 PlanarConstraint = 0;
+	bool bEnableWind = false;
+	float WindScale = 1.0f;
+	bool bEnableSelfCollision = false;
+	int32 SelfCollisionMaxPairs = 0;
+	int32 SelfCollisionIgnoreHops = 0;
+	/** Assets are referenced by path and loaded by the replay */
+	bool bUsePhysicsAssetAsShapes = false;
+	FString PhysicsAssetAsShapes;
+	bool bUsePhysicsAssetAsLimits = false;
+	FString PhysicsAssetAsLimits;
+	/** Data asset of each SDF limit. Empty if the limit has none */
+	TArray<FString> SDFDataAssets;
+	TArray<FKawaiiPhysicsCaptureBone> Bones;
+
+	friend FArchive& operator<<(FArchive& Ar, FKawaiiPhysicsCaptureSettings& Settings);
+};
+
+struct KAWAIIPHYSICS_API FKawaiiPhysicsCaptureSphere
+{
+	FVector Location = FVector::ZeroVector;
+	float Radius = 0.0f;
+	int32 CollisionGroup = 1;
+	bool bInner = false;
+
+	friend FArchive& operator<<(FArchive& Ar, FKawaiiPhysicsCaptureSphere& Sphere);
+};
+
+struct KAWAIIPHYSICS_API FKawaiiPhysicsCaptureCapsule
+{
+	FVector Location = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	float Radius = 0.0f;
+	float Length = 0.0f;
+	int32 CollisionGroup = 1;
+
+	friend FArchive& operator<<(FArchive& Ar, FKawaiiPhysicsCaptureCapsule& Capsule);
+};
+
+struct KAWAIIPHYSICS_API FKawaiiPhysicsCapturePlane
+{
+	FVector Location = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	int32 CollisionGroup = 1;
+
+	friend FArchive& operator<<(FArchive& Ar, FKawaiiPhysicsCapturePlane& Plane);
+};
+
+struct KAWAIIPHYSICS_API FKawaiiPhysicsCaptureSDF
+{
+	FVector Location = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	int32 CollisionGroup = 1;
+
+	friend FArchive& operator<<(FArchive& Ar, FKawaiiPhysicsCaptureSDF& SDF);
+};
+
+/** Simulation state the replay starts from. Empty when the frame continues from the last one */
+struct KAWAIIPHYSICS_API FKawaiiPhysicsCaptureState
+{
+	FTransform PreComponentTransform;
+	float DeltaTimeOld = 0.0f;
+	int32 SelfCollisionStartIndex = 0;
+	TArray<FVector> Locations;
+	TArray<FVector> PrevLocations;
+
+	bool IsEmpty() const
+	{
+		return Locations.Num() == 0;
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, FKawaiiPhysicsCaptureState& State);
+};
+
+/** Inputs of one simulated frame of a node */
+struct KAWAIIPHYSICS_API FKawaiiPhysicsCaptureFrame
+{
+	float DeltaTime = 0.0f;
+	FTransform ComponentTransform;
+	/** Seed of the wind gusts at the start of the frame */
+	int32 WindSeed = 0;
+	TArray<FVector> PoseLocations;
+	TArray<FQuat> PoseRotations;
+	TArray<FKawaiiPhysicsCaptureSphere> Spheres;
+	TArray<FKawaiiPhysicsCaptureCapsule> Capsules;
+	TArray<FKawaiiPhysicsCapturePlane> Planes;
+	TArray<FKawaiiPhysicsCaptureSDF> SDFs;
+	/** Input snapshot of the game thread. See FKawaiiPhysicsInputSnapshot */
+	TArray<FVector> WindVelocities;
+	TArray<float> BoneScales;
+	TArray<int32> LimitBodyBoneIndices;
+	TArray<FTransform> LimitBodyTransforms;
+	FKawaiiPhysicsCaptureState State;
+
+	friend FArchive& operator<<(FArchive& Ar, FKawaiiPhysicsCaptureFrame& Frame);
+};
+
+/** Streams records to a capture file. The file writer is buffered so that long captures cost little */
+class KAWAIIPHYSICS_API FKawaiiPhysicsCaptureWriter
+{
+public:
+	bool Open(const TCHAR* Filename);
+	void Close();
+	bool IsOpen() const
+	{
+		return Archive.IsValid();
+	}
+
+	/** Write the settings if they are different from the last written ones. Return true if written */
+	bool WriteSettings(FKawaiiPhysicsCaptureSettings& Settings);
+	void WriteFrame(FKawaiiPhysicsCaptureFrame& Frame);
+
+private:
+	TUniquePtr<FArchive> Archive;
+	TArray<uint8> LastSettingsBytes;
+};
+
+/** Reads records from a capture file. The file is memory mapped if the platform supports it, otherwise streamed */
+class KAWAIIPHYSICS_API FKawaiiPhysicsCaptureReader
+{
+public:
+	FKawaiiPhysicsCaptureReader();
+	~FKawaiiPhysicsCaptureReader();
+
+	bool Open(const TCHAR* Filename);
+
+	/** Read the next frame. Settings records before it update GetSettings(). Return false at the end of the file */
+	bool ReadFrame(FKawaiiPhysicsCaptureFrame& OutFrame);
+
+	const FKawaiiPhysicsCaptureSettings& GetSettings() const
+	{
+		return Settings;
+	}
+
+private:
+	// Destroyed in reverse order. The archive reads the region, which is a view of the file handle
+	TUniquePtr<IMappedFileHandle> MappedFileHandle;
+	TUniquePtr<IMappedFileRegion> MappedFileRegion;
+	TUniquePtr<FArchive> Archive;
+	FKawaiiPhysicsCaptureSettings Settings;
+};
+
+/**
+ * Replays a capture through the simulation of FAnimNode_KawaiiPhysics without a world or a skeletal mesh.
+ * The captured settings, pose, limits and input snapshot are set to a node owned by the replay, and each frame is
+ * simulated by the same functions as the evaluation of the node. Deterministic for the same capture
+ */
+class KAWAIIPHYSICS_API FKawaiiPhysicsCaptureReplay : public FGCObject
+{
+public:
+	FKawaiiPhysicsCaptureReplay();
+	virtual ~FKawaiiPhysicsCaptureReplay();
+
+	void Step(const FKawaiiPhysicsCaptureSettings& Settings, const FKawaiiPhysicsCaptureFrame& Frame);
+
+	/** Simulated locations in component space */
+	const TArray<FVector>& GetLocations() const
+	{
+		return Locations;
+	}
+
+	// FGCObject interface
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	// End of FGCObject interface
+
+private:
+	void ApplySettings(const FKawaiiPhysicsCaptureSettings& Settings);
+	void ApplyState(const FKawaiiPhysicsCaptureState& State);
+	void ApplyFrame(const FKawaiiPhysicsCaptureFrame& Frame);
+	void ApplyReachableLimits(const FKawaiiPhysicsCaptureSettings& Settings);
+
+	TUniquePtr<FAnimNode_KawaiiPhysics> Node;
+	TArray<FVector> Locations;
+	/** Set when the settings or the number of limits change */
+	bool bReachableLimitsDirty = true;
+};
+
+/**
+ * Simulated bone locations of every frame of a replay. Saved as CSV lines of "Frame,Bone,X,Y,Z" by -Output of the
+ * KawaiiPhysicsReplay commandlet and by the golden test, and compared with such a file as the golden result
+ */
+class KAWAIIPHYSICS_API FKawaiiPhysicsReplayResult
+{
+public:
+	/** Append the locations of all bones of the next frame */
+	void AddFrame(const TArray<FVector>& BoneLocations);
+
+	bool SaveToFile(const TCHAR* Filename) const;
+	bool LoadFromFile(const TCHAR* Filename);
+
+	/**
+	 * Max distance between the locations of this and the golden result, and the frame and the bone of it.
+	 * Return false if the results don't have the same frames and bones
+	 */
+	bool Compare(const FKawaiiPhysicsReplayResult& Golden, float& OutMaxDeviation, FIntPoint& OutMaxDeviationFrameBone) const;
+
+	int32 Num() const
+	{
+		return Locations.Num();
+	}
+
+private:
+	TArray<FVector> Locations;
+	/** Frame and bone index of each location */
+	TArray<FIntPoint> FrameBones;
+	int32 NumFrames = 0;
+};
@@ -7,6 +7,8 @@
 #include "AnimNode_KawaiiPhysics.h"
 #include "KawaiiPhysicsLimitsDataAsset.generated.h"
 
+class USkeleton;
+
 // I chose this design because using FBoneReference with anything other than Persona gives me an error. 
 // I want to make it simpler...
 USTRUCT(BlueprintType)
@@ -23,6 +25,9 @@ struct FCollisionLimitDataBase
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = CollisionLimitBase, meta = (ClampMin = "-360", ClampMax = "360"))
 	FRotator OffsetRotation = FRotator::ZeroRotator;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = CollisionLimitBase, meta = (Bitmask))
+	int32 CollisionGroup = 1;
+
 	UPROPERTY(EditAnywhere, Category = CollisionLimitBase, BlueprintReadWrite)
 	FVector Location = FVector::ZeroVector;
 
@@ -41,6 +46,7 @@ protected:
 		DrivingBoneName = Limit->DrivingBone.BoneName;
 		OffsetLocation = Limit->OffsetLocation;
 		OffsetRotation = Limit->OffsetRotation;
+		CollisionGroup = Limit->CollisionGroup;
 		Location = Limit->Location;
 		Rotation = Limit->Rotation;
 	}
@@ -50,6 +56,7 @@ protected:
 		Limit.DrivingBone.BoneName = DrivingBoneName;
 		Limit.OffsetLocation = OffsetLocation;
 		Limit.OffsetRotation = OffsetRotation;
+		Limit.CollisionGroup = CollisionGroup;
 		Limit.Location = Location;
 		Limit.Rotation = Rotation;
 
@@ -145,6 +152,34 @@ struct FPlanarLimitData : public FCollisionLimitDataBase
 };
 //#endif
 
+/** Offset of a limit baked on save. Nodes read the quaternion in place instead of converting the authored rotator */
+USTRUCT()
+struct FKawaiiPhysicsCookedLimit
+{
+	GENERATED_BODY();
+
+	UPROPERTY()
+	FQuat OffsetRotation = FQuat::Identity;
+
+	UPROPERTY()
+	FVector OffsetLocation = FVector::ZeroVector;
+};
+
+/** Driving bones of the cooked limits resolved against a skeleton */
+USTRUCT()
+struct FKawaiiPhysicsCookedLimitBones
+{
+	GENERATED_BODY();
+
+	/** Guid of the skeleton. Regenerated when the bone hierarchy of the skeleton changes */
+	UPROPERTY()
+	FGuid SkeletonGuid;
+
+	/** Skeleton bone index of each cooked limit. INDEX_NONE if the bone isn't in the skeleton */
+	UPROPERTY()
+	TArray<int32> SkeletonBoneIndices;
+};
+
 /**
  * 
  */
@@ -164,6 +199,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Planar Limits")
 	TArray< FPlanarLimitData> PlanarLimitsData;
 
+	/** Skeletons to resolve the driving bones against on save. Nodes of other skeletons resolve them by name */
+	UPROPERTY(EditAnywhere, Category = "Bake")
+	TArray<USkeleton*> TargetSkeletons;
+
 #endif
 
 #if WITH_EDITOR
@@ -173,6 +212,15 @@ public:
 	//void UpdateLimit(FPlanarLimit* Limit);
 	void UpdateLimit(FCollisionLimitBase* Limit);
 
+	/** Incremented on every edit. Nodes compare it to skip re-copying the limits */
+	int32 GetRevision() const
+	{
+		return Revision;
+	}
+
+	/** Whether the edit of the revision updated a single limit in place, and which one */
+	bool GetUpdatedLimit(int32 InRevision, ECollisionLimitType& OutType, int32& OutIndex) const;
+
 #endif
 
 	UPROPERTY()
@@ -182,10 +230,51 @@ public:
 	UPROPERTY()
 	TArray< FPlanarLimit> PlanarLimits;
 
+	/** SphericalLimits, CapsuleLimits and PlanarLimits baked in this order */
+	UPROPERTY()
+	TArray<FKawaiiPhysicsCookedLimit> CookedLimits;
+
+	/** Driving bones of CookedLimits for each of TargetSkeletons */
+	UPROPERTY()
+	TArray<FKawaiiPhysicsCookedLimitBones> CookedLimitBones;
+
+	/** Cooked limits of the type. Empty if they are out of date */
+	TArrayView<const FKawaiiPhysicsCookedLimit> GetCookedLimits(ECollisionLimitType Type) const;
+
+	/** Skeleton bone indices of the driving bones of the cooked limits of the type. Empty if the skeleton wasn't baked */
+	TArrayView<const int32> FindCookedBoneIndices(const USkeleton* Skeleton, ECollisionLimitType Type) const;
+
+	virtual void PostLoad() override;
+
 #if WITH_EDITOR
+	virtual void PreSave(const class ITargetPlatform* TargetPlatform) override;
 	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
 #endif
 
+private:
+	/** Range of the limits of the type in CookedLimits. False if the cooked limits are out of date */
+	bool GetCookedLimitsRange(ECollisionLimitType Type, int32& OutOffset, int32& OutNum) const;
+	void CookLimits();
+
+#if WITH_EDITOR
+	void CookLimit(ECollisionLimitType Type, int32 Index);
+	int32 FindLimitIndex(ECollisionLimitType Type, const FGuid& Guid);
+	void OnLimitUpdated(ECollisionLimitType Type, int32 Index);
+	void OnLimitsRebuilt();
+#endif
+
+#if WITH_EDITORONLY_DATA
+	// Index of each limit by Guid. Rebuilt when a lookup finds it stale
+	TMap<FGuid, int32> SphericalLimitIndices;
+	TMap<FGuid, int32> CapsuleLimitIndices;
+	TMap<FGuid, int32> PlanarLimitIndices;
+
+	int32 Revision = 0;
+	int32 UpdatedLimitRevision = INDEX_NONE;
+	ECollisionLimitType UpdatedLimitType = ECollisionLimitType::None;
+	int32 UpdatedLimitIndex = INDEX_NONE;
+#endif
+
 /*
 #if WITH_EDITORONLY_DATA 
 	UPROPERTY(EditAnywhere)
@@ -0,0 +1,20 @@
+// Copyright (c) 2019-2020 pafuhana1213. Licensed under the MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Micro benchmarks of each collision primitive and solver phase on a synthetic chain.
+ * The layout is generated from a fixed seed and the minimum of several runs is reported so that results are comparable between builds.
+ * KawaiiPhysics.MicroBenchmark [Bones=32] [Colliders=1,4,16,64] [Iterations=100] [Runs=5] [Baseline=<csv>] [Threshold=10] [SaveBaseline]
+ * SaveBaseline stores the results to Baseline, by default Saved/KawaiiPhysics/MicroBenchmarkBaseline.csv. Otherwise the results are
+ * compared with it, and entries slower than the baseline by more than Threshold percent are reported as regressions.
+ * Cycles differ between machines, so store the baseline on the machine that gates the changes
+ */
+class KAWAIIPHYSICS_API FKawaiiPhysicsMicroBenchmark
+{
+public:
+	/** Return false if an entry regressed from the baseline or the baseline could not be saved */
+	static bool Run(FOutputDevice& Ar, const TArray<FString>& Args);
+};
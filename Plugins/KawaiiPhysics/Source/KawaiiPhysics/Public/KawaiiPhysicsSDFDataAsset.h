@@ -0,0 +1,87 @@
+// Copyright (c) 2019-2020 pafuhana1213. Licensed under the MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "KawaiiPhysicsSDFDataAsset.generated.h"
+
+class UStaticMesh;
+class UPhysicsAsset;
+
+/**
+ * Signed distance field baked from the surface of a static mesh or the bodies of a physics asset.
+ * Used by FSDFLimit to replace a lot of sphere and capsule limits with one lookup.
+ */
+UCLASS(Blueprintable)
+class KAWAIIPHYSICS_API UKawaiiPhysicsSDFDataAsset : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+#if WITH_EDITORONLY_DATA
+
+	/** Bake the surface of LOD0 of this static mesh. The mesh should be closed, inside is decided by the number of faces a ray crosses */
+	UPROPERTY(EditAnywhere, Category = "Bake")
+	UStaticMesh* SourceStaticMesh = nullptr;
+
+	/** Bake the bodies of this physics asset. Positioned by the reference pose of the preview mesh */
+	UPROPERTY(EditAnywhere, Category = "Bake")
+	UPhysicsAsset* SourcePhysicsAsset = nullptr;
+
+	/** Bodies of SourcePhysicsAsset to bake. If empty bake all bodies */
+	UPROPERTY(EditAnywhere, Category = "Bake")
+	TArray<FName> SourceBodyNames;
+
+	/** Bone that the bodies of SourcePhysicsAsset are baked relative to. Must be same as DrivingBone of the limit, which is checked on compiling the AnimBP */
+	UPROPERTY(EditAnywhere, Category = "Bake")
+	FName SourceBoneName;
+
+	/** Number of cells on the longest axis of the bounds */
+	UPROPERTY(EditAnywhere, Category = "Bake", meta = (ClampMin = "2", ClampMax = "64"))
+	int32 Resolution = 16;
+
+	/** Expand the bounds of the field. Should be larger than radius of the bones */
+	UPROPERTY(EditAnywhere, Category = "Bake", meta = (ClampMin = "0"))
+	float Padding = 5.0f;
+
+#endif
+
+	UPROPERTY(VisibleAnywhere, Category = "SDF")
+	FVector BoundsMin = FVector::ZeroVector;
+
+	UPROPERTY(VisibleAnywhere, Category = "SDF")
+	float CellSize = 1.0f;
+
+	UPROPERTY(VisibleAnywhere, Category = "SDF")
+	FIntVector Dimensions = FIntVector::ZeroValue;
+
+	UPROPERTY()
+	TArray<float> Distances;
+
+public:
+
+	bool IsValidField() const
+	{
+		return Dimensions.X >= 2 && Dimensions.Y >= 2 && Dimensions.Z >= 2 && Distances.Num() == Dimensions.X * Dimensions.Y * Dimensions.Z;
+	}
+
+	FBox GetBounds() const
+	{
+		return FBox(BoundsMin, BoundsMin + FVector(Dimensions.X - 1, Dimensions.Y - 1, Dimensions.Z - 1) * CellSize);
+	}
+
+	/** Sample distance and gradient with trilinear interpolation. Return MAX_flt outside of the bounds. The gradient is never zero inside of the bounds */
+	float SampleDistance(const FVector& LocalLocation, FVector& OutGradient) const;
+
+#if WITH_EDITOR
+
+	UFUNCTION(CallInEditor, Category = "Bake")
+	void Bake();
+
+	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
+
+#endif
+
+};
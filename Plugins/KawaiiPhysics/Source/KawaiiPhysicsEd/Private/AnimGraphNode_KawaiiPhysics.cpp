@@ -1,6 +1,9 @@
 #include "AnimGraphNode_KawaiiPhysics.h"
 #include "Kismet2/CompilerResultsLog.h"
 #include "Materials/MaterialInstanceDynamic.h"
+#include "KawaiiPhysicsDebugDrawView.h"
+#include "Animation/AnimBlueprint.h"
+#include "KawaiiPhysicsSDFDataAsset.h"
 
 #define LOCTEXT_NAMESPACE "KawaiiPhysics"
 
@@ -52,6 +55,30 @@ void UAnimGraphNode_KawaiiPhysics::PostEditChangeProperty(struct FPropertyChange
 	ReconstructNode();
 }
 
+void UAnimGraphNode_KawaiiPhysics::PostEditChangeChainProperty(struct FPropertyChangedChainEvent& PropertyChangedEvent)
+{
+	// Tell the previewed instance which member of the node changed so that it refreshes only that
+	const FProperty* MemberProperty = nullptr;
+	for (auto* ChainNode = PropertyChangedEvent.PropertyChain.GetHead(); ChainNode; ChainNode = ChainNode->GetNextNode())
+	{
+		if (ChainNode->GetValue()->GetOwnerStruct() == FAnimNode_KawaiiPhysics::StaticStruct())
+		{
+			MemberProperty = ChainNode->GetValue();
+			break;
+		}
+	}
+
+	UAnimBlueprint* AnimBlueprint = GetAnimBlueprint();
+	FAnimNode_KawaiiPhysics* PreviewNode = AnimBlueprint ?
+		GetActiveInstanceNode<FAnimNode_KawaiiPhysics>(AnimBlueprint->GetObjectBeingDebugged()) : nullptr;
+	if (PreviewNode)
+	{
+		PreviewNode->NotifyPropertyChanged(MemberProperty);
+	}
+
+	Super::PostEditChangeChainProperty(PropertyChangedEvent);
+}
+
 FEditorModeID UAnimGraphNode_KawaiiPhysics::GetEditorMode() const
 {
 	return "AnimGraph.SkeletalControl.KawaiiPhysics";
@@ -70,43 +97,61 @@ void UAnimGraphNode_KawaiiPhysics::Draw(FPrimitiveDrawInterface* PDI, USkeletalM
 		return;
 	}
 
-	if (bEnableDebugDrawBone)
+	// Read the published state instead of ModifyBones which a worker thread may be writing
+	const FKawaiiPhysicsDebugDrawView DrawView(PDI->View, SkelMeshComp->GetComponentTransform());
+	ActiveNode->ReadDebugSnapshot([this, PDI, &DrawView](const FKawaiiPhysicsDebugSnapshot& Snapshot)
 	{
-		for (auto& Bone : ActiveNode->ModifyBones)
+		if (bEnableDebugDrawBone)
 		{
-			PDI->DrawPoint(Bone.Location, FLinearColor::White, 5.0f, SDPG_Foreground);
-
-			if (Bone.PhysicsSettings.Radius > 0 && !Node.bUsePhysicsAssetAsShapes)
+			for (auto& Bone : Snapshot.Bones)
 			{
-				auto Color = Bone.bDummy ? FColor::Red : FColor::Yellow;
-				DrawWireSphere(PDI, Bone.Location, Color, Bone.PhysicsSettings.Radius, 16, SDPG_Foreground);
-			}
-
-			for (int ChildIndex : Bone.ChildIndexs)
-			{
-				DrawDashedLine(PDI, Bone.Location, ActiveNode->ModifyBones[ChildIndex].Location,
-					FLinearColor::White, 1, SDPG_Foreground);
+				const float Radius = Node.bUsePhysicsAssetAsShapes ? 0.0f : Bone.Radius;
+				if (DrawView.IsVisible(Bone.Location, Radius))
+				{
+					PDI->DrawPoint(Bone.Location, FLinearColor::White, 5.0f, SDPG_Foreground);
+
+					if (Radius > 0)
+					{
+						auto Color = Bone.bDummy ? FColor::Red : FColor::Yellow;
+						DrawWireSphere(PDI, Bone.Location, Color, Radius, DrawView.GetNumSides(Bone.Location, Radius, 16), SDPG_Foreground);
+					}
+				}
+
+				if (Bone.ParentIndex >= 0)
+				{
+					const FVector& ParentLocation = Snapshot.Bones[Bone.ParentIndex].Location;
+					if (DrawView.IsVisible((ParentLocation + Bone.Location) * 0.5f, (Bone.Location - ParentLocation).Size() * 0.5f))
+					{
+						DrawDashedLine(PDI, ParentLocation, Bone.Location, FLinearColor::White, 1, SDPG_Foreground);
+					}
+				}
 			}
 		}
-	}
 
-	if (bEnableDebugDrawAngleLimit)
-	{
-		for (auto& Bone : ActiveNode->ModifyBones)
+		if (bEnableDebugDrawAngleLimit)
 		{
-			if (Bone.ParentIndex < 0 || Bone.PhysicsSettings.LimitAngle <= 0)
+			for (auto& Bone : Snapshot.Bones)
 			{
-				continue;
+				if (Bone.ParentIndex < 0 || Bone.LimitAngle <= 0)
+				{
+					continue;
+				}
+
+				auto& ParentBone = Snapshot.Bones[Bone.ParentIndex];
+				const float ConeLength = (Bone.PoseLocation - ParentBone.PoseLocation).Size();
+				if (!DrawView.IsVisible(ParentBone.Location, ConeLength))
+				{
+					continue;
+				}
+
+				FTransform ParentBoneTransform =
+					FTransform(FQuat::FindBetween(FVector::ForwardVector, Bone.PoseLocation - ParentBone.PoseLocation), ParentBone.Location);
+				TArray<FVector> Verts;
+				DrawWireCone(PDI, Verts, ParentBoneTransform, ConeLength,
+					Bone.LimitAngle, DrawView.GetNumSides(ParentBone.Location, ConeLength, 16), FColor::Green, SDPG_World);
 			}
-
-			auto& ParentBone = ActiveNode->ModifyBones[Bone.ParentIndex];
-			FTransform ParentBoneTransform =
-				FTransform(FQuat::FindBetween(FVector::ForwardVector, Bone.PoseLocation - ParentBone.PoseLocation), ParentBone.Location);
-			TArray<FVector> Verts;
-			DrawWireCone(PDI, Verts, ParentBoneTransform, (Bone.PoseLocation - ParentBone.PoseLocation).Size(),
-				Bone.PhysicsSettings.LimitAngle, 16, FColor::Green, SDPG_World);
 		}
-	}
+	});
 }
 
 void UAnimGraphNode_KawaiiPhysics::ValidateAnimNodePostCompile(FCompilerResultsLog& MessageLog, UAnimBlueprintGeneratedClass* CompiledClass, int32 CompiledNodeIndex)
@@ -125,6 +170,16 @@ void UAnimGraphNode_KawaiiPhysics::ValidateAnimNodePostCompile(FCompilerResultsL
 	{
 		MessageLog.Warning(TEXT("@@ RootBone is empty."), this);
 	}
+
+	// Bodies of a physics asset are baked relative to SourceBoneName, so the limit must follow the same bone
+	for (const FSDFLimit& SDF : Node.SDFLimits)
+	{
+		if (SDF.SDFDataAsset && SDF.SDFDataAsset->SourcePhysicsAsset && SDF.SDFDataAsset->SourceBoneName != SDF.DrivingBone.BoneName)
+		{
+			MessageLog.Warning(*FString::Printf(TEXT("@@ DrivingBone(%s) of SDFLimit is different from SourceBoneName(%s) of %s."),
+				*SDF.DrivingBone.BoneName.ToString(), *SDF.SDFDataAsset->SourceBoneName.ToString(), *SDF.SDFDataAsset->GetName()), this);
+		}
+	}
 	
 }
 
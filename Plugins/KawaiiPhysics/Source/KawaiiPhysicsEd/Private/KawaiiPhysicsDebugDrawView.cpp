@@ -0,0 +1,64 @@
+#include "KawaiiPhysicsDebugDrawView.h"
+#include "SceneManagement.h"
+#include "SceneView.h"
+
+namespace
+{
+	// Shapes smaller than this screen size are not drawn. About 2 pixels in a 1080p viewport
+	const float MinScreenSize = 0.002f;
+
+	// Wire shapes keep this number of sides however far they are
+	const int32 MinNumSides = 6;
+}
+
+FKawaiiPhysicsDebugDrawView::FKawaiiPhysicsDebugDrawView(const FSceneView* InView, const FTransform& InComponentTransform)
+	: View(InView)
+	, ComponentTransform(InComponentTransform)
+{
+}
+
+bool FKawaiiPhysicsDebugDrawView::IsVisible(const FVector& Location, float Radius) const
+{
+	if (!View)
+	{
+		return true;
+	}
+
+	const FVector WorldLocation = ComponentTransform.TransformPosition(Location);
+	const float WorldRadius = Radius * ComponentTransform.GetMaximumAxisScale();
+	if (!View->ViewFrustum.IntersectSphere(WorldLocation, WorldRadius))
+	{
+		return false;
+	}
+
+	// Points and lines have no size
+	return Radius <= 0.0f || GetScreenSize(WorldLocation, WorldRadius) >= MinScreenSize;
+}
+
+int32 FKawaiiPhysicsDebugDrawView::GetNumSides(const FVector& Location, float Radius, int32 MaxSides) const
+{
+	if (!View)
+	{
+		return MaxSides;
+	}
+
+	const FVector WorldLocation = ComponentTransform.TransformPosition(Location);
+	const float WorldRadius = Radius * ComponentTransform.GetMaximumAxisScale();
+	const int32 NumSides = FMath::CeilToInt(MaxSides * GetScreenSize(WorldLocation, WorldRadius) * 2.0f);
+	return FMath::Clamp(NumSides, FMath::Min(MinNumSides, MaxSides), MaxSides);
+}
+
+float FKawaiiPhysicsDebugDrawView::GetDistanceSquared(const FVector& Location) const
+{
+	if (!View)
+	{
+		return 0.0f;
+	}
+
+	return FVector::DistSquared(ComponentTransform.TransformPosition(Location), View->ViewMatrices.GetViewOrigin());
+}
+
+float FKawaiiPhysicsDebugDrawView::GetScreenSize(const FVector& WorldLocation, float Radius) const
+{
+	return ComputeBoundsScreenSize(WorldLocation, Radius, *View);
+}
@@ -4,6 +4,7 @@
 #include "Modules/ModuleManager.h"
 #include "Textures/SlateIcon.h"
 #include "KawaiiPhysicsEditMode.h"
+#include "AnimNode_KawaiiPhysics.h"
 
 #define LOCTEXT_NAMESPACE "FKawaiiPhysicsModuleEd"
 
@@ -12,6 +13,12 @@
 void FKawaiiPhysicsEdModule::StartupModule()
 {
 	FEditorModeRegistry::Get().RegisterMode<FKawaiiPhysicsEditMode>("AnimGraph.SkeletalControl.KawaiiPhysics", LOCTEXT("FKawaiiPhysicsEditMode", "Kawaii Physics"), FSlateIcon(), false);
+
+	// Live nodes refresh their settings only when a curve or a limits data asset they use is edited
+	ObjectPropertyChangedHandle = FCoreUObjectDelegates::OnObjectPropertyChanged.AddLambda([](UObject* Object, FPropertyChangedEvent&)
+	{
+		FAnimNode_KawaiiPhysics::NotifyObjectChanged(Object);
+	});
 }
 
 
@@ -19,6 +26,8 @@ void FKawaiiPhysicsEdModule::StartupModule()
 void FKawaiiPhysicsEdModule::ShutdownModule()
 {
 	FEditorModeRegistry::Get().UnregisterMode("AnimGraph.SkeletalControl.KawaiiPhysics");
+
+	FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(ObjectPropertyChangedHandle);
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -9,7 +9,9 @@
 #include "Materials/MaterialInstanceDynamic.h"
 #include "AnimationRuntime.h"
 #include "KawaiiPhysicsLimitsDataAsset.h"
+#include "KawaiiPhysicsSDFDataAsset.h"
 #include "PhysicsEngine/PhysicsAsset.h"
+#include "KawaiiPhysicsDebugDrawView.h"
 
 #define LOCTEXT_NAMESPACE "KawaiiPhysicsEditMode"
 
@@ -36,6 +38,31 @@ struct HKawaiiPhysicsHitProxy : public HHitProxy
 };
 IMPLEMENT_HIT_PROXY(HKawaiiPhysicsHitProxy, HHitProxy);
 
+namespace
+{
+	// Limits of data assets are shared by nodes. Edit a copy with the state of the node and write it back to the data asset
+	template<typename LimitType>
+	LimitType* CopyLimitData(const FAnimNode_KawaiiPhysics& Node, TArrayView<const LimitType> Limits, ECollisionLimitType Type, int32 Index, LimitType& OutLimit)
+	{
+		const FKawaiiPhysicsLimitInstance* Instance = Node.GetLimitsDataInstance(Type, Index);
+		if (!Instance)
+		{
+			return nullptr;
+		}
+
+		OutLimit = Limits[Index];
+		OutLimit.Location = Instance->Location;
+		OutLimit.Rotation = Instance->Rotation;
+
+		const FBoneContainer& BoneContainer = Node.ForwardedPose.GetPose().GetBoneContainer();
+		if (BoneContainer.IsValid())
+		{
+			OutLimit.DrivingBone.Initialize(BoneContainer);
+		}
+		return &OutLimit;
+	}
+}
+
 
 FKawaiiPhysicsEditMode::FKawaiiPhysicsEditMode()
 	: RuntimeNode(nullptr)
@@ -49,10 +76,6 @@ void FKawaiiPhysicsEditMode::EnterMode(UAnimGraphNode_Base* InEditorNode, FAnimN
 	RuntimeNode = static_cast<FAnimNode_KawaiiPhysics*>(InRuntimeNode);
 	GraphNode = CastChecked<UAnimGraphNode_KawaiiPhysics>(InEditorNode);
 
-	GraphNode->Node.SphericalLimitsData = RuntimeNode->SphericalLimitsData;
-	GraphNode->Node.CapsuleLimitsData = RuntimeNode->CapsuleLimitsData;
-	GraphNode->Node.PlanarLimitsData = RuntimeNode->PlanarLimitsData;
-
 	NodePropertyDelegateHandle = GraphNode->OnNodePropertyChanged().AddSP(this, &FKawaiiPhysicsEditMode::OnExternalNodePropertyChange);
 
 	FKawaiiPhysicsEditModeBase::EnterMode(InEditorNode, InRuntimeNode);
@@ -73,11 +96,16 @@ void FKawaiiPhysicsEditMode::Render(const FSceneView* View, FViewport* Viewport,
 	USkeletalMeshComponent* SkelMeshComp = GetAnimPreviewScene().GetPreviewMeshComponent();
 	if (SkelMeshComp && SkelMeshComp->SkeletalMesh && SkelMeshComp->SkeletalMesh->Skeleton)
 	{
-		RenderSphericalLimits(PDI);
-		RenderCapsuleLimit(PDI);
-		RenderPlanerLimit(PDI);
-		RenderPhysicsAssetAsShape(PDI, SkelMeshComp);
-		RenderPhysicsAssetAsLimit(PDI, SkelMeshComp);
+		const FKawaiiPhysicsDebugDrawView DrawView(View, SkelMeshComp->GetComponentTransform());
+		RuntimeNode->ReadDebugSnapshot([this, PDI, &DrawView](const FKawaiiPhysicsDebugSnapshot& Snapshot)
+		{
+			RenderSphericalLimits(PDI, DrawView, Snapshot);
+			RenderCapsuleLimit(PDI, DrawView, Snapshot);
+			RenderPlanerLimit(PDI, DrawView, Snapshot);
+			RenderSDFLimit(PDI, DrawView, Snapshot);
+		});
+		RenderPhysicsAssetAsShape(PDI, DrawView, SkelMeshComp);
+		RenderPhysicsAssetAsLimit(PDI, DrawView, SkelMeshComp);
 		PDI->SetHitProxy(nullptr);
 
 		if (IsValidSelectCollision())
@@ -102,90 +130,94 @@ void FKawaiiPhysicsEditMode::Render(const FSceneView* View, FViewport* Viewport,
 	FKawaiiPhysicsEditModeBase::Render(View, Viewport, PDI);
 }
 
-void FKawaiiPhysicsEditMode::RenderSphericalLimits(FPrimitiveDrawInterface* PDI)
+void FKawaiiPhysicsEditMode::RenderSphericalLimits(FPrimitiveDrawInterface* PDI, const FKawaiiPhysicsDebugDrawView& DrawView, const FKawaiiPhysicsDebugSnapshot& Snapshot)
 {
 	if (GraphNode->bEnableDebugDrawSphereLimit)
 	{
-		for( int i=0; i< RuntimeNode->SphericalLimits.Num(); i++)
+		for( int i=0; i< Snapshot.SphericalLimits.Num(); i++)
 		{
-			auto& Sphere = RuntimeNode->SphericalLimits[i];
-			if (Sphere.Radius > 0)
+			auto& Sphere = Snapshot.SphericalLimits[i];
+			if (Sphere.Radius > 0 && DrawView.IsVisible(Sphere.Location, Sphere.Radius))
 			{
-				FTransform SphereTransform = FTransform(Sphere.Location);
+				const int32 NumSides = DrawView.GetNumSides(Sphere.Location, Sphere.Radius, 24);
 
 				PDI->SetHitProxy(new HKawaiiPhysicsHitProxy(ECollisionLimitType::Spherical, i));
-				DrawSphere(PDI, Sphere.Location, FRotator::ZeroRotator, FVector(Sphere.Radius), 24, 6,
+				DrawSphere(PDI, Sphere.Location, FRotator::ZeroRotator, FVector(Sphere.Radius), NumSides, FMath::Max(NumSides / 4, 2),
 					GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy(), SDPG_World);
-				DrawWireSphere(PDI, Sphere.Location, FLinearColor::Black, Sphere.Radius, 24, SDPG_World);
+				DrawWireSphere(PDI, Sphere.Location, FLinearColor::Black, Sphere.Radius, NumSides, SDPG_World);
 				DrawCoordinateSystem(PDI, Sphere.Location, Sphere.Rotation.Rotator(), Sphere.Radius, SDPG_World + 1);
 			}
 		}
 
-		for (int i = 0; i < RuntimeNode->SphericalLimitsData.Num(); i++)
+		for (int i = 0; i < Snapshot.SphericalLimitsData.Num(); i++)
 		{
-			auto& Sphere = RuntimeNode->SphericalLimitsData[i];
-			if (Sphere.Radius > 0)
+			auto& Sphere = Snapshot.SphericalLimitsData[i];
+			if (Sphere.Radius > 0 && DrawView.IsVisible(Sphere.Location, Sphere.Radius))
 			{
-				FTransform SphereTransform = FTransform(Sphere.Location);
+				const int32 NumSides = DrawView.GetNumSides(Sphere.Location, Sphere.Radius, 24);
 
 				PDI->SetHitProxy(new HKawaiiPhysicsHitProxy(ECollisionLimitType::Spherical, i, true));
-				DrawSphere(PDI, Sphere.Location, FRotator::ZeroRotator, FVector(Sphere.Radius), 24, 6,
+				DrawSphere(PDI, Sphere.Location, FRotator::ZeroRotator, FVector(Sphere.Radius), NumSides, FMath::Max(NumSides / 4, 2),
 					GEngine->ConstraintLimitMaterialZ->GetRenderProxy(), SDPG_World);
-				DrawWireSphere(PDI, Sphere.Location, FLinearColor::Black, Sphere.Radius, 24, SDPG_World);
+				DrawWireSphere(PDI, Sphere.Location, FLinearColor::Black, Sphere.Radius, NumSides, SDPG_World);
 				DrawCoordinateSystem(PDI, Sphere.Location, Sphere.Rotation.Rotator(), Sphere.Radius, SDPG_World + 1);
 			}
 		}
 	}
 }
 
-void FKawaiiPhysicsEditMode::RenderCapsuleLimit(FPrimitiveDrawInterface* PDI)
+void FKawaiiPhysicsEditMode::RenderCapsuleLimit(FPrimitiveDrawInterface* PDI, const FKawaiiPhysicsDebugDrawView& DrawView, const FKawaiiPhysicsDebugSnapshot& Snapshot)
 {
 	if (GraphNode->bEnableDebugDrawCapsuleLimit)
 	{
-		for (int i = 0; i < RuntimeNode->CapsuleLimits.Num(); i++)
+		for (int i = 0; i < Snapshot.CapsuleLimits.Num(); i++)
 		{
-			auto& Capsule = RuntimeNode->CapsuleLimits[i];
-			if (Capsule.Radius > 0 && Capsule.Length > 0)
+			auto& Capsule = Snapshot.CapsuleLimits[i];
+			const float BoundsRadius = Capsule.Radius + 0.5f * Capsule.Length;
+			if (Capsule.Radius > 0 && Capsule.Length > 0 && DrawView.IsVisible(Capsule.Location, BoundsRadius))
 			{
 				FVector XAxis = Capsule.Rotation.GetAxisX();
 				FVector YAxis = Capsule.Rotation.GetAxisY();
 				FVector ZAxis = Capsule.Rotation.GetAxisZ();
+				const int32 NumSides = DrawView.GetNumSides(Capsule.Location, BoundsRadius, 24);
 
 				PDI->SetHitProxy(new HKawaiiPhysicsHitProxy(ECollisionLimitType::Capsule, i));
-				DrawCylinder(PDI, Capsule.Location, XAxis, YAxis, ZAxis, Capsule.Radius, 0.5f* Capsule.Length, 25,
+				DrawCylinder(PDI, Capsule.Location, XAxis, YAxis, ZAxis, Capsule.Radius, 0.5f* Capsule.Length, NumSides + 1,
 					GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy(), SDPG_World);
 				DrawSphere(PDI, Capsule.Location + ZAxis * Capsule.Length * 0.5f, Capsule.Rotation.Rotator(), FVector(Capsule.Radius),
-					24, 6, GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy(), SDPG_World);
+					NumSides, FMath::Max(NumSides / 4, 2), GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy(), SDPG_World);
 				DrawSphere(PDI, Capsule.Location - ZAxis * Capsule.Length * 0.5f, Capsule.Rotation.Rotator(), FVector(Capsule.Radius),
-					24, 6, GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy(), SDPG_World);
+					NumSides, FMath::Max(NumSides / 4, 2), GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy(), SDPG_World);
 
 				DrawWireCapsule(PDI, Capsule.Location, XAxis, YAxis, ZAxis,
-					FLinearColor::Black, Capsule.Radius, 0.5f* Capsule.Length + Capsule.Radius, 25, SDPG_World);
+					FLinearColor::Black, Capsule.Radius, 0.5f* Capsule.Length + Capsule.Radius, NumSides + 1, SDPG_World);
 
 				DrawCoordinateSystem(PDI, Capsule.Location, Capsule.Rotation.Rotator(), Capsule.Radius, SDPG_World + 1);
 
 			}
 		}
 
-		for (int i = 0; i < RuntimeNode->CapsuleLimitsData.Num(); i++)
+		for (int i = 0; i < Snapshot.CapsuleLimitsData.Num(); i++)
 		{
-			auto& Capsule = RuntimeNode->CapsuleLimitsData[i];
-			if (Capsule.Radius > 0 && Capsule.Length > 0)
+			auto& Capsule = Snapshot.CapsuleLimitsData[i];
+			const float BoundsRadius = Capsule.Radius + 0.5f * Capsule.Length;
+			if (Capsule.Radius > 0 && Capsule.Length > 0 && DrawView.IsVisible(Capsule.Location, BoundsRadius))
 			{
 				FVector XAxis = Capsule.Rotation.GetAxisX();
 				FVector YAxis = Capsule.Rotation.GetAxisY();
 				FVector ZAxis = Capsule.Rotation.GetAxisZ();
+				const int32 NumSides = DrawView.GetNumSides(Capsule.Location, BoundsRadius, 24);
 
 				PDI->SetHitProxy(new HKawaiiPhysicsHitProxy(ECollisionLimitType::Capsule, i, true));
-				DrawCylinder(PDI, Capsule.Location, XAxis, YAxis, ZAxis, Capsule.Radius, 0.5f* Capsule.Length, 25,
+				DrawCylinder(PDI, Capsule.Location, XAxis, YAxis, ZAxis, Capsule.Radius, 0.5f* Capsule.Length, NumSides + 1,
 					GEngine->ConstraintLimitMaterialZ->GetRenderProxy(), SDPG_World);
 				DrawSphere(PDI, Capsule.Location + ZAxis * Capsule.Length * 0.5f, Capsule.Rotation.Rotator(), FVector(Capsule.Radius),
-					24, 6, GEngine->ConstraintLimitMaterialZ->GetRenderProxy(), SDPG_World);
+					NumSides, FMath::Max(NumSides / 4, 2), GEngine->ConstraintLimitMaterialZ->GetRenderProxy(), SDPG_World);
 				DrawSphere(PDI, Capsule.Location - ZAxis * Capsule.Length * 0.5f, Capsule.Rotation.Rotator(), FVector(Capsule.Radius),
-					24, 6, GEngine->ConstraintLimitMaterialZ->GetRenderProxy(), SDPG_World);
+					NumSides, FMath::Max(NumSides / 4, 2), GEngine->ConstraintLimitMaterialZ->GetRenderProxy(), SDPG_World);
 
 				DrawWireCapsule(PDI, Capsule.Location, XAxis, YAxis, ZAxis,
-					FLinearColor::Black, Capsule.Radius, 0.5f* Capsule.Length + Capsule.Radius, 25, SDPG_World);
+					FLinearColor::Black, Capsule.Radius, 0.5f* Capsule.Length + Capsule.Radius, NumSides + 1, SDPG_World);
 
 				DrawCoordinateSystem(PDI, Capsule.Location, Capsule.Rotation.Rotator(), Capsule.Radius, SDPG_World + 1);
 
@@ -194,29 +226,42 @@ void FKawaiiPhysicsEditMode::RenderCapsuleLimit(FPrimitiveDrawInterface* PDI)
 	}
 }
 
-void FKawaiiPhysicsEditMode::RenderPlanerLimit(FPrimitiveDrawInterface* PDI)
+void FKawaiiPhysicsEditMode::RenderPlanerLimit(FPrimitiveDrawInterface* PDI, const FKawaiiPhysicsDebugDrawView& DrawView, const FKawaiiPhysicsDebugSnapshot& Snapshot)
 {
 	if (GraphNode->bEnableDebugDrawPlanerLimit)
 	{
-		for (int i = 0; i < RuntimeNode->PlanarLimits.Num(); i++)
+		// Half diagonal of the drawn plane
+		const float PlaneBoundsRadius = 200.0f * UE_SQRT_2;
+
+		for (int i = 0; i < Snapshot.PlanarLimits.Num(); i++)
 		{
-			auto& Plane = RuntimeNode->PlanarLimits[i];
+			auto& Plane = Snapshot.PlanarLimits[i];
 			
 			FTransform PlaneTransform = FTransform(Plane.Rotation, Plane.Location);
 			PlaneTransform.NormalizeRotation();
 
+			if (!DrawView.IsVisible(Plane.Location, PlaneBoundsRadius))
+			{
+				continue;
+			}
+
 			PDI->SetHitProxy(new HKawaiiPhysicsHitProxy(ECollisionLimitType::Planar, i));
 			DrawPlane10x10(PDI, PlaneTransform.ToMatrixWithScale(), 200.0f, FVector2D(0.0f, 0.0f), FVector2D(1.0f, 1.0f), GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy(), SDPG_World);
 			DrawDirectionalArrow(PDI, FRotationMatrix(FRotator(90.0f, 0.0f, 0.0f)) * PlaneTransform.ToMatrixWithScale(), FLinearColor::Blue, 50.0f, 20.0f, SDPG_Foreground, 0.5f);
 		}
 
-		for (int i = 0; i < RuntimeNode->PlanarLimitsData.Num(); i++)
+		for (int i = 0; i < Snapshot.PlanarLimitsData.Num(); i++)
 		{
-			auto& Plane = RuntimeNode->PlanarLimitsData[i];
+			auto& Plane = Snapshot.PlanarLimitsData[i];
 
 			FTransform PlaneTransform = FTransform(Plane.Rotation, Plane.Location);
 			PlaneTransform.NormalizeRotation();
 
+			if (!DrawView.IsVisible(Plane.Location, PlaneBoundsRadius))
+			{
+				continue;
+			}
+
 			PDI->SetHitProxy(new HKawaiiPhysicsHitProxy(ECollisionLimitType::Planar, i, true));
 			DrawPlane10x10(PDI, PlaneTransform.ToMatrixWithScale(), 200.0f, FVector2D(0.0f, 0.0f), FVector2D(1.0f, 1.0f), GEngine->ConstraintLimitMaterialZ->GetRenderProxy(), SDPG_World);
 			DrawDirectionalArrow(PDI, FRotationMatrix(FRotator(90.0f, 0.0f, 0.0f)) * PlaneTransform.ToMatrixWithScale(), FLinearColor::Blue, 50.0f, 20.0f, SDPG_Foreground, 0.5f);
@@ -224,165 +269,148 @@ void FKawaiiPhysicsEditMode::RenderPlanerLimit(FPrimitiveDrawInterface* PDI)
 	}
 }
 
-void FKawaiiPhysicsEditMode::RenderPhysicsAssetAsShape(FPrimitiveDrawInterface* PDI, const USkeletalMeshComponent* SkeletalMeshComp)
+void FKawaiiPhysicsEditMode::RenderSDFLimit(FPrimitiveDrawInterface* PDI, const FKawaiiPhysicsDebugDrawView& DrawView, const FKawaiiPhysicsDebugSnapshot& Snapshot)
 {
-	if (GraphNode->bEnableDebugDrawPhysicsAssetAsShape && RuntimeNode->bUsePhysicsAssetAsShapes && RuntimeNode->PhysicsAssetAsShapes != nullptr)
+	if (GraphNode->bEnableDebugDrawSDFLimit)
 	{
-		// UPhysicsAssetEditorSkeletalMeshComponent::GetPrimitiveColor()ElemSelectedColor̐FfobKŒl𒲂ׂ
-		const FColor ElemSelectedColor = FColor(222, 163, 9);
-
-		// UPhysicsAssetEditorSkeletalMeshComponent::RenderAssetTools()QlɂĂ
-
-		// Draw bodies
-		for (int32 i = 0; i <RuntimeNode->PhysicsAssetAsShapes->SkeletalBodySetups.Num(); ++i)
+		for (int i = 0; i < Snapshot.SDFLimits.Num(); i++)
 		{
-			if (!ensure(RuntimeNode->PhysicsAssetAsShapes->SkeletalBodySetups[i]))
-			{
-				continue;
-			}
-			int32 BoneIndex = SkeletalMeshComp->GetBoneIndex(RuntimeNode->PhysicsAssetAsShapes->SkeletalBodySetups[i]->BoneName);
-
-			// If we found a bone for it, draw the collision.
-			if (BoneIndex != INDEX_NONE)
+			auto& SDF = Snapshot.SDFLimits[i];
+			if (SDF.SDFDataAsset && SDF.SDFDataAsset->IsValidField())
 			{
-				FTransform BoneTM = SkeletalMeshComp->GetBoneTransform(BoneIndex, FTransform::Identity); // R|[lgWłTransform
-				float Scale = BoneTM.GetScale3D().GetAbsMax();
-				FVector VectorScale(Scale);
-				BoneTM.RemoveScaling();
-
-				FKAggregateGeom* AggGeom = &RuntimeNode->PhysicsAssetAsShapes->SkeletalBodySetups[i]->AggGeom;
-
-				for (int32 j = 0; j <AggGeom->SphereElems.Num(); ++j)
-				{
-					FTransform ElemTM = AggGeom->SphereElems[j].GetTransform();
-					ElemTM.ScaleTranslation(VectorScale);
-					ElemTM *= BoneTM;
-
-					AggGeom->SphereElems[j].DrawElemSolid(PDI, ElemTM, VectorScale, GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy());
-					AggGeom->SphereElems[j].DrawElemWire(PDI, ElemTM, VectorScale, FColor::Black);
-				}
-
-				for (int32 j = 0; j <AggGeom->BoxElems.Num(); ++j)
-				{
-					FTransform ElemTM = AggGeom->BoxElems[j].GetTransform();
-					ElemTM.ScaleTranslation(VectorScale);
-					ElemTM *= BoneTM;
-
-					AggGeom->BoxElems[j].DrawElemSolid(PDI, ElemTM, VectorScale, GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy());
-					AggGeom->BoxElems[j].DrawElemWire(PDI, ElemTM, VectorScale, FColor::Black);
-				}
-
-				for (int32 j = 0; j <AggGeom->SphylElems.Num(); ++j)
+				FTransform SDFTransform = FTransform(SDF.Rotation, SDF.Location);
+				const FBox Bounds = SDF.SDFDataAsset->GetBounds();
+				if (!DrawView.IsVisible(SDFTransform.TransformPosition(Bounds.GetCenter()), Bounds.GetExtent().Size()))
 				{
-					FTransform ElemTM = AggGeom->SphylElems[j].GetTransform();
-					ElemTM.ScaleTranslation(VectorScale);
-					ElemTM *= BoneTM;
-
-					AggGeom->SphylElems[j].DrawElemSolid(PDI, ElemTM, VectorScale, GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy());
-					AggGeom->SphylElems[j].DrawElemWire(PDI, ElemTM, VectorScale, ElemSelectedColor);
+					continue;
 				}
 
-				for (int32 j = 0; j <AggGeom->ConvexElems.Num(); ++j)
-				{
-					FTransform ElemTM = AggGeom->ConvexElems[j].GetTransform();
-					ElemTM.ScaleTranslation(VectorScale);
-					ElemTM *= BoneTM;
-
-					//convex doesn't have solid draw so render lines if we're in hitTestAndBodyMode
-					AggGeom->ConvexElems[j].DrawElemWire(PDI, ElemTM, Scale, ElemSelectedColor);
-				}
-
-				for (int32 j = 0; j <AggGeom->TaperedCapsuleElems.Num(); ++j)
-				{
-					FTransform ElemTM = AggGeom->TaperedCapsuleElems[j].GetTransform();
-					ElemTM.ScaleTranslation(VectorScale);
-					ElemTM *= BoneTM;
-
-					AggGeom->TaperedCapsuleElems[j].DrawElemSolid(PDI, ElemTM, VectorScale, GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy());
-					AggGeom->TaperedCapsuleElems[j].DrawElemWire(PDI, ElemTM, VectorScale, ElemSelectedColor);
-				}
+				PDI->SetHitProxy(new HKawaiiPhysicsHitProxy(ECollisionLimitType::SDF, i));
+				DrawWireBox(PDI, SDFTransform.ToMatrixNoScale(), Bounds, FLinearColor::Black, SDPG_World);
+				DrawCoordinateSystem(PDI, SDF.Location, SDF.Rotation.Rotator(), SDF.SDFDataAsset->CellSize * 2.0f, SDPG_World + 1);
 			}
 		}
 	}
 }
 
-void FKawaiiPhysicsEditMode::RenderPhysicsAssetAsLimit(FPrimitiveDrawInterface* PDI, const USkeletalMeshComponent* SkeletalMeshComp)
+void FKawaiiPhysicsEditMode::RenderPhysicsAssetAsShape(FPrimitiveDrawInterface* PDI, const FKawaiiPhysicsDebugDrawView& DrawView, const USkeletalMeshComponent* SkeletalMeshComp)
+{
+	if (GraphNode->bEnableDebugDrawPhysicsAssetAsShape && RuntimeNode->bUsePhysicsAssetAsShapes && RuntimeNode->PhysicsAssetAsShapes != nullptr)
+	{
+		RenderPhysicsAssetBodies(PDI, DrawView, RuntimeNode->PhysicsAssetAsShapes,
+			PhysicsAssetAsShapesBoneIndices.Get(RuntimeNode->PhysicsAssetAsShapes, SkeletalMeshComp), SkeletalMeshComp);
+	}
+}
+
+void FKawaiiPhysicsEditMode::RenderPhysicsAssetAsLimit(FPrimitiveDrawInterface* PDI, const FKawaiiPhysicsDebugDrawView& DrawView, const USkeletalMeshComponent* SkeletalMeshComp)
 {
 	if (GraphNode->bEnableDebugDrawPhysicsAssetAsLimit && RuntimeNode->bUsePhysicsAssetAsLimits && RuntimeNode->UsePhysicsAssetAsLimits != nullptr)
 	{
-		// UPhysicsAssetEditorSkeletalMeshComponent::GetPrimitiveColor()ElemSelectedColor̐FfobKŒl𒲂ׂ
-		const FColor ElemSelectedColor = FColor(222, 163, 9);
+		RenderPhysicsAssetBodies(PDI, DrawView, RuntimeNode->UsePhysicsAssetAsLimits,
+			UsePhysicsAssetAsLimitsBoneIndices.Get(RuntimeNode->UsePhysicsAssetAsLimits, SkeletalMeshComp), SkeletalMeshComp);
+	}
+}
 
-		// UPhysicsAssetEditorSkeletalMeshComponent::RenderAssetTools()QlɂĂ
+void FKawaiiPhysicsEditMode::RenderPhysicsAssetBodies(FPrimitiveDrawInterface* PDI, const FKawaiiPhysicsDebugDrawView& DrawView,
+	const UPhysicsAsset* PhysicsAsset, const TArray<int32>& BoneIndices, const USkeletalMeshComponent* SkeletalMeshComp)
+{
+	// UPhysicsAssetEditorSkeletalMeshComponent::GetPrimitiveColor()ElemSelectedColor̐FfobKŒl𒲂ׂ
+	const FColor ElemSelectedColor = FColor(222, 163, 9);
 
-		// Draw bodies
-		for (int32 i = 0; i <RuntimeNode->UsePhysicsAssetAsLimits->SkeletalBodySetups.Num(); ++i)
+	// UPhysicsAssetEditorSkeletalMeshComponent::RenderAssetTools()QlɂĂ
+
+	// Draw bodies
+	for (int32 i = 0; i < PhysicsAsset->SkeletalBodySetups.Num(); ++i)
+	{
+		if (!ensure(PhysicsAsset->SkeletalBodySetups[i]))
 		{
-			if (!ensure(RuntimeNode->UsePhysicsAssetAsLimits->SkeletalBodySetups[i]))
-			{
-				continue;
-			}
-			int32 BoneIndex = SkeletalMeshComp->GetBoneIndex(RuntimeNode->UsePhysicsAssetAsLimits->SkeletalBodySetups[i]->BoneName);
+			continue;
+		}
+		const int32 BoneIndex = BoneIndices[i];
 
-			// If we found a bone for it, draw the collision.
-			if (BoneIndex != INDEX_NONE)
-			{
-				FTransform BoneTM = SkeletalMeshComp->GetBoneTransform(BoneIndex, FTransform::Identity); // R|[lgWłTransform
-				float Scale = BoneTM.GetScale3D().GetAbsMax();
-				FVector VectorScale(Scale);
-				BoneTM.RemoveScaling();
+		// If we found a bone for it, draw the collision.
+		if (BoneIndex != INDEX_NONE)
+		{
+			FTransform BoneTM = SkeletalMeshComp->GetBoneTransform(BoneIndex, FTransform::Identity); // R|[lgWłTransform
+			float Scale = BoneTM.GetScale3D().GetAbsMax();
+			FVector VectorScale(Scale);
+			BoneTM.RemoveScaling();
 
-				FKAggregateGeom* AggGeom = &RuntimeNode->UsePhysicsAssetAsLimits->SkeletalBodySetups[i]->AggGeom;
+			const FKAggregateGeom* AggGeom = &PhysicsAsset->SkeletalBodySetups[i]->AggGeom;
 
-				for (int32 j = 0; j <AggGeom->SphereElems.Num(); ++j)
+			for (int32 j = 0; j <AggGeom->SphereElems.Num(); ++j)
+			{
+				FTransform ElemTM = AggGeom->SphereElems[j].GetTransform();
+				ElemTM.ScaleTranslation(VectorScale);
+				ElemTM *= BoneTM;
+				if (!DrawView.IsVisible(ElemTM.GetLocation(), AggGeom->SphereElems[j].Radius * Scale))
 				{
-					FTransform ElemTM = AggGeom->SphereElems[j].GetTransform();
-					ElemTM.ScaleTranslation(VectorScale);
-					ElemTM *= BoneTM;
-
-					AggGeom->SphereElems[j].DrawElemSolid(PDI, ElemTM, VectorScale, GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy());
-					AggGeom->SphereElems[j].DrawElemWire(PDI, ElemTM, VectorScale, FColor::Black);
+					continue;
 				}
 
-				for (int32 j = 0; j <AggGeom->BoxElems.Num(); ++j)
-				{
-					FTransform ElemTM = AggGeom->BoxElems[j].GetTransform();
-					ElemTM.ScaleTranslation(VectorScale);
-					ElemTM *= BoneTM;
+				AggGeom->SphereElems[j].DrawElemSolid(PDI, ElemTM, VectorScale, GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy());
+				AggGeom->SphereElems[j].DrawElemWire(PDI, ElemTM, VectorScale, FColor::Black);
+			}
 
-					AggGeom->BoxElems[j].DrawElemSolid(PDI, ElemTM, VectorScale, GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy());
-					AggGeom->BoxElems[j].DrawElemWire(PDI, ElemTM, VectorScale, FColor::Black);
+			for (int32 j = 0; j <AggGeom->BoxElems.Num(); ++j)
+			{
+				FTransform ElemTM = AggGeom->BoxElems[j].GetTransform();
+				ElemTM.ScaleTranslation(VectorScale);
+				ElemTM *= BoneTM;
+				const FKBoxElem& Box = AggGeom->BoxElems[j];
+				if (!DrawView.IsVisible(ElemTM.GetLocation(), 0.5f * FVector(Box.X, Box.Y, Box.Z).Size() * Scale))
+				{
+					continue;
 				}
 
-				for (int32 j = 0; j <AggGeom->SphylElems.Num(); ++j)
-				{
-					FTransform ElemTM = AggGeom->SphylElems[j].GetTransform();
-					ElemTM.ScaleTranslation(VectorScale);
-					ElemTM *= BoneTM;
+				AggGeom->BoxElems[j].DrawElemSolid(PDI, ElemTM, VectorScale, GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy());
+				AggGeom->BoxElems[j].DrawElemWire(PDI, ElemTM, VectorScale, FColor::Black);
+			}
 
-					AggGeom->SphylElems[j].DrawElemSolid(PDI, ElemTM, VectorScale, GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy());
-					AggGeom->SphylElems[j].DrawElemWire(PDI, ElemTM, VectorScale, ElemSelectedColor);
+			for (int32 j = 0; j <AggGeom->SphylElems.Num(); ++j)
+			{
+				FTransform ElemTM = AggGeom->SphylElems[j].GetTransform();
+				ElemTM.ScaleTranslation(VectorScale);
+				ElemTM *= BoneTM;
+				const FKSphylElem& Sphyl = AggGeom->SphylElems[j];
+				if (!DrawView.IsVisible(ElemTM.GetLocation(), (Sphyl.Radius + 0.5f * Sphyl.Length) * Scale))
+				{
+					continue;
 				}
 
-				for (int32 j = 0; j <AggGeom->ConvexElems.Num(); ++j)
-				{
-					FTransform ElemTM = AggGeom->ConvexElems[j].GetTransform();
-					ElemTM.ScaleTranslation(VectorScale);
-					ElemTM *= BoneTM;
+				AggGeom->SphylElems[j].DrawElemSolid(PDI, ElemTM, VectorScale, GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy());
+				AggGeom->SphylElems[j].DrawElemWire(PDI, ElemTM, VectorScale, ElemSelectedColor);
+			}
 
-					//convex doesn't have solid draw so render lines if we're in hitTestAndBodyMode
-					AggGeom->ConvexElems[j].DrawElemWire(PDI, ElemTM, Scale, ElemSelectedColor);
+			for (int32 j = 0; j <AggGeom->ConvexElems.Num(); ++j)
+			{
+				FTransform ElemTM = AggGeom->ConvexElems[j].GetTransform();
+				ElemTM.ScaleTranslation(VectorScale);
+				ElemTM *= BoneTM;
+				const FBox& ElemBox = AggGeom->ConvexElems[j].ElemBox;
+				if (!DrawView.IsVisible(ElemTM.TransformPosition(ElemBox.GetCenter() * Scale), ElemBox.GetExtent().Size() * Scale))
+				{
+					continue;
 				}
 
-				for (int32 j = 0; j <AggGeom->TaperedCapsuleElems.Num(); ++j)
-				{
-					FTransform ElemTM = AggGeom->TaperedCapsuleElems[j].GetTransform();
-					ElemTM.ScaleTranslation(VectorScale);
-					ElemTM *= BoneTM;
+				//convex doesn't have solid draw so render lines if we're in hitTestAndBodyMode
+				AggGeom->ConvexElems[j].DrawElemWire(PDI, ElemTM, Scale, ElemSelectedColor);
+			}
 
-					AggGeom->TaperedCapsuleElems[j].DrawElemSolid(PDI, ElemTM, VectorScale, GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy());
-					AggGeom->TaperedCapsuleElems[j].DrawElemWire(PDI, ElemTM, VectorScale, ElemSelectedColor);
+			for (int32 j = 0; j <AggGeom->TaperedCapsuleElems.Num(); ++j)
+			{
+				FTransform ElemTM = AggGeom->TaperedCapsuleElems[j].GetTransform();
+				ElemTM.ScaleTranslation(VectorScale);
+				ElemTM *= BoneTM;
+				const FKTaperedCapsuleElem& TaperedCapsule = AggGeom->TaperedCapsuleElems[j];
+				const float MaxRadius = FMath::Max(TaperedCapsule.Radius0, TaperedCapsule.Radius1);
+				if (!DrawView.IsVisible(ElemTM.GetLocation(), (MaxRadius + 0.5f * TaperedCapsule.Length) * Scale))
+				{
+					continue;
 				}
+
+				AggGeom->TaperedCapsuleElems[j].DrawElemSolid(PDI, ElemTM, VectorScale, GEngine->ConstraintLimitMaterialPrismatic->GetRenderProxy());
+				AggGeom->TaperedCapsuleElems[j].DrawElemWire(PDI, ElemTM, VectorScale, ElemSelectedColor);
 			}
 		}
 	}
@@ -512,6 +540,10 @@ bool FKawaiiPhysicsEditMode::InputKey(FEditorViewportClient* InViewportClient, F
 				RuntimeNode->PlanarLimits.RemoveAt(SelectCollisionIndex);
 				GraphNode->Node.PlanarLimits.RemoveAt(SelectCollisionIndex);
 				break;
+			case ECollisionLimitType::SDF:
+				RuntimeNode->SDFLimits.RemoveAt(SelectCollisionIndex);
+				GraphNode->Node.SDFLimits.RemoveAt(SelectCollisionIndex);
+				break;
 			}
 		}
 	}
@@ -546,14 +578,16 @@ bool FKawaiiPhysicsEditMode::IsValidSelectCollision() const
 	switch (SelectCollisionType)
 	{
 	case ECollisionLimitType::Spherical:
-		return SelectCollisionIsFromDataAsset ? RuntimeNode->SphericalLimitsData.IsValidIndex(SelectCollisionIndex)
+		return SelectCollisionIsFromDataAsset ? RuntimeNode->GetSphericalLimitsData().IsValidIndex(SelectCollisionIndex)
 			: RuntimeNode->SphericalLimits.IsValidIndex(SelectCollisionIndex);
 	case ECollisionLimitType::Capsule:
-		return SelectCollisionIsFromDataAsset ? RuntimeNode->CapsuleLimitsData.IsValidIndex(SelectCollisionIndex)
+		return SelectCollisionIsFromDataAsset ? RuntimeNode->GetCapsuleLimitsData().IsValidIndex(SelectCollisionIndex)
 			: RuntimeNode->CapsuleLimits.IsValidIndex(SelectCollisionIndex);
 	case ECollisionLimitType::Planar:
-		return SelectCollisionIsFromDataAsset ? RuntimeNode->PlanarLimitsData.IsValidIndex(SelectCollisionIndex)
+		return SelectCollisionIsFromDataAsset ? RuntimeNode->GetPlanarLimitsData().IsValidIndex(SelectCollisionIndex)
 			: RuntimeNode->PlanarLimits.IsValidIndex(SelectCollisionIndex);
+	case ECollisionLimitType::SDF:
+		return RuntimeNode->SDFLimits.IsValidIndex(SelectCollisionIndex);
 	}
 	return false;
 }
@@ -568,14 +602,16 @@ FCollisionLimitBase* FKawaiiPhysicsEditMode::GetSelectCollisionLimitRuntime() co
 	switch (SelectCollisionType)
 	{
 	case ECollisionLimitType::Spherical:
-		return SelectCollisionIsFromDataAsset ? &(RuntimeNode->SphericalLimitsData[SelectCollisionIndex])
+		return SelectCollisionIsFromDataAsset ? CopyLimitData(*RuntimeNode, RuntimeNode->GetSphericalLimitsData(), SelectCollisionType, SelectCollisionIndex, SelectSphericalLimitData)
 			: &(RuntimeNode->SphericalLimits[SelectCollisionIndex]);
 	case ECollisionLimitType::Capsule:
-		return SelectCollisionIsFromDataAsset ? &(RuntimeNode->CapsuleLimitsData[SelectCollisionIndex])
+		return SelectCollisionIsFromDataAsset ? CopyLimitData(*RuntimeNode, RuntimeNode->GetCapsuleLimitsData(), SelectCollisionType, SelectCollisionIndex, SelectCapsuleLimitData)
 			: &(RuntimeNode->CapsuleLimits[SelectCollisionIndex]);
 	case ECollisionLimitType::Planar:
-		return SelectCollisionIsFromDataAsset ? &(RuntimeNode->PlanarLimitsData[SelectCollisionIndex])
+		return SelectCollisionIsFromDataAsset ? CopyLimitData(*RuntimeNode, RuntimeNode->GetPlanarLimitsData(), SelectCollisionType, SelectCollisionIndex, SelectPlanarLimitData)
 			: &(RuntimeNode->PlanarLimits[SelectCollisionIndex]);
+	case ECollisionLimitType::SDF:
+		return &(RuntimeNode->SDFLimits[SelectCollisionIndex]);
 	}
 
 	return nullptr;
@@ -588,17 +624,22 @@ FCollisionLimitBase* FKawaiiPhysicsEditMode::GetSelectCollisionLimitGraph() cons
 		return nullptr;
 	}
 
+	// The graph node has no copy of the limits of the data asset
+	if (SelectCollisionIsFromDataAsset)
+	{
+		return GetSelectCollisionLimitRuntime();
+	}
+
 	switch (SelectCollisionType)
 	{
 	case ECollisionLimitType::Spherical:
-		return SelectCollisionIsFromDataAsset ? &(GraphNode->Node.SphericalLimitsData[SelectCollisionIndex])
-			: &(GraphNode->Node.SphericalLimits[SelectCollisionIndex]);
+		return &(GraphNode->Node.SphericalLimits[SelectCollisionIndex]);
 	case ECollisionLimitType::Capsule:
-		return SelectCollisionIsFromDataAsset ? &(GraphNode->Node.CapsuleLimitsData[SelectCollisionIndex])
-			: &(GraphNode->Node.CapsuleLimits[SelectCollisionIndex]);
+		return &(GraphNode->Node.CapsuleLimits[SelectCollisionIndex]);
 	case ECollisionLimitType::Planar:
-		return SelectCollisionIsFromDataAsset ? &(GraphNode->Node.PlanarLimitsData[SelectCollisionIndex])
-			: &(GraphNode->Node.PlanarLimits[SelectCollisionIndex]);
+		return &(GraphNode->Node.PlanarLimits[SelectCollisionIndex]);
+	case ECollisionLimitType::SDF:
+		return GraphNode->Node.SDFLimits.IsValidIndex(SelectCollisionIndex) ? &(GraphNode->Node.SDFLimits[SelectCollisionIndex]) : nullptr;
 	}
 
 	return nullptr;
@@ -630,6 +671,7 @@ void FKawaiiPhysicsEditMode::DoTranslation(FVector& InTranslation)
 	}
 	CollisionRuntime->OffsetLocation += Offset;
 	CollisionGraph->OffsetLocation = CollisionRuntime->OffsetLocation;
+	RuntimeNode->NotifyLimitsChanged();
 
 	if(SelectCollisionIsFromDataAsset)
 	{
@@ -655,6 +697,7 @@ void FKawaiiPhysicsEditMode::DoRotation(FRotator& InRotation)
 	FQuat DeltaQuat = ConvertCSRotationToBoneSpace(SkelComp, InRotation, RuntimeNode->ForwardedPose, CollisionRuntime->DrivingBone.BoneName, BCS_BoneSpace);
 	CollisionRuntime->OffsetRotation = FRotator(DeltaQuat * CollisionRuntime->OffsetRotation.Quaternion());
 	CollisionGraph->OffsetRotation = CollisionRuntime->OffsetRotation;
+	RuntimeNode->NotifyLimitsChanged();
 
 	if (SelectCollisionIsFromDataAsset)
 	{
@@ -664,7 +707,7 @@ void FKawaiiPhysicsEditMode::DoRotation(FRotator& InRotation)
 
 void FKawaiiPhysicsEditMode::DoScale(FVector& InScale)
 {
-	if (!IsValidSelectCollision() || InScale.IsNearlyZero() || SelectCollisionType == ECollisionLimitType::Planar)
+	if (!IsValidSelectCollision() || InScale.IsNearlyZero() || SelectCollisionType == ECollisionLimitType::Planar || SelectCollisionType == ECollisionLimitType::SDF)
 	{
 		return;
 	}
@@ -672,11 +715,14 @@ void FKawaiiPhysicsEditMode::DoScale(FVector& InScale)
 
 	if (SelectCollisionType == ECollisionLimitType::Spherical)
 	{
-		FSphericalLimit& SphericalLimitRuntime = SelectCollisionIsFromDataAsset ? RuntimeNode->SphericalLimitsData[SelectCollisionIndex]
-			: RuntimeNode->SphericalLimits[SelectCollisionIndex];
-
-		FSphericalLimit& SphericalLimitGraph = SelectCollisionIsFromDataAsset ? (GraphNode->Node.SphericalLimitsData[SelectCollisionIndex])
-			: (GraphNode->Node.SphericalLimits[SelectCollisionIndex]);
+		FSphericalLimit* SphericalLimitRuntimePtr = static_cast<FSphericalLimit*>(GetSelectCollisionLimitRuntime());
+		FSphericalLimit* SphericalLimitGraphPtr = static_cast<FSphericalLimit*>(GetSelectCollisionLimitGraph());
+		if (!SphericalLimitRuntimePtr || !SphericalLimitGraphPtr)
+		{
+			return;
+		}
+		FSphericalLimit& SphericalLimitRuntime = *SphericalLimitRuntimePtr;
+		FSphericalLimit& SphericalLimitGraph = *SphericalLimitGraphPtr;
 
 		SphericalLimitRuntime.Radius += InScale.X;
 		SphericalLimitRuntime.Radius += InScale.Y;
@@ -684,6 +730,7 @@ void FKawaiiPhysicsEditMode::DoScale(FVector& InScale)
 		SphericalLimitRuntime.Radius = FMath::Max(SphericalLimitRuntime.Radius, 0.0f);
 		
 		SphericalLimitGraph.Radius = SphericalLimitRuntime.Radius;
+		RuntimeNode->NotifyLimitsChanged();
 
 		if (SelectCollisionIsFromDataAsset)
 		{
@@ -692,11 +739,14 @@ void FKawaiiPhysicsEditMode::DoScale(FVector& InScale)
 	}
 	else if (SelectCollisionType == ECollisionLimitType::Capsule)
 	{
-		FCapsuleLimit& CapsuleLimitRuntime = SelectCollisionIsFromDataAsset ? RuntimeNode->CapsuleLimitsData[SelectCollisionIndex]
-			: RuntimeNode->CapsuleLimits[SelectCollisionIndex];
-
-		FCapsuleLimit& CapsuleLimitGraph = SelectCollisionIsFromDataAsset ? GraphNode->Node.CapsuleLimitsData[SelectCollisionIndex]
-			: GraphNode->Node.CapsuleLimits[SelectCollisionIndex];
+		FCapsuleLimit* CapsuleLimitRuntimePtr = static_cast<FCapsuleLimit*>(GetSelectCollisionLimitRuntime());
+		FCapsuleLimit* CapsuleLimitGraphPtr = static_cast<FCapsuleLimit*>(GetSelectCollisionLimitGraph());
+		if (!CapsuleLimitRuntimePtr || !CapsuleLimitGraphPtr)
+		{
+			return;
+		}
+		FCapsuleLimit& CapsuleLimitRuntime = *CapsuleLimitRuntimePtr;
+		FCapsuleLimit& CapsuleLimitGraph = *CapsuleLimitGraphPtr;
 
 		CapsuleLimitRuntime.Radius += InScale.X;
 		CapsuleLimitRuntime.Radius += InScale.Y;
@@ -707,6 +757,7 @@ void FKawaiiPhysicsEditMode::DoScale(FVector& InScale)
 
 		CapsuleLimitGraph.Radius = CapsuleLimitRuntime.Radius;
 		CapsuleLimitGraph.Length = CapsuleLimitRuntime.Length;
+		RuntimeNode->NotifyLimitsChanged();
 
 		if (SelectCollisionIsFromDataAsset)
 		{
@@ -754,6 +805,9 @@ void FKawaiiPhysicsEditMode::DrawHUD(FEditorViewportClient* ViewportClient, FVie
 	case ECollisionLimitType::Planar:
 		CollisionDebugInfo.Append(FString(TEXT("Planar")));
 		break;
+	case ECollisionLimitType::SDF:
+		CollisionDebugInfo.Append(FString(TEXT("SDF")));
+		break;
 	default:
 		CollisionDebugInfo.Append(FString(TEXT("None")));
 		break;
@@ -771,12 +825,34 @@ void FKawaiiPhysicsEditMode::DrawHUD(FEditorViewportClient* ViewportClient, FVie
 		UDebugSkelMeshComponent* PreviewMeshComponent = GetAnimPreviewScene().GetPreviewMeshComponent();
 		if (PreviewMeshComponent != nullptr && PreviewMeshComponent->MeshObject != nullptr)
 		{
-			for (auto& Bone : RuntimeNode->ModifyBones)
+			// Text of all bones is unreadable and slow on long chains, so only the nearest bones in the view are drawn
+			const FKawaiiPhysicsDebugDrawView DrawView(View, PreviewMeshComponent->GetComponentTransform());
+			RuntimeNode->ReadDebugSnapshot([&](const FKawaiiPhysicsDebugSnapshot& Snapshot)
 			{
-				// Refer to FAnimationViewportClient::ShowBoneNames
-				const FVector BonePos = PreviewMeshComponent->GetComponentTransform().TransformPosition(Bone.Location);
-				Draw3DTextItem(FText::AsNumber(Bone.LengthFromRoot / RuntimeNode->GetTotalBoneLength()), Canvas, View, Viewport, BonePos );
-			}
+				TArray<TPair<float, int32>, TInlineAllocator<64>> VisibleBones;
+				for (int32 i = 0; i < Snapshot.Bones.Num(); ++i)
+				{
+					const FVector& Location = Snapshot.Bones[i].Location;
+					if (DrawView.IsVisible(Location, 0.0f))
+					{
+						VisibleBones.Emplace(DrawView.GetDistanceSquared(Location), i);
+					}
+				}
+				VisibleBones.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B)
+				{
+					return A.Key < B.Key;
+				});
+
+				const int32 NumBones = FMath::Min(VisibleBones.Num(), GraphNode->DebugBoneLengthRateMaxBones);
+				for (int32 i = 0; i < NumBones; ++i)
+				{
+					auto& Bone = Snapshot.Bones[VisibleBones[i].Value];
+
+					// Refer to FAnimationViewportClient::ShowBoneNames
+					const FVector BonePos = PreviewMeshComponent->GetComponentTransform().TransformPosition(Bone.Location);
+					Draw3DTextItem(FText::AsNumber(Bone.LengthRate), Canvas, View, Viewport, BonePos);
+				}
+			});
 		}
 	}
 
@@ -0,0 +1,24 @@
+// Copyright (c) 2019-2020 pafuhana1213. Licensed under the MIT License.
+
+
+#include "KawaiiPhysicsMicroBenchmarkCommandlet.h"
+#include "KawaiiPhysicsMicroBenchmark.h"
+
+UKawaiiPhysicsMicroBenchmarkCommandlet::UKawaiiPhysicsMicroBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UKawaiiPhysicsMicroBenchmarkCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	ParseCommandLine(*Params, Tokens, Switches);
+
+	// Arguments are accepted with or without the dash
+	Tokens.Append(Switches);
+	return FKawaiiPhysicsMicroBenchmark::Run(*GLog, Tokens) ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+// Copyright (c) 2019-2020 pafuhana1213. Licensed under the MIT License.
+
+
+#include "KawaiiPhysicsReplayCommandlet.h"
+#include "KawaiiPhysicsCapture.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogKawaiiPhysicsReplay, Log, All);
+
+UKawaiiPhysicsReplayCommandlet::UKawaiiPhysicsReplayCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UKawaiiPhysicsReplayCommandlet::Main(const FString& Params)
+{
+	FString Filename;
+	if (!FParse::Value(*Params, TEXT("File="), Filename))
+	{
+		UE_LOG(LogKawaiiPhysicsReplay, Error, TEXT("Usage: -run=KawaiiPhysicsReplay -File=Capture.kpcap [-Repeat=N] [-Output=Result.csv] [-Golden=Golden.csv] [-Tolerance=0.01]"));
+		return 1;
+	}
+
+	int32 NumRepeats = 1;
+	FParse::Value(*Params, TEXT("Repeat="), NumRepeats);
+	NumRepeats = FMath::Max(NumRepeats, 1);
+
+	FString OutputFilename;
+	FParse::Value(*Params, TEXT("Output="), OutputFilename);
+
+	FString GoldenFilename;
+	FParse::Value(*Params, TEXT("Golden="), GoldenFilename);
+
+	float Tolerance = 0.01f;
+	FParse::Value(*Params, TEXT("Tolerance="), Tolerance);
+
+	// Locations of all bones of all frames
+	FKawaiiPhysicsReplayResult Result;
+	int32 NumFrames = 0;
+	double TotalSeconds = 0.0;
+	double PeakFrameSeconds = 0.0;
+
+	for (int32 Repeat = 0; Repeat < NumRepeats; ++Repeat)
+	{
+		FKawaiiPhysicsCaptureReader Reader;
+		if (!Reader.Open(*Filename))
+		{
+			UE_LOG(LogKawaiiPhysicsReplay, Error, TEXT("Failed to open %s"), *Filename);
+			return 1;
+		}
+
+		FKawaiiPhysicsCaptureReplay Replay;
+		FKawaiiPhysicsCaptureFrame Frame;
+		while (Reader.ReadFrame(Frame))
+		{
+			const double StartSeconds = FPlatformTime::Seconds();
+			Replay.Step(Reader.GetSettings(), Frame);
+			const double FrameSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+			TotalSeconds += FrameSeconds;
+			PeakFrameSeconds = FMath::Max(PeakFrameSeconds, FrameSeconds);
+			++NumFrames;
+
+			// Results are identical in every repeat. Keep them once
+			if (Repeat == 0)
+			{
+				Result.AddFrame(Replay.GetLocations());
+			}
+		}
+	}
+
+	if (NumFrames == 0)
+	{
+		UE_LOG(LogKawaiiPhysicsReplay, Error, TEXT("No frames in %s"), *Filename);
+		return 1;
+	}
+
+	UE_LOG(LogKawaiiPhysicsReplay, Display, TEXT("%s: %d frames x %d repeats. Avg:%.2fus Peak:%.2fus Total:%.3fms"),
+		*Filename, NumFrames / NumRepeats, NumRepeats,
+		TotalSeconds * 1000000.0 / NumFrames, PeakFrameSeconds * 1000000.0, TotalSeconds * 1000.0);
+
+	if (!OutputFilename.IsEmpty())
+	{
+		if (!Result.SaveToFile(*OutputFilename))
+		{
+			UE_LOG(LogKawaiiPhysicsReplay, Error, TEXT("Failed to write %s"), *OutputFilename);
+			return 1;
+		}
+	}
+
+	if (!GoldenFilename.IsEmpty())
+	{
+		return CompareWithGolden(GoldenFilename, Result, Tolerance) ? 0 : 2;
+	}
+
+	return 0;
+}
+
+bool UKawaiiPhysicsReplayCommandlet::CompareWithGolden(const FString& GoldenFilename, const FKawaiiPhysicsReplayResult& Result, float Tolerance)
+{
+	if (Result.Num() == 0)
+	{
+		UE_LOG(LogKawaiiPhysicsReplay, Error, TEXT("No locations to compare with %s"), *GoldenFilename);
+		return false;
+	}
+
+	FKawaiiPhysicsReplayResult Golden;
+	if (!Golden.LoadFromFile(*GoldenFilename))
+	{
+		return false;
+	}
+
+	float MaxDeviation = 0.0f;
+	FIntPoint MaxDeviationFrameBone;
+	if (!Result.Compare(Golden, MaxDeviation, MaxDeviationFrameBone))
+	{
+		UE_LOG(LogKawaiiPhysicsReplay, Error, TEXT("%s has %d locations but the replay has %d, or their frames and bones differ"),
+			*GoldenFilename, Golden.Num(), Result.Num());
+		return false;
+	}
+
+	const bool bPassed = MaxDeviation <= Tolerance;
+	UE_LOG(LogKawaiiPhysicsReplay, Display, TEXT("%s: Max deviation %.6f at frame %d bone %d. Tolerance %.6f. %s"),
+		*GoldenFilename, MaxDeviation, MaxDeviationFrameBone.X, MaxDeviationFrameBone.Y, Tolerance, bPassed ? TEXT("Passed") : TEXT("Failed"));
+	return bPassed;
+}
@@ -0,0 +1,381 @@
+// Copyright (c) 2019-2020 pafuhana1213. Licensed under the MIT License.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Paths.h"
+#include "Interfaces/IPluginManager.h"
+#include "UObject/Package.h"
+#include "UObject/StrongObjectPtr.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "PhysicsEngine/SkeletalBodySetup.h"
+#include "AnimNode_KawaiiPhysics.h"
+#include "KawaiiPhysicsCapture.h"
+#include "KawaiiPhysicsSDFDataAsset.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Golden output tests of the simulation.
+ * Each scenario builds settings and frames in code, steps them through FKawaiiPhysicsCaptureReplay, which runs the
+ * simulation of FAnimNode_KawaiiPhysics, and compares the bone locations of every frame with Test/Golden/<Scenario>.csv
+ * of the plugin. Timing of each scenario is reported in the log.
+ * e.g. UE4Editor-Cmd Project -ExecCmds="Automation RunTests KawaiiPhysics.Golden;Quit" -unattended -nullrhi -nopause
+ * Add -KawaiiPhysicsUpdateGolden to rewrite the golden files after an intended change of the results.
+ * Test/Golden/GenerateGolden.py reimplements these scenarios outside the engine. See Test/Golden/README.md.
+ */
+namespace KawaiiPhysicsGoldenTest
+{
+	const int32 NumFrames = 120;
+	const int32 NumRepeats = 10;
+	const float Tolerance = 0.01f;
+
+	const TCHAR* const ScenarioNames[] =
+	{
+		TEXT("Chain"),
+		TEXT("Skirt"),
+		TEXT("DelayMode"),
+		TEXT("Wind"),
+		TEXT("SphereOuter"),
+		TEXT("SphereInner"),
+		TEXT("Capsule"),
+		TEXT("Plane"),
+		TEXT("SDF"),
+		TEXT("AngleLimit"),
+		TEXT("PlanarConstraint"),
+		TEXT("PhysicsAssetShapes"),
+		TEXT("PhysicsAssetLimits"),
+	};
+
+	struct FScenario
+	{
+		FKawaiiPhysicsCaptureSettings Settings;
+		/** Limits and input snapshot of every frame. Pose and transform are set per frame */
+		FKawaiiPhysicsCaptureFrame Frame;
+		TArray<FVector> PoseLocations;
+		/** Keep the assets made for the scenario until the replay ends */
+		TArray<TStrongObjectPtr<UObject>> Assets;
+	};
+
+	int32 AddBone(FScenario& Scenario, int32 ParentIndex, const FVector& PoseLocation)
+	{
+		const int32 BoneIndex = Scenario.Settings.Bones.Num();
+		FKawaiiPhysicsCaptureBone& Bone = Scenario.Settings.Bones.AddDefaulted_GetRef();
+		Bone.ParentIndex = ParentIndex;
+		Bone.BoneIndex = BoneIndex;
+		Bone.Damping = 0.1f;
+		Bone.WorldDampingLocation = 0.8f;
+		Bone.WorldDampingRotation = 0.8f;
+		Bone.Stiffness = 0.02f;
+		Bone.DelayAlpha = 0.5f;
+		Bone.Radius = 3.0f;
+		if (ParentIndex != INDEX_NONE)
+		{
+			Bone.LengthFromRoot = Scenario.Settings.Bones[ParentIndex].LengthFromRoot + (PoseLocation - Scenario.PoseLocations[ParentIndex]).Size();
+		}
+		Scenario.PoseLocations.Add(PoseLocation);
+		return BoneIndex;
+	}
+
+	/** Root and 6 bones along X */
+	void AddChain(FScenario& Scenario)
+	{
+		int32 ParentIndex = AddBone(Scenario, INDEX_NONE, FVector(0.0f, 0.0f, 100.0f));
+		for (int32 i = 1; i <= 6; ++i)
+		{
+			ParentIndex = AddBone(Scenario, ParentIndex, FVector(10.0f * i, 0.0f, 100.0f));
+		}
+	}
+
+	/** Root and 8 chains of 4 bones spreading downward around it */
+	void AddSkirt(FScenario& Scenario)
+	{
+		const int32 RootIndex = AddBone(Scenario, INDEX_NONE, FVector(0.0f, 0.0f, 100.0f));
+		for (int32 i = 0; i < 8; ++i)
+		{
+			float Sin, Cos;
+			FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(45.0f * i));
+			FVector Location(15.0f * Cos, 15.0f * Sin, 95.0f);
+			int32 ParentIndex = AddBone(Scenario, RootIndex, Location);
+			for (int32 j = 0; j < 3; ++j)
+			{
+				Location += FVector(5.0f * Cos, 5.0f * Sin, -10.0f);
+				ParentIndex = AddBone(Scenario, ParentIndex, Location);
+			}
+		}
+	}
+
+	UPhysicsAsset* NewPhysicsAsset(FScenario& Scenario)
+	{
+		// Transient objects are found by LoadObject of the replay with the path in the settings
+		UPhysicsAsset* PhysicsAsset = NewObject<UPhysicsAsset>(GetTransientPackage(),
+			MakeUniqueObjectName(GetTransientPackage(), UPhysicsAsset::StaticClass(), TEXT("KawaiiPhysicsGoldenTest")));
+		Scenario.Assets.Emplace(PhysicsAsset);
+		return PhysicsAsset;
+	}
+
+	USkeletalBodySetup* AddBody(UPhysicsAsset* PhysicsAsset)
+	{
+		USkeletalBodySetup* BodySetup = NewObject<USkeletalBodySetup>(PhysicsAsset);
+		PhysicsAsset->SkeletalBodySetups.Add(BodySetup);
+		return BodySetup;
+	}
+
+	/** Sphere of radius 12 at the origin */
+	UKawaiiPhysicsSDFDataAsset* NewSphereSDF(FScenario& Scenario)
+	{
+		UKawaiiPhysicsSDFDataAsset* SDF = NewObject<UKawaiiPhysicsSDFDataAsset>(GetTransientPackage(),
+			MakeUniqueObjectName(GetTransientPackage(), UKawaiiPhysicsSDFDataAsset::StaticClass(), TEXT("KawaiiPhysicsGoldenTest")));
+		SDF->BoundsMin = FVector(-20.0f);
+		SDF->CellSize = 2.5f;
+		SDF->Dimensions = FIntVector(17);
+		SDF->Distances.SetNumUninitialized(SDF->Dimensions.X * SDF->Dimensions.Y * SDF->Dimensions.Z);
+		for (int32 Z = 0; Z < SDF->Dimensions.Z; ++Z)
+		{
+			for (int32 Y = 0; Y < SDF->Dimensions.Y; ++Y)
+			{
+				for (int32 X = 0; X < SDF->Dimensions.X; ++X)
+				{
+					const FVector Location = SDF->BoundsMin + FVector(X, Y, Z) * SDF->CellSize;
+					SDF->Distances[X + (Y + Z * SDF->Dimensions.Y) * SDF->Dimensions.X] = Location.Size() - 12.0f;
+				}
+			}
+		}
+		Scenario.Assets.Emplace(SDF);
+		return SDF;
+	}
+
+	FKawaiiPhysicsCaptureSphere MakeSphere(const FVector& Location, float Radius, bool bInner)
+	{
+		FKawaiiPhysicsCaptureSphere Sphere;
+		Sphere.Location = Location;
+		Sphere.Radius = Radius;
+		Sphere.bInner = bInner;
+		return Sphere;
+	}
+
+	bool BuildScenario(const FString& Name, FScenario& Scenario)
+	{
+		FKawaiiPhysicsCaptureSettings& Settings = Scenario.Settings;
+		FKawaiiPhysicsCaptureFrame& Frame = Scenario.Frame;
+		Settings.TargetFramerate = 60;
+		Settings.Gravity = FVector(0.0f, 0.0f, -981.0f);
+		Settings.TeleportDistanceThreshold = 300.0f;
+		Settings.TeleportRotationThreshold = 10.0f;
+
+		if (Name == TEXT("Skirt"))
+		{
+			AddSkirt(Scenario);
+			Frame.Spheres.Add(MakeSphere(FVector(0.0f, 0.0f, 75.0f), 20.0f, false));
+			return true;
+		}
+
+		AddChain(Scenario);
+		if (Name == TEXT("Chain"))
+		{
+		}
+		else if (Name == TEXT("DelayMode"))
+		{
+			Settings.bUseDelayMode = true;
+			for (FKawaiiPhysicsCaptureBone& Bone : Settings.Bones)
+			{
+				Bone.DelayAlpha = 0.3f;
+			}
+		}
+		else if (Name == TEXT("Wind"))
+		{
+			Settings.bEnableWind = true;
+			Settings.WindScale = 1.5f;
+			Frame.WindVelocities.Init(FVector(0.0f, 0.5f, 0.0f), Settings.Bones.Num());
+		}
+		else if (Name == TEXT("SphereOuter"))
+		{
+			Frame.Spheres.Add(MakeSphere(FVector(30.0f, -5.0f, 80.0f), 8.0f, false));
+		}
+		else if (Name == TEXT("SphereInner"))
+		{
+			Frame.Spheres.Add(MakeSphere(FVector(35.0f, 0.0f, 85.0f), 25.0f, true));
+		}
+		else if (Name == TEXT("Capsule"))
+		{
+			FKawaiiPhysicsCaptureCapsule& Capsule = Frame.Capsules.AddDefaulted_GetRef();
+			Capsule.Location = FVector(30.0f, 0.0f, 94.0f);
+			Capsule.Rotation = FQuat(FVector::ForwardVector, HALF_PI);
+			Capsule.Radius = 5.0f;
+			Capsule.Length = 40.0f;
+		}
+		else if (Name == TEXT("Plane"))
+		{
+			FKawaiiPhysicsCapturePlane& Plane = Frame.Planes.AddDefaulted_GetRef();
+			Plane.Location = FVector(0.0f, 0.0f, 95.0f);
+		}
+		else if (Name == TEXT("SDF"))
+		{
+			Settings.SDFDataAssets.Add(NewSphereSDF(Scenario)->GetPathName());
+			Frame.SDFs.AddDefaulted_GetRef().Location = FVector(35.0f, 0.0f, 88.0f);
+		}
+		else if (Name == TEXT("AngleLimit"))
+		{
+			for (FKawaiiPhysicsCaptureBone& Bone : Settings.Bones)
+			{
+				Bone.LimitAngle = 15.0f;
+			}
+		}
+		else if (Name == TEXT("PlanarConstraint"))
+		{
+			Settings.PlanarConstraint = (uint8)EPlanarConstraint::Y;
+		}
+		else if (Name == TEXT("PhysicsAssetShapes"))
+		{
+			UPhysicsAsset* PhysicsAsset = NewPhysicsAsset(Scenario);
+			for (int32 i = 0; i < Settings.Bones.Num(); ++i)
+			{
+				AddBody(PhysicsAsset)->AggGeom.SphereElems.Add(FKSphereElem(4.0f));
+				Settings.Bones[i].PhysicsBodyIndex = i;
+			}
+			Settings.bUsePhysicsAssetAsShapes = true;
+			Settings.PhysicsAssetAsShapes = PhysicsAsset->GetPathName();
+			Frame.Spheres.Add(MakeSphere(FVector(30.0f, -5.0f, 80.0f), 8.0f, false));
+		}
+		else if (Name == TEXT("PhysicsAssetLimits"))
+		{
+			UPhysicsAsset* PhysicsAsset = NewPhysicsAsset(Scenario);
+			FKAggregateGeom& AggGeom = AddBody(PhysicsAsset)->AggGeom;
+			AggGeom.SphereElems.Add(FKSphereElem(8.0f));
+			FKSphylElem& Sphyl = AggGeom.SphylElems.Add_GetRef(FKSphylElem(5.0f, 20.0f));
+			Sphyl.Center = FVector(-15.0f, 0.0f, 0.0f);
+			Settings.bUsePhysicsAssetAsLimits = true;
+			Settings.PhysicsAssetAsLimits = PhysicsAsset->GetPathName();
+			Frame.LimitBodyBoneIndices.Add(0);
+			Frame.LimitBodyTransforms.Add(FTransform(FVector(35.0f, 0.0f, 88.0f)));
+		}
+		else
+		{
+			return false;
+		}
+		return true;
+	}
+
+	/** The component moves and turns a little, and the root bobs in component space */
+	void MakeFrames(const FScenario& Scenario, TArray<FKawaiiPhysicsCaptureFrame>& OutFrames)
+	{
+		OutFrames.SetNum(NumFrames);
+		for (int32 i = 0; i < NumFrames; ++i)
+		{
+			FKawaiiPhysicsCaptureFrame& Frame = OutFrames[i];
+			Frame = Scenario.Frame;
+			Frame.DeltaTime = 1.0f / 60.0f;
+			Frame.ComponentTransform = FTransform(
+				FQuat(FVector::UpVector, FMath::DegreesToRadians(5.0f * FMath::Sin(0.04f * i))),
+				FVector(10.0f * FMath::Sin(0.05f * i), 0.5f * i, 0.0f));
+			Frame.WindSeed = 12345 + i;
+			Frame.PoseLocations = Scenario.PoseLocations;
+			Frame.PoseLocations[0].Z += 2.0f * FMath::Sin(0.2f * i);
+			Frame.PoseRotations.Init(FQuat::Identity, Scenario.PoseLocations.Num());
+		}
+	}
+
+	FString GetGoldenFilename(const FString& Name)
+	{
+		TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("KawaiiPhysics"));
+		return FPaths::Combine(Plugin.IsValid() ? Plugin->GetBaseDir() : FPaths::ProjectPluginsDir() / TEXT("KawaiiPhysics"), TEXT("Test/Golden"), Name + TEXT(".csv"));
+	}
+}
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FKawaiiPhysicsGoldenTest, "KawaiiPhysics.Golden", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+void FKawaiiPhysicsGoldenTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	for (const TCHAR* Name : KawaiiPhysicsGoldenTest::ScenarioNames)
+	{
+		OutBeautifiedNames.Add(Name);
+		OutTestCommands.Add(Name);
+	}
+}
+
+bool FKawaiiPhysicsGoldenTest::RunTest(const FString& Parameters)
+{
+	using namespace KawaiiPhysicsGoldenTest;
+
+	FScenario Scenario;
+	if (!BuildScenario(Parameters, Scenario))
+	{
+		AddError(FString::Printf(TEXT("Unknown scenario %s"), *Parameters));
+		return false;
+	}
+
+	TArray<FKawaiiPhysicsCaptureFrame> Frames;
+	MakeFrames(Scenario, Frames);
+
+	// Locations of all bones of all frames. Identical in every repeat, so keep them once
+	const int32 NumBones = Scenario.Settings.Bones.Num();
+	FKawaiiPhysicsReplayResult Result;
+	double TotalSeconds = 0.0;
+	double PeakFrameSeconds = 0.0;
+	for (int32 Repeat = 0; Repeat < NumRepeats; ++Repeat)
+	{
+		FKawaiiPhysicsCaptureReplay Replay;
+		for (const FKawaiiPhysicsCaptureFrame& Frame : Frames)
+		{
+			const double StartSeconds = FPlatformTime::Seconds();
+			Replay.Step(Scenario.Settings, Frame);
+			const double FrameSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+			TotalSeconds += FrameSeconds;
+			PeakFrameSeconds = FMath::Max(PeakFrameSeconds, FrameSeconds);
+
+			if (Repeat == 0)
+			{
+				Result.AddFrame(Replay.GetLocations());
+			}
+		}
+	}
+
+	AddInfo(FString::Printf(TEXT("%s: %d bones, %d frames x %d repeats. Avg:%.2fus Peak:%.2fus"), *Parameters, NumBones, NumFrames, NumRepeats,
+		TotalSeconds * 1000000.0 / (NumFrames * NumRepeats), PeakFrameSeconds * 1000000.0));
+
+	if (!TestEqual(TEXT("Simulated locations"), Result.Num(), NumFrames * NumBones))
+	{
+		return false;
+	}
+
+	const FString GoldenFilename = GetGoldenFilename(Parameters);
+	if (FParse::Param(FCommandLine::Get(), TEXT("KawaiiPhysicsUpdateGolden")))
+	{
+		if (!Result.SaveToFile(*GoldenFilename))
+		{
+			AddError(FString::Printf(TEXT("Failed to write %s"), *GoldenFilename));
+			return false;
+		}
+		AddWarning(FString::Printf(TEXT("Updated %s"), *GoldenFilename));
+		return true;
+	}
+
+	FKawaiiPhysicsReplayResult Golden;
+	if (!Golden.LoadFromFile(*GoldenFilename))
+	{
+		AddError(FString::Printf(TEXT("Failed to read %s"), *GoldenFilename));
+		return false;
+	}
+
+	float MaxDeviation = 0.0f;
+	FIntPoint MaxDeviationFrameBone;
+	if (!Result.Compare(Golden, MaxDeviation, MaxDeviationFrameBone))
+	{
+		AddError(FString::Printf(TEXT("%s has %d locations but the scenario has %d, or their frames and bones differ"),
+			*GoldenFilename, Golden.Num(), Result.Num()));
+		return false;
+	}
+
+	AddInfo(FString::Printf(TEXT("%s: Max deviation %.6f at frame %d bone %d. Tolerance %.6f"), *Parameters,
+		MaxDeviation, MaxDeviationFrameBone.X, MaxDeviationFrameBone.Y, Tolerance));
+	if (MaxDeviation > Tolerance)
+	{
+		AddError(FString::Printf(TEXT("%s deviates from %s by %.6f at frame %d bone %d"), *Parameters, *GoldenFilename,
+			MaxDeviation, MaxDeviationFrameBone.X, MaxDeviationFrameBone.Y));
+		return false;
+	}
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -21,6 +21,9 @@ class UAnimGraphNode_KawaiiPhysics : public UAnimGraphNode_SkeletalControlBase
 	bool bEnableDebugDrawBone = true;
 	UPROPERTY(EditAnywhere, Category = Debug)
 	bool bEnableDebugBoneLengthRate= true;
+	/** Bone length rate is drawn for this number of bones nearest to the camera */
+	UPROPERTY(EditAnywhere, Category = Debug, meta = (EditCondition = "bEnableDebugBoneLengthRate", ClampMin = "0"))
+	int32 DebugBoneLengthRateMaxBones = 32;
 	UPROPERTY(EditAnywhere, Category = Debug)
 	bool bEnableDebugDrawAngleLimit = true;
 	UPROPERTY(EditAnywhere, Category = Debug)
@@ -30,6 +33,8 @@ class UAnimGraphNode_KawaiiPhysics : public UAnimGraphNode_SkeletalControlBase
 	UPROPERTY(EditAnywhere, Category = Debug)
 	bool bEnableDebugDrawPlanerLimit = true;
 	UPROPERTY(EditAnywhere, Category = Debug)
+	bool bEnableDebugDrawSDFLimit = true;
+	UPROPERTY(EditAnywhere, Category = Debug)
 	bool bEnableDebugDrawPhysicsAssetAsShape = true;
 	UPROPERTY(EditAnywhere, Category = Debug)
 	bool bEnableDebugDrawPhysicsAssetAsLimit = true;
@@ -39,6 +44,7 @@ public:
 
 	// UObject interface
 	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
+	virtual void PostEditChangeChainProperty(struct FPropertyChangedChainEvent& PropertyChangedEvent) override;
 
 protected:
 
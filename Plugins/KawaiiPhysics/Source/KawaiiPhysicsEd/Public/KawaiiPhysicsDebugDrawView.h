@@ -0,0 +1,30 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FSceneView;
+
+/**
+ * Culling and level of detail of debug drawing in the editor viewport.
+ * Locations are in component space. Without a view everything is drawn at full detail
+ */
+class FKawaiiPhysicsDebugDrawView
+{
+public:
+	FKawaiiPhysicsDebugDrawView(const FSceneView* InView, const FTransform& InComponentTransform);
+
+	/** Whether a shape in the bounding sphere is in the view frustum and not smaller than a few pixels */
+	bool IsVisible(const FVector& Location, float Radius) const;
+
+	/** Number of sides of a wire shape in the bounding sphere. MaxSides when it fills a half of the screen */
+	int32 GetNumSides(const FVector& Location, float Radius, int32 MaxSides) const;
+
+	/** Squared distance from the view origin. 0 without a view */
+	float GetDistanceSquared(const FVector& Location) const;
+
+private:
+	float GetScreenSize(const FVector& WorldLocation, float Radius) const;
+
+	const FSceneView* View;
+	FTransform ComponentTransform;
+};
@@ -6,10 +6,13 @@
 #include "AnimNodeEditMode.h"
 #include "AnimGraphNode_KawaiiPhysics.h"
 #include "AnimNode_KawaiiPhysics.h"
+#include "KawaiiPhysicsDebugDrawView.h"
+#include "KawaiiPhysicsBodyBoneIndexCache.h"
 
 class FEditorViewportClient;
 class FPrimitiveDrawInterface;
 class USkeletalMeshComponent;
+class UPhysicsAsset;
 struct FViewportClick;
 
 
@@ -45,12 +48,15 @@ protected:
 
 private:
 
-	/** Render each collisions */
-	void RenderSphericalLimits(FPrimitiveDrawInterface* PDI);
-	void RenderCapsuleLimit(FPrimitiveDrawInterface* PDI);
-	void RenderPlanerLimit(FPrimitiveDrawInterface* PDI);
-	void RenderPhysicsAssetAsShape(FPrimitiveDrawInterface* PDI, const USkeletalMeshComponent* SkeletalMeshComp);
-	void RenderPhysicsAssetAsLimit(FPrimitiveDrawInterface* PDI, const USkeletalMeshComponent* SkeletalMeshComp);
+	/** Render each collisions. Simulated values are read from the debug snapshot of the node */
+	void RenderSphericalLimits(FPrimitiveDrawInterface* PDI, const FKawaiiPhysicsDebugDrawView& DrawView, const FKawaiiPhysicsDebugSnapshot& Snapshot);
+	void RenderCapsuleLimit(FPrimitiveDrawInterface* PDI, const FKawaiiPhysicsDebugDrawView& DrawView, const FKawaiiPhysicsDebugSnapshot& Snapshot);
+	void RenderPlanerLimit(FPrimitiveDrawInterface* PDI, const FKawaiiPhysicsDebugDrawView& DrawView, const FKawaiiPhysicsDebugSnapshot& Snapshot);
+	void RenderSDFLimit(FPrimitiveDrawInterface* PDI, const FKawaiiPhysicsDebugDrawView& DrawView, const FKawaiiPhysicsDebugSnapshot& Snapshot);
+	void RenderPhysicsAssetAsShape(FPrimitiveDrawInterface* PDI, const FKawaiiPhysicsDebugDrawView& DrawView, const USkeletalMeshComponent* SkeletalMeshComp);
+	void RenderPhysicsAssetAsLimit(FPrimitiveDrawInterface* PDI, const FKawaiiPhysicsDebugDrawView& DrawView, const USkeletalMeshComponent* SkeletalMeshComp);
+	void RenderPhysicsAssetBodies(FPrimitiveDrawInterface* PDI, const FKawaiiPhysicsDebugDrawView& DrawView,
+		const UPhysicsAsset* PhysicsAsset, const TArray<int32>& BoneIndices, const USkeletalMeshComponent* SkeletalMeshComp);
 
 	/** Helper funciton for GetWidgetLocation() and joint rendering */
 	FVector GetWidgetLocation(ECollisionLimitType CollisionType, int Index) const;
@@ -78,6 +84,15 @@ private:
 	int SelectCollisionIndex = -1;
 	bool SelectCollisionIsFromDataAsset;
 
+	/** Copy of the selected limit of the data asset. Edits are written back to the data asset */
+	mutable FSphericalLimit SelectSphericalLimitData;
+	mutable FCapsuleLimit SelectCapsuleLimitData;
+	mutable FPlanarLimit SelectPlanarLimitData;
+
 	// storing current widget mode 
 	mutable FWidget::EWidgetMode CurWidgetMode;
+
+	/** Mesh bone indices of the bodies of the physics assets */
+	FKawaiiPhysicsBodyBoneIndexCache PhysicsAssetAsShapesBoneIndices;
+	FKawaiiPhysicsBodyBoneIndexCache UsePhysicsAssetAsLimitsBoneIndices;
 };
\ No newline at end of file
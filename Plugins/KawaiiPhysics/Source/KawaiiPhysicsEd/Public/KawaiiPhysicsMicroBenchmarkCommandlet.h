@@ -0,0 +1,25 @@
+// Copyright (c) 2019-2020 pafuhana1213. Licensed under the MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "KawaiiPhysicsMicroBenchmarkCommandlet.generated.h"
+
+/**
+ * Runs the micro benchmarks of KawaiiPhysics.MicroBenchmark without a world.
+ * e.g. UE4Editor-Cmd Project -run=KawaiiPhysicsMicroBenchmark [-Bones=32] [-Colliders=1,4,16,64] [-Iterations=100] [-Runs=5] [-Baseline=<csv>] [-Threshold=10] [-SaveBaseline]
+ * Returns 1 if an entry regressed from the stored baseline by more than Threshold percent
+ */
+UCLASS()
+class UKawaiiPhysicsMicroBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UKawaiiPhysicsMicroBenchmarkCommandlet();
+
+	// UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	// End of UCommandlet interface
+};
@@ -0,0 +1,31 @@
+// Copyright (c) 2019-2020 pafuhana1213. Licensed under the MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "KawaiiPhysicsReplayCommandlet.generated.h"
+
+class FKawaiiPhysicsReplayResult;
+
+/**
+ * Replays a capture of p.KawaiiPhysics.CaptureDirectory through the simulation of the node and reports the cost.
+ * e.g. UE4Editor-Cmd Project -run=KawaiiPhysicsReplay -File=Capture.kpcap [-Repeat=10] [-Output=Result.csv] [-Golden=Golden.csv -Tolerance=0.01]
+ * Output writes the simulated bone locations of every frame. Golden compares them with a file written by Output
+ * and fails if the max deviation exceeds Tolerance. Use it to check that simulation changes give the same result
+ */
+UCLASS()
+class UKawaiiPhysicsReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UKawaiiPhysicsReplayCommandlet();
+
+	// UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	// End of UCommandlet interface
+
+private:
+	bool CompareWithGolden(const FString& GoldenFilename, const FKawaiiPhysicsReplayResult& Result, float Tolerance);
+};
@@ -0,0 +1,292 @@
+# Copyright (c) 2019-2020 pafuhana1213. Licensed under the MIT License.
+"""
+Generates the golden files of the KawaiiPhysics.Golden automation test without the engine.
+
+A float64 reimplementation of FAnimNode_KawaiiPhysics::SimulateModifyBones for the scenarios built in
+KawaiiPhysicsGoldenTest.cpp (bone layout, frames, wind seed, colliders). Keep both in sync when either changes.
+
+  python3 GenerateGolden.py <OutputDir>   Writes <Scenario>.csv in the format of FKawaiiPhysicsReplayResult
+  python3 GenerateGolden.py compare       Prints the max deviation of a float32 run from the float64 one
+
+Requires numpy. See README.md next to this file.
+"""
+import math, sys
+import numpy as np
+
+# Float type of the simulation. np.float64 for the golden files, np.float32 to estimate the deviation of the engine
+F = None
+
+def V(x,y,z): return np.array([x,y,z],dtype=F)
+def size(v): return F(math.sqrt(float(np.dot(v,v))))
+def sizesq(v): return F(np.dot(v,v))
+def safe_normal(v):
+    s=sizesq(v)
+    if s==1: return v.copy()
+    if s<1e-8: return V(0,0,0)
+    return (v*F(1.0/math.sqrt(float(s)))).astype(F)
+
+def rot_z(deg, v):
+    r=math.radians(deg); c=math.cos(r); s=math.sin(r)
+    return V(c*v[0]-s*v[1], s*v[0]+c*v[1], v[2])
+
+def rotate_angle_axis(v, deg, axis):
+    s=math.sin(math.radians(deg)); c=math.cos(math.radians(deg))
+    X,Y,Z=[float(a) for a in axis]
+    XX,YY,ZZ,XY,YZ,ZX=X*X,Y*Y,Z*Z,X*Y,Y*Z,Z*X
+    XS,YS,ZS=X*s,Y*s,Z*s
+    O=1-c
+    x,y,z=[float(a) for a in v]
+    return V((O*XX+c)*x+(O*XY-ZS)*y+(O*ZX+YS)*z,
+             (O*XY+ZS)*x+(O*YY+c)*y+(O*YZ-XS)*z,
+             (O*ZX-YS)*x+(O*YZ+XS)*y+(O*ZZ+c)*z)
+
+def find_between_rotate(a, b, v):
+    # FQuat::FindBetweenVectors(a,b) applied to v
+    norm_ab=math.sqrt(float(sizesq(a))*float(sizesq(b)))
+    w=norm_ab+float(np.dot(a,b))
+    if w>=1e-6*norm_ab:
+        q=[a[1]*b[2]-a[2]*b[1], a[2]*b[0]-a[0]*b[2], a[0]*b[1]-a[1]*b[0], w]
+    else:
+        w=0.0
+        q=[-a[2],0.0,a[0],w] if abs(a[0])>abs(a[1]) else [0.0,-a[2],a[1],w]
+    n=math.sqrt(sum(float(x)*float(x) for x in q)); q=[float(x)/n for x in q]
+    qv=np.array(q[:3]); qw=q[3]; vv=np.array([float(x) for x in v])
+    t=2*np.cross(qv,vv)
+    r=vv+qw*t+np.cross(qv,t)
+    return V(*r)
+
+def plane_project(p, origin, normal):
+    w=float(np.dot(origin,normal))
+    d=float(np.dot(p,normal))-w
+    return (p-F(d)*normal).astype(F)
+
+def segment_plane(start, end, origin, normal):
+    w=float(np.dot(origin,normal))
+    se=end-start
+    dot=float(np.dot(normal,se))
+    if abs(dot)<=1e-8: return False
+    t=(w-float(np.dot(start,normal)))/dot
+    return 0.0<=t<=1.0
+
+def closest_on_segment(p,a,b):
+    seg=b-a; vp=p-a
+    d1=float(np.dot(seg,vp))
+    if d1<=0: return a.copy()
+    d2=float(np.dot(seg,seg))
+    if d2<=d1: return b.copy()
+    return (a+seg*F(d1/d2)).astype(F)
+
+def push_out_sphere(loc, r, c, R):
+    L=r+R
+    if sizesq(loc-c)>L*L: return loc
+    return (loc+F(L-size(loc-c))*safe_normal(loc-c)).astype(F)
+
+def push_in_sphere(loc, r, c, R):
+    L=r+R
+    if sizesq(loc-c)<L*L: return loc
+    return (c+F(R-r)*safe_normal(loc-c)).astype(F)
+
+def push_out_capsule(loc, r, a, b, R):
+    L=r+R
+    cp=closest_on_segment(loc,a,b)
+    if sizesq(loc-cp)>=L*L: return loc
+    return (cp+safe_normal(loc-cp)*F(L)).astype(F)
+
+def push_out_plane(loc, prev, r, origin, normal):
+    p=plane_project(loc, origin, normal)
+    if sizesq(loc-p)>=r*r and not segment_plane(loc, prev, origin, normal): return loc
+    return (p+normal*F(r)).astype(F)
+
+def sdf_sample(sdf, p):
+    bmin, cell, dim, dist = sdf
+    g=(p-bmin)/F(cell)
+    if g[0]<0 or g[1]<0 or g[2]<0 or g[0]>dim-1 or g[1]>dim-1 or g[2]>dim-1: return None, None
+    X=min(int(math.floor(g[0])),dim-2);Y=min(int(math.floor(g[1])),dim-2);Z=min(int(math.floor(g[2])),dim-2)
+    tx,ty,tz=g[0]-X,g[1]-Y,g[2]-Z
+    D=lambda x,y,z: dist(X+x,Y+y,Z+z)
+    D000,D100,D010,D110,D001,D101,D011,D111=D(0,0,0),D(1,0,0),D(0,1,0),D(1,1,0),D(0,0,1),D(1,0,1),D(0,1,1),D(1,1,1)
+    lerp=lambda a,b,t: a+(b-a)*t
+    D00=lerp(D000,D100,tx);D10=lerp(D010,D110,tx);D01=lerp(D001,D101,tx);D11=lerp(D011,D111,tx)
+    D0=lerp(D00,D10,ty);D1=lerp(D01,D11,ty)
+    gx=lerp(lerp(D100-D000,D110-D010,ty),lerp(D101-D001,D111-D011,ty),tz)
+    gy=lerp(lerp(D010-D000,D110-D100,tx),lerp(D011-D001,D111-D101,tx),tz)
+    gz=D1-D0
+    grad=V(gx,gy,gz)/F(cell)
+    assert sizesq(grad)>1e-8
+    return F(lerp(D0,D1,tz)), grad
+
+def box_push(loc, r, center, half):
+    local=loc-center
+    clamped=np.minimum(np.maximum(local,-half),half)
+    d=local-clamped; ds=sizesq(d)
+    if ds>=r*r: return loc
+    if ds>1e-8:
+        dd=math.sqrt(float(ds)); return (loc+d*F((r-dd)/dd)).astype(F)
+    raise Exception("inside box")
+
+# FRandomStream, used for the wind of each frame
+class Rand:
+    def __init__(self, seed): self.seed=seed & 0xffffffff
+    def frand(self):
+        self.seed=(self.seed*196314165+907633515)&0xffffffff
+        bits=0x3F800000|(self.seed>>9)
+        return float(np.frombuffer(np.uint32(bits).tobytes(),dtype=np.float32)[0])-1.0
+    def frand_range(self,a,b): return a+(b-a)*self.frand()
+
+# FAnimNode_KawaiiPhysics::SimulateModifyBones for a FKawaiiPhysicsCaptureReplay of the frames of KawaiiPhysicsGoldenTest::MakeFrames
+def simulate(sc):
+    bones=sc['bones']; n=len(bones)
+    dt=F(1.0/60.0); frames=sc['frames']
+    out=[]
+    loc=prev=None; pre_tm=None; dt_old=None
+    for f in range(frames):
+        yaw=5.0*math.sin(0.04*f)
+        cl=V(10.0*math.sin(0.05*f), 0.5*f, 0.0)
+        pose=[b['pose'].copy() for b in bones]
+        pose[0]=pose[0]+V(0,0,2.0*math.sin(0.2*f))
+        if loc is None:
+            loc=[p.copy() for p in pose]; prev=[p.copy() for p in pose]
+            pre_tm=(yaw,cl); dt_old=F(1.0/60)
+        # UpdateSkelCompMove
+        move=rot_z(-yaw, pre_tm[1]-cl)
+        move_yaw=pre_tm[0]-yaw
+        if sizesq(move)>300*300: move=V(0,0,0)
+        if abs(move_yaw)>10: move_yaw=0.0
+        pre_tm=(yaw,cl)
+        grav=rot_z(-yaw, V(0,0,-981.0))*F(0.5)*dt*dt
+        rnd=Rand(12345+f)
+        for i,b in enumerate(bones):
+            if b['parent']<0:
+                prev[i]=loc[i]; loc[i]=pose[i]; continue
+            p=b['parent']; pb=bones[p]
+            if sc.get('delay'):
+                prev[i]=loc[i]
+                if pb['parent']<0:
+                    target=pose[i]
+                else:
+                    g=pb['parent']
+                    target=loc[p]+find_between_rotate(pose[p]-pose[g], pose[i]-pose[p], safe_normal(loc[p]-loc[g]))*size(pose[i]-pose[p])
+                loc[i]=(prev[i]+(target-prev[i])*F(b['delay'])).astype(F)
+            else:
+                wind=V(0,0,0)
+                if 'wind' in sc:
+                    wind=sc['wind']*F(sc['windscale'])
+                    wind=wind*F(rnd.frand_range(0.0,2.0))*F(60)
+                base=loc[p]+(pose[i]-pose[p])
+                vel=(loc[i]-prev[i])/dt_old*F(1.0-b['damping'])+wind
+                nl=loc[i]+vel*dt
+                nl=nl+move*F(1.0-b['wdl'])
+                nl=nl+(rot_z(move_yaw, loc[i])-loc[i])*F(1.0-b['wdr'])
+                nl=nl+grav
+                nl=nl+(base-nl)*F(1.0-math.pow(1.0-b['stiffness'],60*float(dt)))
+                prev[i]=loc[i]; loc[i]=nl.astype(F)
+            r=F(b['radius'])
+            L=loc[i]
+            # collisions
+            for s in sc.get('spheres',[]):
+                if sc.get('shapes'):
+                    R=F(sc['shapes'])
+                else:
+                    R=r
+                if s['inner']:
+                    L=push_in_sphere(L,R,s['loc'],F(s['radius']))
+                else:
+                    L=push_out_sphere(L,R,s['loc'],F(s['radius']))
+            for c in sc.get('capsules',[]):
+                a=c['loc']+c['axis']*F(c['length']*0.5); e=c['loc']-c['axis']*F(c['length']*0.5)
+                L=push_out_capsule(L,r,a,e,F(c['radius']))
+            for pl in sc.get('planes',[]):
+                L=push_out_plane(L,prev[i],r,pl['loc'],pl['normal'])
+            for s in sc.get('sdfs',[]):
+                d,g=sdf_sample(s['sdf'], L-s['loc'])
+                if d is not None and d<r:
+                    L=(L+safe_normal(g)*F(r-d)).astype(F)
+            if 'body' in sc:
+                bl=sc['body']
+                for e in bl['spheres']:
+                    L=push_out_sphere(L,r,bl['loc']+e[0],F(e[1]))
+                for e in bl['sphyls']:
+                    c=bl['loc']+e[0]; a=c+V(0,0,e[2]*0.5); z=c-V(0,0,e[2]*0.5)
+                    L=push_out_capsule(L,r,a,z,F(e[1]))
+            loc[i]=L
+            # constraints
+            if b['limitangle']!=0:
+                bd=safe_normal(loc[i]-loc[p]); pd=safe_normal(pose[i]-pose[p])
+                ax=np.cross(pd,bd).astype(F)
+                ang=math.atan2(float(size(ax)), float(np.dot(pd,bd)))
+                over=math.degrees(ang)-b['limitangle']
+                if over>0:
+                    bd=rotate_angle_axis(bd,-over,ax)
+                    loc[i]=(bd*size(loc[i]-loc[p])+loc[p]).astype(F)
+            if sc.get('planar')=='Y':
+                loc[i]=plane_project(loc[i], loc[p], V(0,1,0))
+            bl_=size(pose[i]-pose[p])
+            loc[i]=(safe_normal(loc[i]-loc[p])*bl_+loc[p]).astype(F)
+        dt_old=dt
+        for i in range(n): out.append((f,i,loc[i].copy()))
+    return out
+
+def bone(parent, pose, length_from_root, **kw):
+    b=dict(parent=parent,pose=pose,lfr=length_from_root,damping=0.1,wdl=0.8,wdr=0.8,stiffness=0.02,radius=3.0,limitangle=0.0,delay=0.5)
+    b.update(kw); return b
+
+def chain(**kw):
+    bs=[bone(-1,V(0,0,100),0.0)]
+    for k in range(1,7):
+        bs.append(bone(k-1,V(10.0*k,0,100),10.0*k,**kw))
+    return bs
+
+def skirt():
+    bs=[bone(-1,V(0,0,100),0.0)]
+    for c in range(8):
+        a=math.radians(45.0*c); ca=math.cos(a); sa=math.sin(a)
+        p=V(15*ca,15*sa,95.0); parent=0; lfr=size(p-bs[0]['pose'])
+        bs.append(bone(parent,p,lfr)); parent=len(bs)-1
+        for k in range(3):
+            q=bs[parent]['pose']+V(5*ca,5*sa,-10.0)
+            lfr+=size(q-bs[parent]['pose'])
+            bs.append(bone(parent,q,lfr)); parent=len(bs)-1
+    return bs
+
+# KawaiiPhysicsGoldenTest::BuildScenario
+def scenarios():
+    S={}
+    S['Chain']=dict(bones=chain())
+    S['Skirt']=dict(bones=skirt(),spheres=[dict(loc=V(0,0,75),radius=20.0,inner=False)])
+    S['DelayMode']=dict(bones=chain(delay=0.3),delay=True)
+    S['Wind']=dict(bones=chain(),wind=V(0,0.5,0),windscale=1.5)
+    S['SphereOuter']=dict(bones=chain(),spheres=[dict(loc=V(30,-5,80),radius=8.0,inner=False)])
+    S['SphereInner']=dict(bones=chain(),spheres=[dict(loc=V(35,0,85),radius=25.0,inner=True)])
+    S['Capsule']=dict(bones=chain(),capsules=[dict(loc=V(30,0,94),axis=V(0,-1,0),radius=5.0,length=40.0)])
+    S['Plane']=dict(bones=chain(),planes=[dict(loc=V(0,0,95),normal=V(0,0,1))])
+    dim=17; cell=2.5; bmin=V(-20,-20,-20)
+    dist=lambda x,y,z: F(math.sqrt((-20+x*cell)**2+(-20+y*cell)**2+(-20+z*cell)**2)-12.0)
+    S['SDF']=dict(bones=chain(),sdfs=[dict(loc=V(35,0,88),sdf=(bmin,cell,dim,dist))])
+    S['AngleLimit']=dict(bones=chain(limitangle=15.0))
+    S['PlanarConstraint']=dict(bones=chain(),planar='Y')
+    S['PhysicsAssetShapes']=dict(bones=chain(),spheres=[dict(loc=V(30,-5,80),radius=8.0,inner=False)],shapes=4.0)
+    S['PhysicsAssetLimits']=dict(bones=chain(),body=dict(loc=V(35,0,88),spheres=[(V(0,0,0),8.0)],sphyls=[(V(-15,0,0),5.0,20.0)]))
+    for s in S.values(): s['frames']=120
+    return S
+
+if __name__=='__main__':
+    if len(sys.argv)!=2:
+        sys.exit(__doc__)
+    mode=sys.argv[1]
+    if mode=='compare':
+        res={}
+        for t in (np.float64,np.float32):
+            F=t; res[t]={k:simulate(v) for k,v in scenarios().items()}
+        for k in res[np.float64]:
+            a=res[np.float64][k]; b=res[np.float32][k]
+            dev=max(float(np.linalg.norm(x[2].astype(np.float64)-y[2].astype(np.float64))) for x,y in zip(a,b))
+            print(k, 'maxdev f32 vs f64: %.6f'%dev)
+    else:
+        F=np.float64
+        import os
+        os.makedirs(mode,exist_ok=True)
+        for k,v in scenarios().items():
+            r=simulate(v)
+            with open(os.path.join(mode,k+'.csv'),'w',newline='\n') as fp:
+                fp.write('Frame,Bone,X,Y,Z\n')
+                for f,i,l in r: fp.write('%d,%d,%.6f,%.6f,%.6f\n'%(f,i,l[0],l[1],l[2]))
@@ -0,0 +1,252 @@
+#include "KawaiiPhysicsBenchmark.h"
+#include "AnimNode_KawaiiPhysics.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#if !UE_BUILD_SHIPPING
+
+DEFINE_LOG_CATEGORY_STATIC(LogKawaiiPhysicsBenchmark, Log, All);
+
+namespace
+{
+	const TCHAR* GrayChanClassPath = TEXT("/Game/KawaiiPhysicsSample/GrayChan/BP_GrayChan.BP_GrayChan_C");
+	const TCHAR* ChainClassPath = TEXT("/Game/KawaiiPhysicsSample/Chain/BP_Chain.BP_Chain_C");
+
+	const float InstanceSpacing = 200.0f;
+	const float PathRadius = 100.0f;
+	// Time of one round of the path
+	const float PathSeconds = 4.0f;
+	const float CameraDistance = 2000.0f;
+	const float CameraHeight = 500.0f;
+
+	TUniquePtr<FKawaiiPhysicsBenchmark> GBenchmark;
+
+	FAutoConsoleCommandWithWorldAndArgs GBenchmarkCommand(
+		TEXT("KawaiiPhysics.Benchmark"),
+		TEXT("Spawns BP_GrayChan and BP_Chain and writes the cost of KawaiiPhysics for each instance count to CSV. ")
+		TEXT("Args: Counts=1,10,50,100,200,500 GrayChanRatio=0.5 MeasureSeconds=5 WarmupSeconds=1 Output=File.csv Quit"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			if (GBenchmark.IsValid() && !GBenchmark->IsFinished())
+			{
+				UE_LOG(LogKawaiiPhysicsBenchmark, Warning, TEXT("Benchmark is already running"));
+				return;
+			}
+			GBenchmark = MakeUnique<FKawaiiPhysicsBenchmark>(World, Args);
+		}));
+}
+
+FKawaiiPhysicsBenchmark::FKawaiiPhysicsBenchmark(UWorld* InWorld, const TArray<FString>& Args)
+	: World(InWorld)
+{
+	Counts = { 1, 10, 50, 100, 200, 500 };
+	OutputFilename = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("KawaiiPhysicsBenchmark.csv"));
+
+	for (const FString& Arg : Args)
+	{
+		FString CountsValue;
+		if (FParse::Value(*Arg, TEXT("Counts="), CountsValue, false))
+		{
+			TArray<FString> CountStrings;
+			CountsValue.ParseIntoArray(CountStrings, TEXT(","));
+			Counts.Reset();
+			for (const FString& CountString : CountStrings)
+			{
+				Counts.Add(FMath::Max(FCString::Atoi(*CountString), 1));
+			}
+		}
+		FParse::Value(*Arg, TEXT("GrayChanRatio="), GrayChanRatio);
+		FParse::Value(*Arg, TEXT("MeasureSeconds="), MeasureSeconds);
+		FParse::Value(*Arg, TEXT("WarmupSeconds="), WarmupSeconds);
+		FParse::Value(*Arg, TEXT("Output="), OutputFilename);
+		if (Arg == TEXT("Quit"))
+		{
+			bQuitWhenFinished = true;
+		}
+	}
+	GrayChanRatio = FMath::Clamp(GrayChanRatio, 0.0f, 1.0f);
+
+	GrayChanClass.Reset(LoadClass<AActor>(nullptr, GrayChanClassPath));
+	ChainClass.Reset(LoadClass<AActor>(nullptr, ChainClassPath));
+	if (!GrayChanClass.IsValid() || !ChainClass.IsValid() || Counts.Num() == 0)
+	{
+		UE_LOG(LogKawaiiPhysicsBenchmark, Error, TEXT("Failed to start benchmark. Check %s and %s"), GrayChanClassPath, ChainClassPath);
+		bFinished = true;
+	}
+}
+
+bool FKawaiiPhysicsBenchmark::IsTickable() const
+{
+	return !bFinished;
+}
+
+TStatId FKawaiiPhysicsBenchmark::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(FKawaiiPhysicsBenchmark, STATGROUP_Tickables);
+}
+
+void FKawaiiPhysicsBenchmark::Tick(float DeltaTime)
+{
+	if (!World.IsValid())
+	{
+		Finish();
+		return;
+	}
+
+	if (CountIndex == INDEX_NONE)
+	{
+		CountIndex = 0;
+		SpawnInstances(Counts[CountIndex]);
+	}
+
+	StepTime += DeltaTime;
+	PathTime += DeltaTime;
+	MoveInstancesAndCamera();
+
+	if (StepTime > WarmupSeconds)
+	{
+		++NumMeasuredFrames;
+		FrameMilliseconds += DeltaTime * 1000.0;
+		GameThreadMilliseconds += FPlatformTime::ToMilliseconds(GGameThreadTime);
+	}
+
+	if (StepTime >= WarmupSeconds + MeasureSeconds)
+	{
+		AddResultRow();
+		DestroyInstances();
+
+		if (++CountIndex < Counts.Num())
+		{
+			SpawnInstances(Counts[CountIndex]);
+		}
+		else
+		{
+			Finish();
+		}
+	}
+}
+
+void FKawaiiPhysicsBenchmark::SpawnInstances(int32 NumInstances)
+{
+	UWorld* CurrentWorld = World.Get();
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	// Square grid around the origin. GrayChan and Chain are interleaved by the ratio
+	const int32 NumColumns = FMath::CeilToInt(FMath::Sqrt((float)NumInstances));
+	NumGrayChan = 0;
+	for (int32 i = 0; i < NumInstances; ++i)
+	{
+		const FVector Origin(
+			(i % NumColumns - NumColumns * 0.5f) * InstanceSpacing,
+			(i / NumColumns - NumColumns * 0.5f) * InstanceSpacing,
+			0.0f);
+		const bool bGrayChan = FMath::FloorToInt((i + 1) * GrayChanRatio) > FMath::FloorToInt(i * GrayChanRatio);
+		NumGrayChan += bGrayChan ? 1 : 0;
+
+		AActor* Instance = CurrentWorld->SpawnActor<AActor>(bGrayChan ? GrayChanClass.Get() : ChainClass.Get(), Origin, FRotator::ZeroRotator, SpawnParameters);
+		if (Instance)
+		{
+			Instances.Add(Instance);
+			InstanceOrigins.Add(Origin);
+		}
+	}
+
+	StepTime = 0.0f;
+	NumMeasuredFrames = 0;
+	FrameMilliseconds = 0.0;
+	GameThreadMilliseconds = 0.0;
+}
+
+void FKawaiiPhysicsBenchmark::DestroyInstances()
+{
+	for (const TWeakObjectPtr<AActor>& Instance : Instances)
+	{
+		if (Instance.IsValid())
+		{
+			Instance->Destroy();
+		}
+	}
+	Instances.Reset();
+	InstanceOrigins.Reset();
+}
+
+void FKawaiiPhysicsBenchmark::MoveInstancesAndCamera()
+{
+	const float Angle = 2.0f * PI * PathTime / PathSeconds;
+
+	// Each instance runs on a circle with a different phase so that the physics keeps moving
+	for (int32 i = 0; i < Instances.Num(); ++i)
+	{
+		if (AActor* Instance = Instances[i].Get())
+		{
+			const float InstanceAngle = Angle + i;
+			const FVector Location = InstanceOrigins[i] + FVector(FMath::Cos(InstanceAngle), FMath::Sin(InstanceAngle), 0.0f) * PathRadius;
+			Instance->SetActorLocationAndRotation(Location, FRotator(0.0f, FMath::RadiansToDegrees(InstanceAngle) + 90.0f, 0.0f));
+		}
+	}
+
+	// Camera orbits the crowd slowly
+	APlayerController* PlayerController = World->GetFirstPlayerController();
+	if (PlayerController && PlayerController->GetPawn())
+	{
+		const float CameraAngle = Angle * 0.25f;
+		const FVector CameraLocation(FMath::Cos(CameraAngle) * CameraDistance, FMath::Sin(CameraAngle) * CameraDistance, CameraHeight);
+		PlayerController->GetPawn()->SetActorLocation(CameraLocation);
+		PlayerController->SetControlRotation((-CameraLocation).Rotation());
+	}
+}
+
+void FKawaiiPhysicsBenchmark::AddResultRow()
+{
+	TArray<float> AverageCosts;
+	TArray<float> PeakCosts;
+	FAnimNode_KawaiiPhysics::GatherDebugCosts(AverageCosts, PeakCosts);
+
+	float TotalCost = 0.0f;
+	float PeakCost = 0.0f;
+	for (int32 i = 0; i < AverageCosts.Num(); ++i)
+	{
+		TotalCost += AverageCosts[i];
+		PeakCost = FMath::Max(PeakCost, PeakCosts[i]);
+	}
+
+	const int32 NumInstances = Counts[CountIndex];
+	const int32 NumFrames = FMath::Max(NumMeasuredFrames, 1);
+	Output += FString::Printf(TEXT("%d,%d,%d,%d,%.3f,%.3f,%d,%.1f,%.2f,%.1f\n"),
+		NumInstances, NumGrayChan, NumInstances - NumGrayChan, FTaskGraphInterface::Get().GetNumWorkerThreads(),
+		FrameMilliseconds / NumFrames, GameThreadMilliseconds / NumFrames,
+		AverageCosts.Num(), TotalCost, TotalCost / NumInstances, PeakCost);
+
+	UE_LOG(LogKawaiiPhysicsBenchmark, Display, TEXT("%d instances: KawaiiPhysics %.1fus per frame, %.2fus per instance"), NumInstances, TotalCost, TotalCost / NumInstances);
+}
+
+void FKawaiiPhysicsBenchmark::Finish()
+{
+	DestroyInstances();
+	bFinished = true;
+
+	const FString Header = TEXT("Instances,GrayChan,Chain,WorkerThreads,FrameMs,GameThreadMs,Nodes,KawaiiPhysicsTotalUs,PerInstanceUs,PeakNodeUs\n");
+	if (FFileHelper::SaveStringToFile(Header + Output, *OutputFilename))
+	{
+		UE_LOG(LogKawaiiPhysicsBenchmark, Display, TEXT("Benchmark result is written to %s"), *OutputFilename);
+	}
+	else
+	{
+		UE_LOG(LogKawaiiPhysicsBenchmark, Error, TEXT("Failed to write %s"), *OutputFilename);
+	}
+
+	if (bQuitWhenFinished)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+#endif
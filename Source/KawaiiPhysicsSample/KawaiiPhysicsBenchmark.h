@@ -0,0 +1,68 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "UObject/StrongObjectPtr.h"
+
+class UWorld;
+class AActor;
+
+/**
+ * Scaling benchmark of KawaiiPhysics. Spawns BP_GrayChan and BP_Chain in the current map, moves them and the camera
+ * along a circle and writes the cost of each instance count to a CSV file.
+ *
+ * KawaiiPhysics.Benchmark [Counts=1,10,50,100,200,500] [GrayChanRatio=0.5] [MeasureSeconds=5] [WarmupSeconds=1] [Output=File.csv] [Quit]
+ *
+ * e.g. UE4Editor KawaiiPhysicsSample -game -nullrhi -ExecCmds="KawaiiPhysics.Benchmark Quit"
+ * Launch once per worker thread configuration. The number of worker threads is written in every row
+ */
+class FKawaiiPhysicsBenchmark : public FTickableGameObject
+{
+public:
+	FKawaiiPhysicsBenchmark(UWorld* InWorld, const TArray<FString>& Args);
+
+	bool IsFinished() const
+	{
+		return bFinished;
+	}
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+private:
+	void SpawnInstances(int32 NumInstances);
+	void DestroyInstances();
+	void MoveInstancesAndCamera();
+	void AddResultRow();
+	void Finish();
+
+	TWeakObjectPtr<UWorld> World;
+	TArray<TWeakObjectPtr<AActor>> Instances;
+	TArray<FVector> InstanceOrigins;
+
+	TArray<int32> Counts;
+	float GrayChanRatio = 0.5f;
+	float MeasureSeconds = 5.0f;
+	float WarmupSeconds = 1.0f;
+	FString OutputFilename;
+	bool bQuitWhenFinished = false;
+
+	TStrongObjectPtr<UClass> GrayChanClass;
+	TStrongObjectPtr<UClass> ChainClass;
+
+	int32 CountIndex = INDEX_NONE;
+	int32 NumGrayChan = 0;
+	float StepTime = 0.0f;
+	float PathTime = 0.0f;
+
+	// Accumulated in the measurement of the current step
+	int32 NumMeasuredFrames = 0;
+	double FrameMilliseconds = 0.0;
+	double GameThreadMilliseconds = 0.0;
+
+	FString Output;
+	bool bFinished = false;
+};